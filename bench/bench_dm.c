@@ -0,0 +1,271 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file bench_dm.c
+ *
+ * Harness for benchmarks which run plugin code against a real XPON DM. See
+ * bench_dm.h.
+ */
+
+/* Related header */
+#include "bench_dm.h"
+
+/* System headers */
+#include <stdio.h> /* printf() */
+#include <time.h>  /* clock_gettime() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxp/amxp.h>
+#include <amxd/amxd_dm.h>
+#include <amxo/amxo.h>
+
+/* Own headers */
+#include "ani_pm.h"       /* ani_pm_cleanup() */
+#include "data_model.h"   /* dm_add_instance() */
+#include "dm_coalesce.h"  /* dm_coalesce_init() */
+#include "dm_info.h"      /* dm_info_init() */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_dm() */
+
+#ifndef ODL_DIR
+#define ODL_DIR "../odl"
+#endif
+
+/* Functions of the plugin the odl files refer to */
+amxd_status_t _read_trx_param(amxd_object_t* object, amxd_param_t* param,
+                              amxd_action_t reason, const amxc_var_t* const args,
+                              amxc_var_t* const retval, void* priv);
+amxd_status_t _read_trx_window_param(amxd_object_t* object, amxd_param_t* param,
+                                     amxd_action_t reason, const amxc_var_t* const args,
+                                     amxc_var_t* const retval, void* priv);
+amxd_status_t _read_coalesced_param(amxd_object_t* object, amxd_param_t* param,
+                                    amxd_action_t reason, const amxc_var_t* const args,
+                                    amxc_var_t* const retval, void* priv);
+amxd_status_t _coalescing_stats_on_read(amxd_object_t* object, amxd_param_t* param,
+                                        amxd_action_t reason, const amxc_var_t* const args,
+                                        amxc_var_t* const retval, void* priv);
+amxd_status_t _trx_cache_stats_on_read(amxd_object_t* object, amxd_param_t* param,
+                                       amxd_action_t reason, const amxc_var_t* const args,
+                                       amxc_var_t* const retval, void* priv);
+amxd_status_t _call_stats_on_read(amxd_object_t* object, amxd_param_t* param,
+                                  amxd_action_t reason, const amxc_var_t* const args,
+                                  amxc_var_t* const retval, void* priv);
+amxd_status_t _Reset(amxd_object_t* object, amxd_function_t* func,
+                     amxc_var_t* args, amxc_var_t* ret);
+amxd_status_t _lastchange_on_read(amxd_object_t* const object, amxd_param_t* const param,
+                                  amxd_action_t reason, const amxc_var_t* const args,
+                                  amxc_var_t* const retval, void* priv);
+amxd_status_t _status_history_on_read(amxd_object_t* const object, amxd_param_t* const param,
+                                      amxd_action_t reason, const amxc_var_t* const args,
+                                      amxc_var_t* const retval, void* priv);
+amxd_status_t _interface_object_destroyed(amxd_object_t* object, amxd_param_t* param,
+                                          amxd_action_t reason, const amxc_var_t* const args,
+                                          amxc_var_t* const retval, void* priv);
+amxd_status_t _trx_destroyed(amxd_object_t* object, amxd_param_t* param,
+                             amxd_action_t reason, const amxc_var_t* const args,
+                             amxc_var_t* const retval, void* priv);
+amxd_status_t _pulled_object_destroyed(amxd_object_t* object, amxd_param_t* param,
+                                       amxd_action_t reason, const amxc_var_t* const args,
+                                       amxc_var_t* const retval, void* priv);
+amxd_status_t _check_password(amxd_object_t* object, amxd_param_t* param,
+                              amxd_action_t reason, const amxc_var_t* const args,
+                              amxc_var_t* const retval, void* priv);
+void _onu_enable_changed(const char* const event_name, const amxc_var_t* const event_data,
+                         void* const priv);
+void _ani_enable_changed(const char* const event_name, const amxc_var_t* const event_data,
+                         void* const priv);
+void _interface_object_added(const char* const event_name, const amxc_var_t* const event_data,
+                             void* const priv);
+void _status_changed(const char* const event_name, const amxc_var_t* const event_data,
+                     void* const priv);
+void _trx_thresholds_changed(const char* const event_name, const amxc_var_t* const event_data,
+                             void* const priv);
+void _password_changed(const char* const event_name, const amxc_var_t* const event_data,
+                       void* const priv);
+
+typedef struct _bench_func {
+    const char* name;
+    amxo_fn_ptr_t fn;
+} bench_func_t;
+
+static const bench_func_t FUNCTIONS[] = {
+    { .name = "read_trx_param", .fn = AMXO_FUNC(_read_trx_param) },
+    { .name = "read_trx_window_param", .fn = AMXO_FUNC(_read_trx_window_param) },
+    { .name = "read_coalesced_param", .fn = AMXO_FUNC(_read_coalesced_param) },
+    { .name = "coalescing_stats_on_read", .fn = AMXO_FUNC(_coalescing_stats_on_read) },
+    { .name = "trx_cache_stats_on_read", .fn = AMXO_FUNC(_trx_cache_stats_on_read) },
+    { .name = "call_stats_on_read", .fn = AMXO_FUNC(_call_stats_on_read) },
+    { .name = "Reset", .fn = AMXO_FUNC(_Reset) },
+    { .name = "lastchange_on_read", .fn = AMXO_FUNC(_lastchange_on_read) },
+    { .name = "status_history_on_read", .fn = AMXO_FUNC(_status_history_on_read) },
+    { .name = "interface_object_destroyed", .fn = AMXO_FUNC(_interface_object_destroyed) },
+    { .name = "trx_destroyed", .fn = AMXO_FUNC(_trx_destroyed) },
+    { .name = "pulled_object_destroyed", .fn = AMXO_FUNC(_pulled_object_destroyed) },
+    { .name = "check_password", .fn = AMXO_FUNC(_check_password) },
+    { .name = "onu_enable_changed", .fn = AMXO_FUNC(_onu_enable_changed) },
+    { .name = "ani_enable_changed", .fn = AMXO_FUNC(_ani_enable_changed) },
+    { .name = "interface_object_added", .fn = AMXO_FUNC(_interface_object_added) },
+    { .name = "status_changed", .fn = AMXO_FUNC(_status_changed) },
+    { .name = "trx_thresholds_changed", .fn = AMXO_FUNC(_trx_thresholds_changed) },
+    { .name = "password_changed", .fn = AMXO_FUNC(_password_changed) },
+    { .name = NULL, .fn = NULL } /* sentinel */
+};
+
+static amxd_dm_t s_dm;
+static amxo_parser_t s_parser;
+
+amxd_dm_t* PRIVATE xpon_mngr_get_dm(void) {
+    return &s_dm;
+}
+
+amxo_parser_t* PRIVATE xpon_mngr_get_parser(void) {
+    return &s_parser;
+}
+
+uint32_t PRIVATE xpon_mngr_get_max_nr_of_onus(void) {
+    return MAX_NR_OF_ONUS;
+}
+
+/**
+ * Load the odl files of the plugin in an in-process DM.
+ *
+ * The odl files must be generated first: make -C odl
+ *
+ * @return true on success, else false
+ */
+bool bench_dm_init(void) {
+
+    bool rv = false;
+    uint32_t i;
+
+    amxd_dm_init(&s_dm);
+    amxo_parser_init(&s_parser);
+
+    for(i = 0; FUNCTIONS[i].name != NULL; ++i) {
+        amxo_resolver_ftab_add(&s_parser, FUNCTIONS[i].name, FUNCTIONS[i].fn);
+    }
+
+    amxd_object_t* const root = amxd_dm_get_root(&s_dm);
+    if(amxo_parser_parse_file(&s_parser, ODL_DIR "/tr181-xpon_definition.odl", root) != 0) {
+        printf("Failed to load odl files: %s\n", amxo_parser_get_message(&s_parser));
+        goto exit;
+    }
+    bench_dm_handle_events();
+
+    when_false(dm_info_init(), exit);
+    when_false(dm_info_sync_param_types(&s_dm), exit);
+    when_false(dm_coalesce_init(), exit);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+void bench_dm_cleanup(void) {
+    dm_coalesce_cleanup();
+    ani_pm_cleanup();
+    amxo_resolver_import_close_all();
+    amxo_parser_clean(&s_parser);
+    amxd_dm_clean(&s_dm);
+}
+
+void bench_dm_set_config_bool(const char* name, bool value) {
+    amxc_var_t var;
+    amxc_var_init(&var);
+    amxc_var_set(bool, &var, value);
+    amxo_parser_set_config(&s_parser, name, &var);
+    amxc_var_clean(&var);
+}
+
+/**
+ * Handle the events the DM emitted, as the event loop of amxrt would do.
+ */
+void bench_dm_handle_events(void) {
+    while(amxp_signal_read() == 0) {
+    }
+}
+
+/**
+ * Add an instance via dm_add_instance(), as if the vendor module asked so.
+ *
+ * @return true on success, else false
+ */
+bool bench_dm_add_instance(const char* path, uint32_t index, const char* key_name,
+                           const char* key_value) {
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", path);
+    amxc_var_add_key(uint32_t, &args, "index", index);
+    amxc_var_t* const keys = amxc_var_add_key(amxc_htable_t, &args, "keys", NULL);
+    amxc_var_add_key(cstring_t, keys, key_name, key_value);
+    const int rc = dm_add_instance(&args);
+    amxc_var_clean(&args);
+    return (0 == rc);
+}
+
+double bench_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + ((double) ts.tv_nsec / 1e9);
+}
@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file bench_dm_info.c
+ *
+ * Micro-benchmark for dm_get_object_id().
+ *
+ * It compares the trie based dm_get_object_id() in src/dm_info.c with the
+ * implementation it replaced, which converted the path to a generic path
+ * with amxc string functions before comparing it with each generic path in
+ * OBJECT_INFO. The old implementation is copied below as
+ * legacy_get_object_id().
+ *
+ * Usage: bench_dm_info [iterations]
+ */
+
+/* System headers */
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* strtoul() */
+#include <string.h> /* strlen(), strncmp() */
+#include <time.h>   /* clock_gettime() */
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/* Own headers */
+#include "dm_info.h"
+
+#define DEFAULT_ITERATIONS 1000000
+
+/* Paths as the plugin typically passes them to dm_get_object_id() */
+static const char* const PATHS[] = {
+    "XPON.ONU.1",
+    "XPON.ONU.1.SoftwareImage",
+    "XPON.ONU.1.EthernetUNI.1",
+    "XPON.ONU.1.ANI.1",
+    "XPON.ONU.1.ANI.1.TC.GEM.Port",
+    "XPON.ONU.1.ANI.1.TC.GEM.Port.1025",
+    "XPON.ONU.1.ANI.1.Transceiver.1",
+    "XPON.ONU.1.ANI.1.TC.ONUActivation",
+    "XPON.ONU.1.ANI.1.TC.Alarms",
+    "XPON.ONU.1.ANI.1.TC.PM.PHY"
+};
+
+#define N_PATHS (sizeof(PATHS) / sizeof(PATHS[0]))
+
+static object_id_t legacy_get_object_id(const char* path) {
+
+    object_id_t id = obj_id_unknown;
+    amxc_llist_t list;
+    amxc_string_t input;
+    amxc_string_t generic_path_str;
+
+    amxc_llist_init(&list);
+    amxc_string_init(&input, 0);
+    amxc_string_init(&generic_path_str, 0);
+    amxc_string_set(&input, path);
+
+    if(AMXC_STRING_SPLIT_OK != amxc_string_split_to_llist(&input, &list, '.')) {
+        goto exit;
+    }
+
+    amxc_llist_it_t* last_it = amxc_llist_get_last(&list);
+    if(!last_it) {
+        goto exit;
+    }
+    if(amxc_string_is_numeric(amxc_string_from_llist_it(last_it))) {
+        amxc_llist_take_last(&list);
+        amxc_string_list_it_free(last_it);
+    }
+
+    amxc_llist_iterate(it, &list) {
+        amxc_string_t* part = amxc_string_from_llist_it(it);
+        if(amxc_string_is_numeric(part)) {
+            amxc_string_set(part, "x");
+        }
+    }
+
+    if(amxc_string_join_llist(&generic_path_str, &list, '.') != 0) {
+        goto exit;
+    }
+
+    const char* const generic_path = amxc_string_get(&generic_path_str, 0);
+    const size_t generic_path_len = strlen(generic_path);
+
+    uint32_t i;
+    size_t len;
+    const object_info_t* info;
+    for(i = 0; i < obj_id_nbr; ++i) {
+        info = dm_get_object_info((object_id_t) i);
+        len = strlen(info->generic_path);
+        if((generic_path_len == len) &&
+           (strncmp(generic_path, info->generic_path, len) == 0)) {
+            id = info->id;
+            break;
+        }
+    }
+
+exit:
+    amxc_llist_clean(&list, amxc_string_list_it_free);
+    amxc_string_clean(&input);
+    amxc_string_clean(&generic_path_str);
+    return id;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + ((double) ts.tv_nsec / 1e9);
+}
+
+static void run(const char* name, object_id_t (* func)(const char*),
+                unsigned long iterations) {
+
+    unsigned long i;
+    unsigned long sum = 0;
+    const double start = now_s();
+    for(i = 0; i < iterations; ++i) {
+        sum += (unsigned long) func(PATHS[i % N_PATHS]);
+    }
+    const double elapsed = now_s() - start;
+    printf("%-24s %10lu calls %8.3f s %14.0f calls/s (checksum %lu)\n",
+           name, iterations, elapsed, (double) iterations / elapsed, sum);
+}
+
+int main(int argc, char* argv[]) {
+
+    const unsigned long iterations = (argc > 1) ?
+        strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    size_t i;
+
+    if(!dm_info_init()) {
+        printf("dm_info_init() failed\n");
+        return 1;
+    }
+
+    for(i = 0; i < N_PATHS; ++i) {
+        if(dm_get_object_id(PATHS[i]) != legacy_get_object_id(PATHS[i])) {
+            printf("Mismatch for '%s'\n", PATHS[i]);
+            return 1;
+        }
+    }
+
+    run("legacy_get_object_id", legacy_get_object_id, iterations);
+    run("dm_get_object_id", dm_get_object_id, iterations);
+    return 0;
+}
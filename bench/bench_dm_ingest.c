@@ -0,0 +1,345 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file bench_dm_ingest.c
+ *
+ * Benchmark for the functions which write the updates of the vendor module to
+ * the DM.
+ *
+ * It creates XPON.ONU.1 with 2 EthernetUNI instances and one ANI, and calls
+ * each function below in a tight loop:
+ * - dm_get_object_id(): for the paths the plugin typically passes to it
+ * - dm_add_instance(): adds a GEM port per call
+ * - dm_change_object(): changes Direction of a GEM port per call
+ * - dm_change_object(): passes only an unknown param per call. It must not
+ *   build a transaction: the allocations per call should be close to 0.
+ * - dm_add_or_change_instance_impl(): changes PortType of a GEM port per call
+ * - dm_omci_reset_mib(): resets the ONU with 64 GEM ports per call
+ *
+ * For each function it reports the calls per second and the heap allocations
+ * per call, counted by bench_alloc.c. The events the calls emit are handled
+ * after each loop, outside the measurement.
+ *
+ * Usage: bench_dm_ingest [nr_of_gem_ports]
+ */
+
+/* System headers */
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* strtoul() */
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/* Own headers */
+#include "bench_alloc.h"
+#include "bench_dm.h"
+#include "data_model.h" /* dm_add_instance() */
+#include "dm_info.h"    /* dm_get_object_id() */
+
+#define DEFAULT_NR_OF_GEM_PORTS 4096
+#define MAX_NR_OF_GEM_PORTS 65534
+#define NR_OF_RESETS 100
+#define GEM_PORTS_PER_RESET 64
+#define GEM_PORT_PATH "XPON.ONU.1.ANI.1.TC.GEM.Port"
+
+/* Paths as the plugin typically passes them to dm_get_object_id() */
+static const char* const PATHS[] = {
+    "XPON.ONU.1",
+    "XPON.ONU.1.EthernetUNI.1",
+    "XPON.ONU.1.ANI.1",
+    "XPON.ONU.1.ANI.1.TC.GEM.Port",
+    "XPON.ONU.1.ANI.1.TC.GEM.Port.1025",
+    "XPON.ONU.1.ANI.1.Transceiver.1",
+    "XPON.ONU.1.ANI.1.TC.Alarms",
+    "XPON.ONU.1.ANI.1.TC.PM.PHY"
+};
+
+#define N_PATHS (sizeof(PATHS) / sizeof(PATHS[0]))
+
+/**
+ * Start and result of a measurement.
+ *
+ * - start_s       start time
+ * - start_allocs  allocation count at the start
+ * - seconds       total time measured
+ * - allocs        total allocations measured
+ */
+typedef struct _measurement {
+    double start_s;
+    uint64_t start_allocs;
+    double seconds;
+    uint64_t allocs;
+} measurement_t;
+
+static void measure_start(measurement_t* const m) {
+    m->start_allocs = bench_alloc_count();
+    m->start_s = bench_now_s();
+}
+
+static void measure_stop(measurement_t* const m) {
+    const double stop_s = bench_now_s();
+    m->allocs += bench_alloc_count() - m->start_allocs;
+    m->seconds += stop_s - m->start_s;
+}
+
+static void report(const char* const name, uint32_t ops, uint32_t failed,
+                   const measurement_t* const m) {
+    printf("%-32s %7u ops %12.0f ops/s %10.1f allocs/op", name, ops,
+           (m->seconds > 0) ? ops / m->seconds : 0, (double) m->allocs / ops);
+    if(failed) {
+        printf(" (%u failed)", failed);
+    }
+    printf("\n");
+}
+
+/**
+ * Set 'index', and the key PortID if 'args' has keys, to 'index'.
+ *
+ * Overwriting a uint32_t variant does not allocate: the loops below reuse
+ * their args, such that only the allocations of the plugin are counted.
+ */
+static void set_index(amxc_var_t* const args, uint32_t index) {
+    amxc_var_set(uint32_t, GET_ARG(args, "index"), index);
+    amxc_var_t* const keys = GET_ARG(args, "keys");
+    if(keys) {
+        amxc_var_set(uint32_t, GET_ARG(keys, "PortID"), index);
+    }
+}
+
+/**
+ * Build the args for the GEM port with index 1.
+ *
+ * @param[in] keys   add the key PortID if true
+ * @param[in] name   name of a param to add. NULL to add no params.
+ * @param[in] value  value of the param
+ */
+static void build_args(amxc_var_t* const args, bool keys, const char* const name,
+                       const char* const value) {
+    amxc_var_set_type(args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, args, "path", GEM_PORT_PATH);
+    amxc_var_add_key(uint32_t, args, "index", 1);
+    if(keys) {
+        amxc_var_t* const key_args = amxc_var_add_key(amxc_htable_t, args, "keys", NULL);
+        amxc_var_add_key(uint32_t, key_args, "PortID", 1);
+    }
+    if(name) {
+        amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, args, "parameters", NULL);
+        amxc_var_add_key(cstring_t, params, name, value);
+    }
+}
+
+static void bench_get_object_id(uint32_t n_ops) {
+    measurement_t m = { 0 };
+    uint32_t failed = 0;
+
+    measure_start(&m);
+    for(uint32_t i = 0; i < n_ops; ++i) {
+        if(dm_get_object_id(PATHS[i % N_PATHS]) == obj_id_unknown) {
+            ++failed;
+        }
+    }
+    measure_stop(&m);
+    report("dm_get_object_id", n_ops, failed, &m);
+}
+
+static void bench_add_instance(uint32_t n_gem_ports) {
+    measurement_t m = { 0 };
+    uint32_t failed = 0;
+    amxc_var_t args;
+    amxc_var_init(&args);
+    build_args(&args, true, NULL, NULL);
+
+    measure_start(&m);
+    for(uint32_t i = 1; i <= n_gem_ports; ++i) {
+        set_index(&args, i);
+        if(dm_add_instance(&args) != 0) {
+            ++failed;
+        }
+    }
+    measure_stop(&m);
+    bench_dm_handle_events();
+    report("dm_add_instance", n_gem_ports, failed, &m);
+    amxc_var_clean(&args);
+}
+
+/**
+ * Call 'fn' twice for each GEM port: first with 'value_a', then with
+ * 'value_b', for the param 'name'. 'value_a' must differ from the default
+ * value, such that each call changes the DM.
+ */
+static void bench_change(const char* const fn_name,
+                         int (* fn)(const amxc_var_t* const args),
+                         uint32_t n_gem_ports, bool keys, const char* const name,
+                         const char* const value_a, const char* const value_b) {
+    measurement_t m = { 0 };
+    uint32_t failed = 0;
+    amxc_var_t args_a;
+    amxc_var_t args_b;
+    amxc_var_init(&args_a);
+    amxc_var_init(&args_b);
+    build_args(&args_a, keys, name, value_a);
+    build_args(&args_b, keys, name, value_b);
+
+    measure_start(&m);
+    for(uint32_t round = 0; round < 2; ++round) {
+        amxc_var_t* const args = round ? &args_b : &args_a;
+        for(uint32_t i = 1; i <= n_gem_ports; ++i) {
+            set_index(args, i);
+            if(fn(args) != 0) {
+                ++failed;
+            }
+        }
+    }
+    measure_stop(&m);
+    bench_dm_handle_events();
+    report(fn_name, 2 * n_gem_ports, failed, &m);
+    amxc_var_clean(&args_a);
+    amxc_var_clean(&args_b);
+}
+
+static bool add_gem_ports(uint32_t n_gem_ports) {
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const ops = amxc_var_add_key(amxc_llist_t, &args, "operations", NULL);
+    for(uint32_t i = 1; i <= n_gem_ports; ++i) {
+        amxc_var_t* const op = amxc_var_add(amxc_htable_t, ops, NULL);
+        amxc_var_add_key(cstring_t, op, "action", "add");
+        amxc_var_add_key(cstring_t, op, "path", GEM_PORT_PATH);
+        amxc_var_add_key(uint32_t, op, "index", i);
+        amxc_var_t* const keys = amxc_var_add_key(amxc_htable_t, op, "keys", NULL);
+        amxc_var_add_key(uint32_t, keys, "PortID", i);
+    }
+    const int rc = dm_apply_batch_impl(&args, NULL);
+    amxc_var_clean(&args);
+    bench_dm_handle_events();
+    return (0 == rc);
+}
+
+static void bench_omci_reset_mib(void) {
+    measurement_t m = { 0 };
+    uint32_t failed = 0;
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(uint32_t, &args, "index", 1);
+
+    /* Remove the GEM ports of the previous benchmarks */
+    dm_omci_reset_mib(&args);
+    bench_dm_handle_events();
+
+    for(uint32_t i = 0; i < NR_OF_RESETS; ++i) {
+        if(!add_gem_ports(GEM_PORTS_PER_RESET)) {
+            ++failed;
+        }
+        measure_start(&m);
+        if(dm_omci_reset_mib(&args) != 0) {
+            ++failed;
+        }
+        measure_stop(&m);
+        bench_dm_handle_events();
+    }
+    report("dm_omci_reset_mib (64 GEM ports)", NR_OF_RESETS, failed, &m);
+    amxc_var_clean(&args);
+}
+
+int main(int argc, char* argv[]) {
+
+    int rc = 1;
+    uint32_t n_gem_ports = (argc > 1) ?
+        (uint32_t) strtoul(argv[1], NULL, 10) : DEFAULT_NR_OF_GEM_PORTS;
+    if((0 == n_gem_ports) || (n_gem_ports > MAX_NR_OF_GEM_PORTS)) {
+        printf("nr_of_gem_ports must be in [1, %d]\n", MAX_NR_OF_GEM_PORTS);
+        goto exit;
+    }
+
+    if(!bench_dm_init()) {
+        printf("Failed to initialize DM\n");
+        goto exit;
+    }
+
+    if(!bench_dm_add_instance("XPON.ONU", 1, "Name", "ONU1") ||
+       !bench_dm_add_instance("XPON.ONU.1.EthernetUNI", 1, "Name", "UNI1") ||
+       !bench_dm_add_instance("XPON.ONU.1.EthernetUNI", 2, "Name", "UNI2") ||
+       !bench_dm_add_instance("XPON.ONU.1.ANI", 1, "Name", "ANI1")) {
+        printf("Failed to create ONU\n");
+        goto exit_cleanup;
+    }
+    bench_dm_handle_events();
+
+    bench_get_object_id(100 * n_gem_ports);
+    bench_add_instance(n_gem_ports);
+    bench_change("dm_change_object", dm_change_object, n_gem_ports, false,
+                 "Direction", "ANI-to-UNI", "UNI-to-ANI");
+    bench_change("dm_change_object (unknown)", dm_change_object, n_gem_ports, false,
+                 "NoSuchParam", "a", "b");
+    bench_change("dm_add_or_change_instance_impl", dm_add_or_change_instance_impl,
+                 n_gem_ports, true, "PortType", "multicast", "unicast");
+    bench_omci_reset_mib();
+    rc = 0;
+
+exit_cleanup:
+    bench_dm_cleanup();
+exit:
+    return rc;
+}
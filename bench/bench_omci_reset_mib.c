@@ -0,0 +1,190 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file bench_omci_reset_mib.c
+ *
+ * Benchmark for dm_omci_reset_mib().
+ *
+ * It creates XPON.ONU.1 with 2 EthernetUNI instances and one ANI with a
+ * number of GEM ports (4096 by default), and measures the wall time of
+ * dm_omci_reset_mib() for that ONU, including handling the events it causes.
+ * It does so with and without the option 'omci_reset_mib_aggregated_event'.
+ *
+ * Usage: bench_omci_reset_mib [nr_of_gem_ports]
+ */
+
+/* System headers */
+#include <stdio.h>  /* printf() */
+#include <stdlib.h> /* strtoul() */
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/* Own headers */
+#include "bench_dm.h"
+#include "data_model.h" /* dm_omci_reset_mib() */
+
+#define DEFAULT_NR_OF_GEM_PORTS 4096
+#define GEM_PORT_PATH "XPON.ONU.1.ANI.1.TC.GEM.Port"
+
+static bool add_gem_ports(uint32_t n_gem_ports) {
+
+    uint32_t i;
+    amxc_var_t args;
+    amxc_var_t* op;
+    amxc_var_t* keys;
+
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const ops = amxc_var_add_key(amxc_llist_t, &args, "operations", NULL);
+    for(i = 1; i <= n_gem_ports; ++i) {
+        op = amxc_var_add(amxc_htable_t, ops, NULL);
+        amxc_var_add_key(cstring_t, op, "action", "add");
+        amxc_var_add_key(cstring_t, op, "path", GEM_PORT_PATH);
+        amxc_var_add_key(uint32_t, op, "index", i);
+        keys = amxc_var_add_key(amxc_htable_t, op, "keys", NULL);
+        amxc_var_add_key(uint32_t, keys, "PortID", i);
+    }
+    const int rc = dm_apply_batch_impl(&args, NULL);
+    amxc_var_clean(&args);
+    bench_dm_handle_events();
+    return (0 == rc);
+}
+
+static void set_uni_status_up(uint32_t index) {
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", "XPON.ONU.1.EthernetUNI");
+    amxc_var_add_key(uint32_t, &args, "index", index);
+    amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, &args, "parameters", NULL);
+    amxc_var_add_key(cstring_t, params, "Status", "Up");
+    dm_change_object(&args);
+    amxc_var_clean(&args);
+    bench_dm_handle_events();
+}
+
+static bool run(uint32_t n_gem_ports, bool aggregated) {
+
+    bool rv = false;
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    bench_dm_set_config_bool("omci_reset_mib_aggregated_event", aggregated);
+
+    set_uni_status_up(1);
+    set_uni_status_up(2);
+    if(!add_gem_ports(n_gem_ports)) {
+        printf("Failed to create %d GEM ports\n", n_gem_ports);
+        goto exit;
+    }
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(uint32_t, &args, "index", 1);
+
+    const double start = bench_now_s();
+    const int rc = dm_omci_reset_mib(&args);
+    const double reset_done = bench_now_s();
+    bench_dm_handle_events();
+    const double events_done = bench_now_s();
+
+    printf("%s event(s): %d GEM ports: reset %.3f ms + events %.3f ms = %.3f ms (rc=%d)\n",
+           aggregated ? "aggregated  " : "per-instance", n_gem_ports,
+           (reset_done - start) * 1e3, (events_done - reset_done) * 1e3,
+           (events_done - start) * 1e3, rc);
+    rv = (0 == rc);
+
+exit:
+    amxc_var_clean(&args);
+    return rv;
+}
+
+int main(int argc, char* argv[]) {
+
+    int rc = 1;
+    const uint32_t n_gem_ports = (argc > 1) ?
+        (uint32_t) strtoul(argv[1], NULL, 10) : DEFAULT_NR_OF_GEM_PORTS;
+
+    if(!bench_dm_init()) {
+        printf("Failed to initialize DM\n");
+        goto exit;
+    }
+
+    if(!bench_dm_add_instance("XPON.ONU", 1, "Name", "ONU1") ||
+       !bench_dm_add_instance("XPON.ONU.1.EthernetUNI", 1, "Name", "UNI1") ||
+       !bench_dm_add_instance("XPON.ONU.1.EthernetUNI", 2, "Name", "UNI2") ||
+       !bench_dm_add_instance("XPON.ONU.1.ANI", 1, "Name", "ANI1")) {
+        printf("Failed to create ONU\n");
+        goto exit_cleanup;
+    }
+    bench_dm_handle_events();
+
+    if(run(n_gem_ports, false) && run(n_gem_ports, true)) {
+        rc = 0;
+    }
+
+exit_cleanup:
+    bench_dm_cleanup();
+exit:
+    return rc;
+}
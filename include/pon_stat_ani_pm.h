@@ -0,0 +1,162 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __pon_stat_ani_pm_h__
+#define __pon_stat_ani_pm_h__
+
+/**
+ * @file pon_stat_ani_pm.h
+ *
+ * Fixed-layout ABI for the pon_stat function dm_update_ani_pm().
+ *
+ * The vendor module can use this function instead of dm_object_changed() to
+ * update the counters of the ANI PM objects TC.PM.PHY, TC.PM.GEM,
+ * TC.PM.PLOAM and TC.PM.OMCI. It fills in a pon_stat_ani_pm_t and passes its
+ * address as uint64_t variant:
+ *
+ * @code
+ * pon_stat_ani_pm_t pm = { .version = PON_STAT_ANI_PM_VERSION,
+ *                          .size = sizeof(pon_stat_ani_pm_t),
+ *                          .groups = PON_STAT_ANI_PM_PHY | PON_STAT_ANI_PM_GEM,
+ *                          .onu_index = 1, .ani_index = 1 };
+ * pm.phy.corrected_fec_bytes = ...;
+ * amxc_var_t args;
+ * amxc_var_init(&args);
+ * amxc_var_set(uint64_t, &args, (uintptr_t) &pm);
+ * amxm_execute_function(NULL, "pon_stat", "dm_update_ani_pm", &args, &ret);
+ * @endcode
+ *
+ * Rules to keep the ABI stable:
+ * - A new version only appends fields to pon_stat_ani_pm_t. It never changes
+ *   the type or the position of an existing field.
+ * - The vendor module sets 'version' and 'size' to the values of the header
+ *   it's compiled with. tr181-xpon ignores fields beyond the ones it knows.
+ */
+
+#include <stdint.h>
+
+/** Current version of pon_stat_ani_pm_t */
+#define PON_STAT_ANI_PM_VERSION 1
+
+/** Bits for pon_stat_ani_pm_t.groups: which PM groups have valid values */
+#define PON_STAT_ANI_PM_PHY   (1U << 0)
+#define PON_STAT_ANI_PM_GEM   (1U << 1)
+#define PON_STAT_ANI_PM_PLOAM (1U << 2)
+#define PON_STAT_ANI_PM_OMCI  (1U << 3)
+
+/** XPON.ONU.{i}.ANI.{i}.TC.PM.PHY */
+typedef struct __attribute__((packed)) _pon_stat_ani_pm_phy {
+    uint64_t corrected_fec_bytes;
+    uint64_t corrected_fec_codewords;
+    uint64_t uncorrectable_fec_codewords;
+    uint64_t total_fec_codewords;
+    uint32_t psbd_hec_error_count;
+    uint32_t header_hec_error_count;
+    uint32_t unknown_profile;
+} pon_stat_ani_pm_phy_t;
+
+/** XPON.ONU.{i}.ANI.{i}.TC.PM.GEM */
+typedef struct __attribute__((packed)) _pon_stat_ani_pm_gem {
+    uint64_t frames_sent;
+    uint64_t frames_received;
+    uint32_t frame_header_hec_errors;
+    uint32_t key_errors;
+} pon_stat_ani_pm_gem_t;
+
+/** XPON.ONU.{i}.ANI.{i}.TC.PM.PLOAM */
+typedef struct __attribute__((packed)) _pon_stat_ani_pm_ploam {
+    uint32_t mic_errors;
+    uint64_t downstream_message_count;
+    uint64_t ranging_time;
+    uint64_t upstream_message_count;
+} pon_stat_ani_pm_ploam_t;
+
+/** XPON.ONU.{i}.ANI.{i}.TC.PM.OMCI */
+typedef struct __attribute__((packed)) _pon_stat_ani_pm_omci {
+    uint64_t baseline_messages_received;
+    uint64_t extended_messages_received;
+    uint32_t mic_errors;
+} pon_stat_ani_pm_omci_t;
+
+/**
+ * PM counters of one ANI.
+ *
+ * @version: PON_STAT_ANI_PM_VERSION
+ * @size: sizeof(pon_stat_ani_pm_t)
+ * @groups: bitmask of PON_STAT_ANI_PM_* values. tr181-xpon only updates the
+ *          groups whose bit is set.
+ * @onu_index: index of the XPON.ONU instance
+ * @ani_index: index of the ANI instance of that ONU
+ */
+typedef struct __attribute__((packed)) _pon_stat_ani_pm {
+    uint16_t version;
+    uint16_t size;
+    uint32_t groups;
+    uint32_t onu_index;
+    uint32_t ani_index;
+    pon_stat_ani_pm_phy_t phy;
+    pon_stat_ani_pm_gem_t gem;
+    pon_stat_ani_pm_ploam_t ploam;
+    pon_stat_ani_pm_omci_t omci;
+} pon_stat_ani_pm_t;
+
+#endif
@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __xpon_capture_h__
+#define __xpon_capture_h__
+
+/**
+ * @file xpon_capture.h
+ *
+ * Format of the capture file of tr181-xpon.
+ *
+ * If the config option 'capture_file' is set, tr181-xpon records each call of
+ * a pon_stat function by the vendor module, and each call of a pon_ctrl
+ * function by tr181-xpon, to that file. A capture can be replayed with the
+ * simulated vendor module mod-xpon-sim.
+ *
+ * The file starts with XPON_CAPTURE_MAGIC followed by a byte with
+ * XPON_CAPTURE_VERSION. Then follows a record per call, written when the call
+ * returns. A nested call is thus written before the call it's nested in.
+ * Each record has:
+ * - xpon_capture_record_t
+ * - the function name: 'name_len' bytes, not 0-terminated
+ * - uint32_t with the length of the args, followed by the args
+ * - uint32_t with the length of the return value, followed by the return
+ *   value
+ *
+ * The args and the return value are variants, encoded as a byte with one of
+ * the XPON_CAPTURE_TAG values, followed by:
+ * - NULL: nothing
+ * - STRING, CSV_STRING: uint32_t with the length, followed by the characters,
+ *   not 0-terminated
+ * - BOOL: uint8_t
+ * - INT32, UINT32, FD: 4 bytes
+ * - INT64, UINT64, DOUBLE: 8 bytes
+ * - LIST: uint32_t with the number of elements, followed by the elements
+ * - HTABLE: uint32_t with the number of elements, followed per element by an
+ *   uint16_t with the length of the key, the key (not 0-terminated) and the
+ *   value
+ * - BLOB: uint32_t with the length, followed by the bytes. The args of
+ *   dm_update_ani_pm() are encoded as BLOB with the pon_stat_ani_pm_t the
+ *   address refers to.
+ * A variant of another type is encoded as STRING.
+ *
+ * Secrets are not written to the file: the 'password' of a set_password()
+ * call is replaced by XPON_CAPTURE_REDACTED.
+ *
+ * All integers are in host byte order: a capture can only be replayed on a
+ * system with the same byte order.
+ */
+
+#include <stdint.h>
+
+#define XPON_CAPTURE_MAGIC "XPONCAP"
+#define XPON_CAPTURE_MAGIC_LEN 7
+#define XPON_CAPTURE_VERSION 1
+
+/** Value written instead of a secret, e.g. the password of set_password() */
+#define XPON_CAPTURE_REDACTED "<redacted>"
+
+/** Values for xpon_capture_record_t.kind */
+#define XPON_CAPTURE_PON_STAT 1 /* call of a pon_stat function by the vendor module */
+#define XPON_CAPTURE_PON_CTRL 2 /* call of a pon_ctrl function by tr181-xpon */
+
+/** Tags of the encoded variants */
+#define XPON_CAPTURE_TAG_NULL       0
+#define XPON_CAPTURE_TAG_STRING     1
+#define XPON_CAPTURE_TAG_CSV_STRING 2
+#define XPON_CAPTURE_TAG_BOOL       3
+#define XPON_CAPTURE_TAG_INT32      4
+#define XPON_CAPTURE_TAG_UINT32     5
+#define XPON_CAPTURE_TAG_INT64      6
+#define XPON_CAPTURE_TAG_UINT64     7
+#define XPON_CAPTURE_TAG_DOUBLE     8
+#define XPON_CAPTURE_TAG_FD         9
+#define XPON_CAPTURE_TAG_LIST       10
+#define XPON_CAPTURE_TAG_HTABLE     11
+#define XPON_CAPTURE_TAG_BLOB       12
+
+/**
+ * Fixed part of a record.
+ *
+ * @kind: XPON_CAPTURE_PON_STAT or XPON_CAPTURE_PON_CTRL
+ * @time_us: start of the call in us, relative to the start of the capture
+ * @latency_us: duration of the call in us
+ * @rc: return value of the call
+ * @depth: number of captured calls which were ongoing when the call started,
+ *     e.g. 1 for a pon_ctrl call done while handling a pon_stat call
+ * @name_len: length of the function name which follows
+ */
+typedef struct __attribute__((packed)) _xpon_capture_record {
+    uint8_t kind;
+    uint64_t time_us;
+    uint32_t latency_us;
+    int32_t rc;
+    uint8_t depth;
+    uint8_t name_len;
+} xpon_capture_record_t;
+
+#endif
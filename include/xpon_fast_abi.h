@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __xpon_fast_abi_h__
+#define __xpon_fast_abi_h__
+
+/**
+ * @file xpon_fast_abi.h
+ *
+ * Fast ABI v2 between tr181-xpon and the vendor module.
+ *
+ * With the default ABI (v1), tr181-xpon and the vendor module call each
+ * other's functions by name via libamxm, and pass all arguments in variants.
+ * With the fast ABI, they call each other via tables with typed function
+ * pointers. The fast ABI is optional: the default ABI remains available.
+ *
+ * To support the fast ABI, the vendor module exports a function with the name
+ * XPON_FAST_ABI_SYMBOL and the type xpon_fast_abi_get_t. tr181-xpon looks it
+ * up with dlsym() right after it loaded the vendor module, and calls it once.
+ * It passes its pon_stat table, which the vendor module keeps to call
+ * tr181-xpon. The function returns the pon_ctrl table of the vendor module:
+ *
+ * @code
+ * static const xpon_pon_stat_v2_t* s_pon_stat = NULL;
+ *
+ * static const xpon_pon_ctrl_v2_t s_pon_ctrl = {
+ *     .version = XPON_FAST_ABI_VERSION,
+ *     .size = sizeof(xpon_pon_ctrl_v2_t),
+ *     .set_enable = my_set_enable,
+ *     .get_param_values = my_get_param_values
+ * };
+ *
+ * const xpon_pon_ctrl_v2_t* xpon_fast_abi_v2(const xpon_pon_stat_v2_t* pon_stat) {
+ *     s_pon_stat = pon_stat;
+ *     return &s_pon_ctrl;
+ * }
+ *
+ * ...
+ * if(XPON_FAST_ABI_HAS(xpon_pon_stat_v2_t, s_pon_stat, dm_instance_removed)) {
+ *     s_pon_stat->dm_instance_removed("XPON.ONU.1.SoftwareImage", 2);
+ * }
+ * @endcode
+ *
+ * A function pointer which is NULL, or which is beyond the 'size' of the
+ * table, is not available via the fast ABI. The caller must then call the
+ * function with the same name in the pon_ctrl or pon_stat namespace via
+ * libamxm. The vendor module must register the mandatory functions of the
+ * pon_ctrl namespace which it does not provide via the fast ABI.
+ *
+ * All functions return 0 on success, else -1, unless mentioned otherwise. The
+ * arguments have the same meaning as the keys with the same name in the
+ * arguments of the function with the same name in the default ABI.
+ *
+ * Rules to keep the ABI stable:
+ * - A new version only appends fields to the tables. It never changes the
+ *   type or the position of an existing field.
+ * - Each side sets 'version' and 'size' of its table to the values of the
+ *   header it's compiled with.
+ */
+
+#include <stdbool.h>
+#include <stddef.h> /* offsetof() */
+#include <stdint.h>
+
+#include <amxc/amxc_variant.h>
+
+#include "pon_stat_ani_pm.h"
+
+/** Current version of the fast ABI */
+#define XPON_FAST_ABI_VERSION 2
+
+/** Name of the function the vendor module exports. See xpon_fast_abi_get_t. */
+#define XPON_FAST_ABI_SYMBOL "xpon_fast_abi_v2"
+
+/**
+ * Return true if @a table has a non-NULL function pointer @a fn.
+ *
+ * @param type: type of the table, e.g. xpon_pon_stat_v2_t
+ * @param table: pointer to the table, can be NULL
+ * @param fn: name of the function pointer, e.g. dm_instance_removed
+ */
+#define XPON_FAST_ABI_HAS(type, table, fn) \
+    (((table) != NULL) && \
+     ((table)->size >= (offsetof(type, fn) + sizeof((table)->fn))) && \
+     ((table)->fn != NULL))
+
+/**
+ * Functions of the pon_ctrl namespace the vendor module provides.
+ *
+ * @version: XPON_FAST_ABI_VERSION
+ * @size: sizeof(xpon_pon_ctrl_v2_t)
+ * @get_param_values: the function adds the values of the params to the
+ *                    htable @a parameters
+ */
+typedef struct _xpon_pon_ctrl_v2 {
+    uint16_t version;
+    uint16_t size;
+    int (* set_enable)(const char* path, bool enable);
+    int (* get_param_values)(const char* path, const char* names,
+                             amxc_var_t* parameters);
+    int (* get_param_values_async)(const char* path, const char* names);
+    int (* handle_file_descriptor)(int fd);
+    int (* set_password)(const char* ani_path, const char* password,
+                         bool is_hexadecimal_password);
+} xpon_pon_ctrl_v2_t;
+
+/**
+ * Functions of the pon_stat namespace tr181-xpon provides.
+ *
+ * @version: XPON_FAST_ABI_VERSION
+ * @size: sizeof(xpon_pon_stat_v2_t)
+ * @dm_object_changed: @a index is 0 to update the object @a path itself.
+ *                     @a parameters is an htable with the new values.
+ * @onu_list_changed: @a nr_of_onus is 0 if the vendor module does not know
+ *                    the final number of ONUs.
+ * @dm_instance_added, @dm_add_or_change_instance, @dm_apply_batch,
+ * @param_values_ready: same arguments as the functions of the default ABI.
+ *                    Only the call via libamxm is avoided.
+ */
+typedef struct _xpon_pon_stat_v2 {
+    uint16_t version;
+    uint16_t size;
+    int (* dm_instance_removed)(const char* path, uint32_t index);
+    int (* dm_object_changed)(const char* path, uint32_t index,
+                              const amxc_var_t* parameters);
+    int (* dm_update_ani_pm)(const pon_stat_ani_pm_t* pm);
+    int (* omci_reset_mib)(uint32_t index);
+    int (* watch_file_descriptor_start)(int fd);
+    int (* watch_file_descriptor_stop)(int fd);
+    int (* onu_list_changed)(uint32_t nr_of_onus);
+    int (* dm_instance_added)(const amxc_var_t* args);
+    int (* dm_add_or_change_instance)(const amxc_var_t* args);
+    int (* dm_apply_batch)(const amxc_var_t* args, amxc_var_t* ret);
+    int (* param_values_ready)(const amxc_var_t* args);
+} xpon_pon_stat_v2_t;
+
+/**
+ * Type of the function the vendor module exports as XPON_FAST_ABI_SYMBOL.
+ *
+ * @param pon_stat: pon_stat table of tr181-xpon. It remains valid until
+ *                  tr181-xpon unloads the vendor module.
+ *
+ * @return the pon_ctrl table of the vendor module, or NULL if the vendor
+ *         module does not support the fast ABI with @a pon_stat
+ */
+typedef const xpon_pon_ctrl_v2_t* (* xpon_fast_abi_get_t)(const xpon_pon_stat_v2_t* pon_stat);
+
+#endif
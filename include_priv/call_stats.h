@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __call_stats_h__
+#define __call_stats_h__
+
+/**
+ * @file call_stats.h
+ *
+ * Counters and latency histogram per function called between the plugin and
+ * the vendor module.
+ */
+
+/* System headers */
+#include <stdint.h>
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/**
+ * Number of buckets of the latency histogram.
+ *
+ * Bucket 0 counts the calls which took less than 1 us. Bucket 'i' (i > 0)
+ * counts the calls which took [2^(i-1), 2^i) us. The last bucket also counts
+ * all slower calls.
+ */
+#define CALL_STATS_NR_OF_BUCKETS 28
+
+/**
+ * Statistics of a function.
+ *
+ * - name     function name
+ * - calls    number of calls
+ * - errors   number of calls which returned a nonzero value
+ * - max_us   max latency in us
+ * - buckets  latency histogram
+ * - it       iterator for the list of registered statistics
+ */
+typedef struct _call_stats {
+    const char* name;
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t max_us;
+    uint64_t buckets[CALL_STATS_NR_OF_BUCKETS];
+    amxc_llist_it_t it;
+} call_stats_t;
+
+/**
+ * Groups of functions for which the plugin keeps statistics.
+ *
+ * - call_stats_pon_ctrl: functions the plugin calls in the vendor module
+ * - call_stats_pon_stat: functions the vendor module calls in the plugin
+ */
+typedef enum _call_stats_group {
+    call_stats_pon_ctrl,
+    call_stats_pon_stat,
+    call_stats_group_nr
+} call_stats_group_t;
+
+void call_stats_register(call_stats_group_t group, const char* const name,
+                         call_stats_t* const stats);
+void call_stats_record(call_stats_t* const stats, uint64_t start_us, int rc);
+uint64_t call_stats_percentile(const call_stats_t* const stats, uint32_t percent);
+void call_stats_get_summary(call_stats_group_t group, amxc_string_t* const summary);
+void call_stats_reset(void);
+void call_stats_cleanup(void);
+
+#endif
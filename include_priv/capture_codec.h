@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __capture_codec_h__
+#define __capture_codec_h__
+
+/**
+ * @file capture_codec.h
+ *
+ * Encoding and decoding of the variants in a capture file. See
+ * xpon_capture.h for the format.
+ *
+ * The module only depends on libamxc, such that the simulated vendor module
+ * can use it to replay a capture.
+ */
+
+/* System headers */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/** Growing byte buffer */
+typedef struct _capture_buf {
+    uint8_t* data;
+    size_t len;
+    size_t size;
+} capture_buf_t;
+
+/** Reader of a byte buffer */
+typedef struct _capture_reader {
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+} capture_reader_t;
+
+void capture_buf_init(capture_buf_t* const buf);
+void capture_buf_clean(capture_buf_t* const buf);
+bool capture_buf_append(capture_buf_t* const buf, const void* const data, size_t len);
+bool capture_encode_var(capture_buf_t* const buf, const amxc_var_t* const var);
+bool capture_encode_blob(capture_buf_t* const buf, const void* const data, uint32_t len);
+bool capture_encode_pon_ctrl_args(capture_buf_t* const buf, const char* const name,
+                                  const amxc_var_t* const args);
+
+bool capture_read(capture_reader_t* const reader, void* const out, size_t len);
+bool capture_decode_var(capture_reader_t* const reader, amxc_var_t* const var,
+                        void** const blob);
+
+#endif
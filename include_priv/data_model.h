@@ -72,6 +72,7 @@
 /* System headers */
 #include <stdbool.h>
 #include <stddef.h>  /* size_t */
+#include <stdint.h>
 
 /* Other libraries' headers */
 #include <amxc/amxc_variant.h> /* amxc_var_t */
@@ -81,12 +82,19 @@
 
 void dm_set_vendor_module(const char* name);
 void dm_set_module_error(void);
+void dm_set_startup_population_time(uint32_t duration);
+void dm_set_nr_of_stale_instances(uint32_t nr_of_instances);
 
 int dm_add_instance(const amxc_var_t* const args);
 int dm_remove_instance(const amxc_var_t* const args);
+int dm_remove_instance_at(const char* const path, uint32_t index);
 int dm_change_object(const amxc_var_t* const args);
+int dm_change_object_params(const char* const path, uint32_t index,
+                            const amxc_var_t* const params);
 int dm_add_or_change_instance_impl(const amxc_var_t* const args);
+int dm_apply_batch_impl(const amxc_var_t* const args, amxc_var_t* const ret);
 int dm_omci_reset_mib(const amxc_var_t* const args);
+int dm_omci_reset_mib_onu(uint32_t index);
 int dm_set_xpon_parameter_impl(const amxc_var_t* const args);
 
 bool dm_does_instance_exist(const char* path, uint32_t index);
@@ -71,6 +71,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <amxc/amxc.h>       /* amxc_var_t */
+#include <amxd/amxd_types.h> /* amxd_dm_t */
+
 #define ENABLE_PARAM "Enable"
 
 #define NAME_PARAM "Name"
@@ -87,6 +90,11 @@ typedef enum _xpon_object_id {
     obj_id_ani_tc_authentication,
     obj_id_ani_tc_performance_thresholds,
     obj_id_ani_tc_alarms,
+    obj_id_ani_tc_pm_phy,
+    obj_id_ani_tc_pm_gem,
+    obj_id_ani_tc_pm_ploam,
+    obj_id_ani_tc_pm_omci,
+    obj_id_gem_port_pm,
     obj_id_nbr,
     obj_id_unknown = obj_id_nbr
 } object_id_t;
@@ -97,6 +105,24 @@ typedef struct _param_info {
 } param_info_t;
 
 
+/**
+ * How the plugin gets the param values of an object from the vendor module.
+ *
+ * - update_policy_push: the vendor module pushes updates, e.g. with
+ *     dm_object_changed().
+ * - update_policy_pull: the plugin asks the vendor module for the value of a
+ *     param each time the param is read.
+ * - update_policy_pull_cached: if a param is read, the plugin asks the vendor
+ *     module for all params of the object at once, and writes them to the DM.
+ *     It serves the next reads from the DM until the values are older than
+ *     the configured cache time.
+ */
+typedef enum _update_policy {
+    update_policy_push = 0,
+    update_policy_pull,
+    update_policy_pull_cached
+} update_policy_t;
+
 /**
  * Info which is known at compile time about an object in the XPON DM.
  *
@@ -118,6 +144,10 @@ typedef struct _param_info {
  * - has_rw_enable: true if the object has a read-write Enable parameter. The
  *       code only looks at this field when creating a new instance of a
  *       template object.
+ * - update_policy: default update policy. The config option 'update_policy'
+ *       can override it. See dm_info_set_update_policies().
+ * - pull_supported: true if the object supports a pull policy: all its params
+ *       must have the read action read_coalesced_param in the odl files.
  */
 typedef struct _object_info {
     object_id_t id;
@@ -130,15 +160,33 @@ typedef struct _object_info {
     const param_info_t* params;
     uint32_t n_params;
     bool has_rw_enable;
+    update_policy_t update_policy;
+    bool pull_supported;
 } object_info_t;
 
+/**
+ * Instance indexes found in a path by dm_classify_path().
+ *
+ * Each field is 0 if the path does not have the corresponding index.
+ */
+typedef struct _dm_object_indexes {
+    uint32_t onu;
+    uint32_t ani;
+    uint32_t gem_port;
+} dm_object_indexes_t;
+
 bool dm_info_init(void);
+bool dm_info_sync_param_types(amxd_dm_t* const dm);
+bool dm_info_set_update_policies(const amxc_var_t* const config);
 
 object_id_t dm_get_object_id(const char* path);
+object_id_t dm_classify_path(const char* path, dm_object_indexes_t* indexes);
 
 const object_info_t* dm_get_object_info(object_id_t id);
 
 bool dm_get_object_param_info(object_id_t id, const param_info_t** param_info,
                               uint32_t* size);
+const param_info_t* dm_get_param_info(object_id_t id, const char* name);
+update_policy_t dm_get_update_policy(object_id_t id, uint32_t* cache_ms);
 
 #endif
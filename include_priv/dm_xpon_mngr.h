@@ -73,5 +73,6 @@
 
 amxd_dm_t * PRIVATE xpon_mngr_get_dm(void);
 amxo_parser_t* PRIVATE xpon_mngr_get_parser(void);
+uint32_t PRIVATE xpon_mngr_get_max_nr_of_onus(void);
 
 #endif
@@ -73,6 +73,7 @@
 #include <stddef.h>
 
 bool write_file(const char* const path, const char* const value);
+bool write_file_atomically(const char* const path, const char* const data);
 bool read_first_line_from_file(const char* const path, char* line, size_t len);
 
 #endif
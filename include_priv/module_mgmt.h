@@ -73,8 +73,11 @@
 
 #include <stdbool.h>
 
+#include "call_stats.h" /* call_stats_t */
+
 bool mod_module_mgmt_init(bool* module_error);
 const char* mod_get_vendor_module_loaded(void);
+call_stats_t* mod_get_pon_stat_stats(const char* const name);
 void mod_module_mgmt_cleanup(void);
 
 #endif
@@ -70,28 +70,78 @@
  * Functions related to the private data attached to an interface object.
  *
  * tr181-xpon attaches private data to the interface objects EthernetUNI and
- * ANI to implement their LastChange parameter.
+ * ANI to implement their LastChange parameter. The private data also keeps a
+ * short history of the Status transitions, counts the flaps, and implements
+ * the flap damping. For an ANI, the private data also caches the PM
+ * parameters updated by dm_update_ani_pm().
  */
 
 /* System headers */
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Other libraries' headers */
-#include <amxc/amxc.h> /* amxc_var_t */
+#include <amxc/amxc.h>          /* amxc_var_t */
+#include <amxp/amxp.h>          /* amxp_timer_t */
+#include <amxd/amxd_types.h>    /* amxd_object_t */
+
+/* Own headers */
+#include "ani_pm.h"    /* ani_pm_params_t */
+
+/** Number of Status transitions in the history of an interface object */
+#define OIPRIV_STATUS_HISTORY_SIZE 8
+
+/** Size of a buffer which can hold the longest Status value */
+#define OIPRIV_STATUS_MAX_SIZE 16
+
+/**
+ * Status transition of an interface object.
+ *
+ * @timestamp: time in ms of the monotonic clock when Status changed
+ * @status: new value of Status
+ */
+typedef struct _status_transition {
+    uint64_t timestamp;
+    char status[OIPRIV_STATUS_MAX_SIZE];
+} status_transition_t;
 
 /**
  * Type of private data attached to an interface object.
  *
- * @last_change: timestamp indicating when Status changed the last time.
- *               Expressed in seconds since startup.
+ * @last_change: time in ms of the monotonic clock when Status changed the
+ *               last time.
+ * @pm_params: PM parameters of an ANI, resolved at the 1st call of
+ *             dm_update_ani_pm() for the ANI. NULL for an EthernetUNI.
+ * @history: ring buffer with the last Status transitions in the DM
+ * @history_head: index in @history where the next transition will be written
+ * @history_count: number of valid transitions in @history
+ * @nr_of_flaps: number of times the vendor module changed Status from Up to
+ *               another value, including the changes held back by the flap
+ *               damping
+ * @reported_status: last value the vendor module reported for Status
+ * @held_status: value for Status held back by the flap damping. Empty if
+ *               there is no such value.
+ * @damping_timer: timer which writes @held_status to the DM when it expires
  */
 typedef struct _object_intf_priv {
-    uint32_t last_change;
+    uint64_t last_change;
+    ani_pm_params_t* pm_params;
+    status_transition_t history[OIPRIV_STATUS_HISTORY_SIZE];
+    uint32_t history_head;
+    uint32_t history_count;
+    uint32_t nr_of_flaps;
+    char reported_status[OIPRIV_STATUS_MAX_SIZE];
+    char held_status[OIPRIV_STATUS_MAX_SIZE];
+    amxp_timer_t* damping_timer;
 } object_intf_priv_t;
 
 
+void oipriv_init(void);
 void oipriv_attach_private_data(const amxc_var_t* const data);
 void oipriv_delete_private_data(object_intf_priv_t* priv);
 void oipriv_update_last_change(const amxc_var_t* const data);
+bool oipriv_hold_status(amxd_object_t* const object, const amxc_var_t* const status);
+void oipriv_status_history_to_string(const object_intf_priv_t* const priv,
+                                     amxc_string_t* const str);
 
 #endif
@@ -77,10 +77,15 @@
 #include <amxc/amxc_variant.h>
 
 void pon_ctrl_init(void);
+void pon_ctrl_cleanup(void);
 void pon_ctrl_set_enable(const char* const path, bool enable);
 int pon_ctrl_get_list_of_instances(const char* const path, amxc_var_t* ret);
 int pon_ctrl_get_object_content(const char* const path, uint32_t index, amxc_var_t* ret);
 int pon_ctrl_get_param_values(const char* const path, const char* const names, amxc_var_t* ret);
+bool pon_ctrl_has_get_param_values_async(void);
+int pon_ctrl_get_param_values_async(const char* const path, const char* const names);
+bool pon_ctrl_has_get_object_tree(void);
+int pon_ctrl_get_object_tree(const char* const path, uint32_t index, amxc_var_t* ret);
 void pon_ctrl_handle_file_descriptor(int fd);
 void pon_ctrl_set_password(const char* const ani_path, const char* const password, bool hex);
 
@@ -70,15 +70,25 @@
  * these functions.
  */
 
+#include <stdbool.h>
+
 #include <amxc/amxc.h>
 
+#include "xpon_fast_abi.h" /* xpon_pon_stat_v2_t */
+
 int dm_instance_added(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int dm_instance_removed(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int dm_object_changed(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int dm_add_or_change_instance(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
+int dm_apply_batch(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
+int dm_update_ani_pm(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int omci_reset_mib(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int watch_file_descriptor_start(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int watch_file_descriptor_stop(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
+int param_values_ready(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
+int onu_list_changed(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
 int dm_set_xpon_parameter(const char* function_name, amxc_var_t* args, amxc_var_t* ret);
+int pon_stat_watch_fd(int fd, bool start);
+const xpon_pon_stat_v2_t* pon_stat_get_fast_abi(void);
 
 #endif
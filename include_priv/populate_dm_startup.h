@@ -69,13 +69,17 @@
  * Functionality to populate the XPON DM after startup.
  *
  * The plugin checks the first few minutes after startup for any ONUs to be
- * added to the XPON DM. After that this part of the plugin does not do anything
- * anymore.
+ * added to the XPON DM. After that this part of the plugin only acts if the
+ * vendor module calls onu_list_changed().
  */
 
 #include <stdbool.h>
 
+#include <amxc/amxc_variant.h> /* amxc_var_t */
+
 bool pplt_dm_init(void);
 void pplt_dm_cleanup(void);
+int pplt_dm_onu_list_changed(const amxc_var_t* const args);
+int pplt_dm_onu_list_changed_n(uint32_t nr_of_onus);
 
 #endif
@@ -73,5 +73,8 @@
 #include <stdint.h>
 
 uint32_t time_get_system_uptime(void);
+uint64_t time_get_monotonic_ms(void);
+uint64_t time_get_monotonic_us(void);
+uint64_t time_get_cached_monotonic_ms(void);
 
 #endif
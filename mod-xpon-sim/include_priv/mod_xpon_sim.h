@@ -0,0 +1,149 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __mod_xpon_sim_h__
+#define __mod_xpon_sim_h__
+
+/**
+ * @file mod_xpon_sim.h
+ *
+ * Simulated vendor module for tr181-xpon.
+ *
+ * The module implements the pon_ctrl namespace for a synthetic topology, and
+ * drives the pon_stat namespace of tr181-xpon with configurable update
+ * storms. It does not need any PON hardware, so it can be used to measure the
+ * throughput and latency of tr181-xpon on a plain Linux box.
+ */
+
+/* System headers */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/**
+ * Trace zone name
+ */
+#define ME "xpon-sim"
+
+#include <debug/sahtrace.h>
+#include <debug/sahtrace_macros.h> /* when_null_trace(), ... */
+
+/**
+ * Configuration of the simulator.
+ *
+ * The module reads it from environment variables when it's loaded. An
+ * interval of 0 disables the corresponding update storm.
+ *
+ * - nr_of_onus              XPON_SIM_ONUS: number of ONUs. Limited to the max
+ *                           number of ONUs tr181-xpon passes.
+ * - nr_of_anis              XPON_SIM_ANIS: number of ANIs per ONU
+ * - nr_of_unis              XPON_SIM_UNIS: number of Ethernet UNIs per ONU
+ * - nr_of_gem_ports         XPON_SIM_GEM_PORTS: number of GEM ports per ANI
+ * - reply_latency_us        XPON_SIM_REPLY_LATENCY_US: delay each pon_ctrl
+ *                           reply by this number of us
+ * - pm_interval_ms          XPON_SIM_PM_INTERVAL_MS: push the PM counters of
+ *                           all ANIs
+ * - gem_pm_interval_ms      XPON_SIM_GEM_PM_INTERVAL_MS: push the PM counters
+ *                           of all GEM ports
+ * - alarm_interval_ms       XPON_SIM_ALARM_INTERVAL_MS: toggle an alarm of
+ *                           all ANIs
+ * - mib_upload_interval_ms  XPON_SIM_MIB_UPLOAD_INTERVAL_MS: do a MIB reset
+ *                           and a MIB upload for the next ONU
+ * - reset_mib_interval_ms   XPON_SIM_RESET_MIB_INTERVAL_MS: only do a MIB
+ *                           reset for the next ONU
+ * - fast_abi                XPON_SIM_FAST_ABI: use the fast ABI if 1 (default)
+ * - replay_file             XPON_SIM_REPLAY: capture file of tr181-xpon to
+ *                           replay instead of simulating a topology. See
+ *                           sim_replay.c.
+ * - replay_max_speed        XPON_SIM_REPLAY_MAX_SPEED: replay the calls as
+ *                           fast as possible if 1, else with the timing of the
+ *                           capture (default)
+ */
+typedef struct _sim_config {
+    uint32_t nr_of_onus;
+    uint32_t nr_of_anis;
+    uint32_t nr_of_unis;
+    uint32_t nr_of_gem_ports;
+    uint32_t reply_latency_us;
+    uint32_t pm_interval_ms;
+    uint32_t gem_pm_interval_ms;
+    uint32_t alarm_interval_ms;
+    uint32_t mib_upload_interval_ms;
+    uint32_t reset_mib_interval_ms;
+    bool fast_abi;
+    const char* replay_file;
+    bool replay_max_speed;
+} sim_config_t;
+
+const sim_config_t* sim_get_config(void);
+void sim_inject_latency(void);
+
+int sim_dm_object_changed(const char* const path, amxc_var_t* const parameters);
+int sim_dm_update_ani_pm(uint32_t onu, uint32_t ani);
+int sim_omci_reset_mib(uint32_t onu);
+int sim_dm_apply_batch(amxc_var_t* const args);
+int sim_onu_list_changed(uint32_t nr_of_onus);
+int sim_param_values_ready(amxc_var_t* const args);
+
+#endif
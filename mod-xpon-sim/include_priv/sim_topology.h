@@ -0,0 +1,112 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __sim_topology_h__
+#define __sim_topology_h__
+
+/**
+ * @file sim_topology.h
+ *
+ * Synthetic topology of the simulator: the ONUs with their software images,
+ * Ethernet UNIs and ANIs, and per ANI its TC objects, GEM ports and
+ * Transceiver.
+ *
+ * The values of the params are derived from the instance indexes, such that
+ * the module does not need to store them. Only the state the update storms
+ * change is stored.
+ */
+
+/* System headers */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+
+/* Own headers */
+#include "mod_xpon_sim.h" /* sim_config_t */
+#include "pon_stat_ani_pm.h"
+
+bool sim_topology_init(const sim_config_t* const config);
+void sim_topology_cleanup(void);
+void sim_topology_set_max_nr_of_onus(uint32_t max);
+uint32_t sim_topology_get_nr_of_onus(void);
+uint32_t sim_topology_get_nr_of_gem_ports(uint32_t onu);
+
+int sim_get_list_of_instances(const char* const path, amxc_var_t* const ret);
+int sim_get_object_content(const char* const path, uint32_t index,
+                           amxc_var_t* const ret);
+int sim_get_object_tree(const char* const path, uint32_t index,
+                        amxc_var_t* const ret);
+int sim_get_param_values(const char* const path, const char* const names,
+                         amxc_var_t* const parameters);
+
+void sim_topology_reset_mib(uint32_t onu);
+void sim_topology_upload_mib(uint32_t onu, amxc_var_t* const ops);
+void sim_topology_toggle_alarm(uint32_t onu, uint32_t ani,
+                               amxc_var_t* const parameters);
+void sim_topology_get_ani_pm(uint32_t onu, uint32_t ani,
+                             pon_stat_ani_pm_t* const pm);
+void sim_topology_get_gem_port_pm(uint32_t onu, uint32_t ani, uint32_t gem_port,
+                                  amxc_var_t* const parameters);
+
+#endif
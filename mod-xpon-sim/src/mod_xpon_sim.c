@@ -0,0 +1,522 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function 'nanosleep'
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* Related header */
+#include "mod_xpon_sim.h"
+
+/* System headers */
+#include <stdlib.h> /* getenv(), strtoul() */
+#include <time.h>   /* nanosleep() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxp/amxp_timer.h>
+#include <amxm/amxm.h>
+
+/* Own headers */
+#include "pon_stat_ani_pm.h"
+#include "sim_replay.h"   /* sim_replay_start() */
+#include "sim_storm.h"    /* sim_storm_start() */
+#include "sim_topology.h" /* sim_get_object_content() */
+#include "xpon_fast_abi.h"
+
+#define MOD_PON_CTRL "pon_ctrl"
+#define MOD_PON_STAT "pon_stat"
+
+/** Max value of the key PortID of a GEM port */
+#define MAX_NR_OF_GEM_PORTS 65534
+
+static sim_config_t s_config;
+static amxm_module_t* s_pon_ctrl = NULL;
+/** pon_stat table of the fast ABI of tr181-xpon. NULL if not used. */
+static const xpon_pon_stat_v2_t* s_pon_stat = NULL;
+/** One-shot timer to report the ONUs and to start the update storms */
+static amxp_timer_t* s_timer_start = NULL;
+/** One-shot timer to reply to the pending get_param_values_async() calls */
+static amxp_timer_t* s_timer_async = NULL;
+/** List of pending get_param_values_async() calls: htables with path and names */
+static amxc_var_t s_async_requests;
+
+#define HAS_PON_STAT(fn) XPON_FAST_ABI_HAS(xpon_pon_stat_v2_t, s_pon_stat, fn)
+
+static uint32_t env_uint32(const char* const name, uint32_t default_value) {
+    const char* const value = getenv(name);
+    return (value && *value) ? (uint32_t) strtoul(value, NULL, 0) : default_value;
+}
+
+static void read_config(void) {
+    s_config.nr_of_onus = env_uint32("XPON_SIM_ONUS", 1);
+    s_config.nr_of_anis = env_uint32("XPON_SIM_ANIS", 1);
+    s_config.nr_of_unis = env_uint32("XPON_SIM_UNIS", 4);
+    s_config.nr_of_gem_ports = env_uint32("XPON_SIM_GEM_PORTS", 32);
+    s_config.reply_latency_us = env_uint32("XPON_SIM_REPLY_LATENCY_US", 0);
+    s_config.pm_interval_ms = env_uint32("XPON_SIM_PM_INTERVAL_MS", 0);
+    s_config.gem_pm_interval_ms = env_uint32("XPON_SIM_GEM_PM_INTERVAL_MS", 0);
+    s_config.alarm_interval_ms = env_uint32("XPON_SIM_ALARM_INTERVAL_MS", 0);
+    s_config.mib_upload_interval_ms = env_uint32("XPON_SIM_MIB_UPLOAD_INTERVAL_MS", 0);
+    s_config.reset_mib_interval_ms = env_uint32("XPON_SIM_RESET_MIB_INTERVAL_MS", 0);
+    s_config.fast_abi = (env_uint32("XPON_SIM_FAST_ABI", 1) != 0);
+    s_config.replay_file = getenv("XPON_SIM_REPLAY");
+    s_config.replay_max_speed = (env_uint32("XPON_SIM_REPLAY_MAX_SPEED", 0) != 0);
+
+    if(s_config.nr_of_gem_ports > MAX_NR_OF_GEM_PORTS) {
+        SAH_TRACEZ_WARNING(ME, "Limit nr of GEM ports from %u to %u",
+                           s_config.nr_of_gem_ports, MAX_NR_OF_GEM_PORTS);
+        s_config.nr_of_gem_ports = MAX_NR_OF_GEM_PORTS;
+    }
+    SAH_TRACEZ_INFO(ME, "onus=%u anis=%u unis=%u gem_ports=%u latency=%u us fast_abi=%d",
+                    s_config.nr_of_onus, s_config.nr_of_anis, s_config.nr_of_unis,
+                    s_config.nr_of_gem_ports, s_config.reply_latency_us, s_config.fast_abi);
+}
+
+const sim_config_t* sim_get_config(void) {
+    return &s_config;
+}
+
+/**
+ * Delay a reply by the configured latency, as if the module waited for the
+ * PON/OMCI stack.
+ */
+void sim_inject_latency(void) {
+    when_true(0 == s_config.reply_latency_us, exit);
+    const struct timespec delay = {
+        .tv_sec = s_config.reply_latency_us / 1000000,
+        .tv_nsec = (long) (s_config.reply_latency_us % 1000000) * 1000
+    };
+    nanosleep(&delay, NULL);
+exit:
+    return;
+}
+
+static int call_pon_stat(const char* const func, amxc_var_t* const args,
+                         amxc_var_t* const ret) {
+    amxc_var_t ret_dummy;
+    amxc_var_init(&ret_dummy);
+    const int rc = amxm_execute_function("self", MOD_PON_STAT, func, args,
+                                         ret ? ret : &ret_dummy);
+    if(rc) {
+        SAH_TRACEZ_ERROR(ME, "%s.%s() failed: rc=%d", MOD_PON_STAT, func, rc);
+    }
+    amxc_var_clean(&ret_dummy);
+    return rc;
+}
+
+/**
+ * Update the params of an object in the DM of tr181-xpon.
+ *
+ * @param[in] path        path of a singleton or an instance
+ * @param[in] parameters  htable with the new values
+ */
+int sim_dm_object_changed(const char* const path, amxc_var_t* const parameters) {
+    if(HAS_PON_STAT(dm_object_changed)) {
+        return s_pon_stat->dm_object_changed(path, 0, parameters);
+    }
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", path);
+    amxc_var_set_key(&args, "parameters", parameters, AMXC_VAR_FLAG_COPY);
+    const int rc = call_pon_stat("dm_object_changed", &args, NULL);
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Push the next PM counters of an ANI to tr181-xpon.
+ */
+int sim_dm_update_ani_pm(uint32_t onu, uint32_t ani) {
+    pon_stat_ani_pm_t pm;
+    sim_topology_get_ani_pm(onu, ani, &pm);
+    if(HAS_PON_STAT(dm_update_ani_pm)) {
+        return s_pon_stat->dm_update_ani_pm(&pm);
+    }
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set(uint64_t, &args, (uintptr_t) &pm);
+    const int rc = call_pon_stat("dm_update_ani_pm", &args, NULL);
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Notify tr181-xpon of a MIB reset of an ONU.
+ */
+int sim_omci_reset_mib(uint32_t onu) {
+    if(HAS_PON_STAT(omci_reset_mib)) {
+        return s_pon_stat->omci_reset_mib(onu);
+    }
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(uint32_t, &args, "index", onu);
+    const int rc = call_pon_stat("omci_reset_mib", &args, NULL);
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Apply a list of operations to the DM of tr181-xpon in one call.
+ *
+ * @param[in] args  htable with the key 'operations'. See dm_apply_batch().
+ */
+int sim_dm_apply_batch(amxc_var_t* const args) {
+    int rc;
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+    if(HAS_PON_STAT(dm_apply_batch)) {
+        rc = s_pon_stat->dm_apply_batch(args, &ret);
+    } else {
+        rc = call_pon_stat("dm_apply_batch", args, &ret);
+    }
+    amxc_var_clean(&ret);
+    return rc;
+}
+
+/**
+ * Ask tr181-xpon to query the ONUs.
+ */
+int sim_onu_list_changed(uint32_t nr_of_onus) {
+    if(HAS_PON_STAT(onu_list_changed)) {
+        return s_pon_stat->onu_list_changed(nr_of_onus);
+    }
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(uint32_t, &args, "nr_of_onus", nr_of_onus);
+    const int rc = call_pon_stat("onu_list_changed", &args, NULL);
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Pass the result of a get_param_values_async() call to tr181-xpon.
+ *
+ * @param[in] args  htable with the keys 'path' and 'parameters'
+ */
+int sim_param_values_ready(amxc_var_t* const args) {
+    if(HAS_PON_STAT(param_values_ready)) {
+        return s_pon_stat->param_values_ready(args);
+    }
+    return call_pon_stat("param_values_ready", args, NULL);
+}
+
+/**
+ * Report the ONUs to tr181-xpon and start the update storms, or start the
+ * replay of a capture.
+ *
+ * Called once, from the event loop, after tr181-xpon passed the max number of
+ * ONUs.
+ */
+static void start(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    if(sim_replay_is_enabled()) {
+        sim_replay_start();
+        return;
+    }
+    sim_onu_list_changed(sim_topology_get_nr_of_onus());
+    if(!sim_storm_start(&s_config)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to start the update storms");
+    }
+}
+
+/**
+ * Reply to all pending get_param_values_async() calls.
+ */
+static void reply_async(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    amxc_var_for_each(request, &s_async_requests) {
+        const char* const path = GET_CHAR(request, "path");
+        amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(cstring_t, &args, "path", path);
+        amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, &args, "parameters", NULL);
+        if(0 == sim_get_param_values(path, GET_CHAR(request, "names"), params)) {
+            sim_param_values_ready(&args);
+        }
+        amxc_var_delete(&request);
+    }
+    amxc_var_clean(&args);
+}
+
+static int queue_async_request(const char* const path, const char* const names) {
+    int rc = -1;
+    when_null(path, exit);
+    when_null(names, exit);
+
+    amxc_var_t* const request = amxc_var_add(amxc_htable_t, &s_async_requests, NULL);
+    amxc_var_add_key(cstring_t, request, "path", path);
+    amxc_var_add_key(cstring_t, request, "names", names);
+    if(amxp_timer_get_state(s_timer_async) != amxp_timer_started) {
+        amxp_timer_start(s_timer_async, s_config.reply_latency_us / 1000);
+    }
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+static int set_max_nr_of_onus(UNUSED const char* function_name,
+                              amxc_var_t* args,
+                              UNUSED amxc_var_t* ret) {
+    sim_topology_set_max_nr_of_onus(amxc_var_dyncast(uint32_t, args));
+    amxp_timer_start(s_timer_start, 0);
+    return 0;
+}
+
+static int set_enable(UNUSED const char* function_name,
+                      amxc_var_t* args,
+                      UNUSED amxc_var_t* ret) {
+    sim_inject_latency();
+    SAH_TRACEZ_INFO(ME, "path='%s' enable=%d", GET_CHAR(args, "path"),
+                    GET_BOOL(args, "enable"));
+    return 0;
+}
+
+static int get_list_of_instances(UNUSED const char* function_name,
+                                 amxc_var_t* args,
+                                 amxc_var_t* ret) {
+    sim_inject_latency();
+    return sim_get_list_of_instances(amxc_var_constcast(cstring_t, args), ret);
+}
+
+static int get_object_content(UNUSED const char* function_name,
+                              amxc_var_t* args,
+                              amxc_var_t* ret) {
+    sim_inject_latency();
+    return sim_get_object_content(GET_CHAR(args, "path"), GET_UINT32(args, "index"), ret);
+}
+
+static int get_object_tree(UNUSED const char* function_name,
+                           amxc_var_t* args,
+                           amxc_var_t* ret) {
+    sim_inject_latency();
+    return sim_get_object_tree(GET_CHAR(args, "path"), GET_UINT32(args, "index"), ret);
+}
+
+static int get_param_values(UNUSED const char* function_name,
+                            amxc_var_t* args,
+                            amxc_var_t* ret) {
+    sim_inject_latency();
+    amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, ret, "parameters", NULL);
+    return sim_get_param_values(GET_CHAR(args, "path"), GET_CHAR(args, "names"), params);
+}
+
+static int get_param_values_async(UNUSED const char* function_name,
+                                  amxc_var_t* args,
+                                  UNUSED amxc_var_t* ret) {
+    return queue_async_request(GET_CHAR(args, "path"), GET_CHAR(args, "names"));
+}
+
+/**
+ * The module does not watch any file descriptor, so it has nothing to do.
+ */
+static int handle_file_descriptor(UNUSED const char* function_name,
+                                  UNUSED amxc_var_t* args,
+                                  UNUSED amxc_var_t* ret) {
+    return 0;
+}
+
+static int set_password(UNUSED const char* function_name,
+                        amxc_var_t* args,
+                        UNUSED amxc_var_t* ret) {
+    sim_inject_latency();
+    SAH_TRACEZ_INFO(ME, "ani_path='%s'", GET_CHAR(args, "ani_path"));
+    return 0;
+}
+
+/**
+ * Answer a pon_ctrl call from the capture being replayed.
+ */
+static int replay_pon_ctrl(const char* function_name,
+                           amxc_var_t* args,
+                           amxc_var_t* ret) {
+    return sim_replay_pon_ctrl(function_name, args, ret);
+}
+
+static int fast_set_enable(const char* path, bool enable) {
+    sim_inject_latency();
+    SAH_TRACEZ_INFO(ME, "path='%s' enable=%d", path, enable);
+    return 0;
+}
+
+static int fast_get_param_values(const char* path, const char* names,
+                                 amxc_var_t* parameters) {
+    sim_inject_latency();
+    return sim_get_param_values(path, names, parameters);
+}
+
+static int fast_get_param_values_async(const char* path, const char* names) {
+    return queue_async_request(path, names);
+}
+
+static int fast_handle_file_descriptor(UNUSED int fd) {
+    return 0;
+}
+
+static int fast_set_password(const char* ani_path, UNUSED const char* password,
+                             UNUSED bool is_hexadecimal_password) {
+    sim_inject_latency();
+    SAH_TRACEZ_INFO(ME, "ani_path='%s'", ani_path);
+    return 0;
+}
+
+static const xpon_pon_ctrl_v2_t PON_CTRL_V2 = {
+    .version = XPON_FAST_ABI_VERSION,
+    .size = sizeof(xpon_pon_ctrl_v2_t),
+    .set_enable = fast_set_enable,
+    .get_param_values = fast_get_param_values,
+    .get_param_values_async = fast_get_param_values_async,
+    .handle_file_descriptor = fast_handle_file_descriptor,
+    .set_password = fast_set_password
+};
+
+/**
+ * Exchange the tables of the fast ABI with tr181-xpon. See xpon_fast_abi.h.
+ *
+ * The module rejects the fast ABI if XPON_SIM_FAST_ABI is 0, such that the
+ * default ABI can be benchmarked as well. It also rejects it when replaying a
+ * capture: a capture only has calls of the default ABI.
+ */
+const xpon_pon_ctrl_v2_t* xpon_fast_abi_v2(const xpon_pon_stat_v2_t* pon_stat);
+const xpon_pon_ctrl_v2_t* xpon_fast_abi_v2(const xpon_pon_stat_v2_t* pon_stat) {
+    if(!s_config.fast_abi || sim_replay_is_enabled() || (NULL == pon_stat) ||
+       (pon_stat->version < XPON_FAST_ABI_VERSION)) {
+        return NULL;
+    }
+    s_pon_stat = pon_stat;
+    return &PON_CTRL_V2;
+}
+
+typedef struct _pon_ctrl_function {
+    const char* name;
+    amxm_callback_t impl;
+} pon_ctrl_function_t;
+
+static const pon_ctrl_function_t PON_CTRL_FUNCTIONS[] = {
+    { .name = "set_max_nr_of_onus", .impl = set_max_nr_of_onus },
+    { .name = "set_enable", .impl = set_enable },
+    { .name = "get_list_of_instances", .impl = get_list_of_instances },
+    { .name = "get_object_content", .impl = get_object_content },
+    { .name = "get_object_tree", .impl = get_object_tree },
+    { .name = "get_param_values", .impl = get_param_values },
+    { .name = "get_param_values_async", .impl = get_param_values_async },
+    { .name = "handle_file_descriptor", .impl = handle_file_descriptor },
+    { .name = "set_password", .impl = set_password },
+    { .name = NULL, .impl = NULL } /* sentinel */
+};
+
+AMXM_CONSTRUCTOR sim_init(void) {
+    int rc = -1;
+
+    read_config();
+    amxc_var_init(&s_async_requests);
+    amxc_var_set_type(&s_async_requests, AMXC_VAR_ID_LIST);
+    when_false_trace(sim_topology_init(&s_config), exit, ERROR,
+                     "Failed to create the topology");
+    when_false_trace(sim_replay_init(&s_config), exit, ERROR,
+                     "Failed to load the capture to replay");
+    when_failed_trace(amxp_timer_new(&s_timer_start, start, NULL), exit, ERROR,
+                      "Failed to create timer");
+    when_failed_trace(amxp_timer_new(&s_timer_async, reply_async, NULL), exit, ERROR,
+                      "Failed to create timer");
+    when_failed_trace(amxm_module_register(&s_pon_ctrl, amxm_so_get_current(), MOD_PON_CTRL),
+                      exit, ERROR, "Failed to register %s namespace", MOD_PON_CTRL);
+
+    for(int i = 0; PON_CTRL_FUNCTIONS[i].name != NULL; ++i) {
+        amxm_callback_t impl = PON_CTRL_FUNCTIONS[i].impl;
+        if(sim_replay_is_enabled() && (impl != set_max_nr_of_onus)) {
+            impl = replay_pon_ctrl;
+        }
+        if(amxm_module_add_function(s_pon_ctrl, PON_CTRL_FUNCTIONS[i].name, impl)) {
+            SAH_TRACEZ_ERROR(ME, "Failed to register %s.%s()", MOD_PON_CTRL,
+                             PON_CTRL_FUNCTIONS[i].name);
+            goto exit;
+        }
+    }
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+AMXM_DESTRUCTOR sim_exit(void) {
+    sim_storm_stop();
+    sim_replay_cleanup();
+    amxp_timer_delete(&s_timer_start);
+    amxp_timer_delete(&s_timer_async);
+    amxc_var_clean(&s_async_requests);
+    if(s_pon_ctrl) {
+        amxm_module_deregister(&s_pon_ctrl);
+    }
+    sim_topology_cleanup();
+    s_pon_stat = NULL;
+    return 0;
+}
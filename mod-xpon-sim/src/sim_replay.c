@@ -0,0 +1,583 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file sim_replay.c
+ *
+ * Replay of a capture of tr181-xpon. See xpon_capture.h.
+ *
+ * The module loads the capture file given by XPON_SIM_REPLAY. When tr181-xpon
+ * has passed the max number of ONUs, it calls the pon_stat functions of
+ * tr181-xpon as they were recorded: the calls which were not nested in another
+ * call, in the order of the capture. It keeps the original timing, or calls
+ * them as fast as possible if XPON_SIM_REPLAY_MAX_SPEED is 1.
+ *
+ * The module answers each pon_ctrl call of tr181-xpon with the return value
+ * of a recorded call of the same function with the same args. If a function
+ * was called several times with the same args, the answers follow the order
+ * of the capture, and the last one is repeated. A call without match fails.
+ *
+ * The calls of watch_file_descriptor_start() and watch_file_descriptor_stop()
+ * are not replayed: the file descriptors of the capture are meaningless.
+ *
+ * When all calls are replayed, the module writes a report to stderr and to the
+ * trace log: the throughput, the latency per pon_stat function compared to
+ * the capture, the number of pon_ctrl calls without match, and the number of
+ * calls whose return value differs from the capture.
+ */
+
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * 'CLOCK_MONOTONIC' undeclared
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* Related header */
+#include "sim_replay.h"
+
+/* System headers */
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>    /* fopen(), fprintf() */
+#include <stdlib.h>   /* free(), malloc() */
+#include <string.h>   /* memcmp(), strcmp() */
+#include <time.h>     /* clock_gettime() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxp/amxp_timer.h>
+#include <amxm/amxm.h>
+
+/* Own headers */
+#include "capture_codec.h" /* capture_decode_var() */
+#include "xpon_capture.h"
+
+#define MOD_PON_STAT "pon_stat"
+
+/** Number of calls replayed per timer expiry at max speed */
+#define REPLAY_CHUNK 64
+
+/**
+ * A record of the capture.
+ *
+ * - hdr       fixed part of the record
+ * - name      function name
+ * - args      encoded args: refers to the contents of the file
+ * - args_len  length of 'args'
+ * - ret       encoded return value: refers to the contents of the file
+ * - ret_len   length of 'ret'
+ */
+typedef struct _replay_record {
+    xpon_capture_record_t hdr;
+    char* name;
+    const uint8_t* args;
+    uint32_t args_len;
+    const uint8_t* ret;
+    uint32_t ret_len;
+} replay_record_t;
+
+/**
+ * Recorded answers to the pon_ctrl calls of a function with the same args.
+ *
+ * - it       iterator for s_replies. The key is the function name and the
+ *            encoded args.
+ * - records  indexes in s_records of the answers, in the order of the capture
+ * - nr       number of answers
+ * - next     index in 'records' of the next answer
+ */
+typedef struct _replay_reply {
+    amxc_htable_it_t it;
+    size_t* records;
+    size_t nr;
+    size_t next;
+} replay_reply_t;
+
+/**
+ * Statistics of the replayed calls of a pon_stat function.
+ *
+ * - it                 iterator for s_stats. The key is the function name.
+ * - calls              number of replayed calls
+ * - total_us           total latency of the replayed calls
+ * - max_us             max latency of the replayed calls
+ * - captured_total_us  total latency of the calls in the capture
+ */
+typedef struct _replay_stats {
+    amxc_htable_it_t it;
+    uint64_t calls;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t captured_total_us;
+} replay_stats_t;
+
+static const char* s_file = NULL;
+static bool s_max_speed = false;
+/** Contents of the capture file */
+static uint8_t* s_data = NULL;
+static replay_record_t* s_records = NULL;
+static size_t s_nr_of_records = 0;
+/** Indexes in s_records of the pon_stat calls to replay */
+static size_t* s_calls = NULL;
+static size_t s_nr_of_calls = 0;
+/** Index in s_calls of the next call to replay */
+static size_t s_next = 0;
+static amxc_htable_t s_replies;
+static amxc_htable_t s_stats;
+static amxp_timer_t* s_timer = NULL;
+/** Start of the replay, as returned by monotonic_us() */
+static uint64_t s_start_us = 0;
+static uint64_t s_unmatched = 0;
+static uint64_t s_rc_mismatches = 0;
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static void delete_reply(UNUSED const char* key, amxc_htable_it_t* it) {
+    replay_reply_t* const reply = amxc_container_of(it, replay_reply_t, it);
+    free(reply->records);
+    free(reply);
+}
+
+static void delete_stats(UNUSED const char* key, amxc_htable_it_t* it) {
+    free(amxc_container_of(it, replay_stats_t, it));
+}
+
+static bool read_file(const char* const file, size_t* const len) {
+    bool rv = false;
+    long size = 0;
+    FILE* const f = fopen(file, "rb");
+    when_null_trace(f, exit, ERROR, "Failed to open %s", file);
+
+    when_false_trace((fseek(f, 0, SEEK_END) == 0) && ((size = ftell(f)) >= 0) &&
+                     (fseek(f, 0, SEEK_SET) == 0), exit, ERROR,
+                     "Failed to get size of %s", file);
+    s_data = (uint8_t*) malloc((size_t) size + 1);
+    when_null_trace(s_data, exit, ERROR, "Failed to allocate memory");
+    when_false_trace(fread(s_data, 1, (size_t) size, f) == (size_t) size, exit, ERROR,
+                     "Failed to read %s", file);
+    *len = (size_t) size;
+    rv = true;
+
+exit:
+    if(f) {
+        fclose(f);
+    }
+    return rv;
+}
+
+/**
+ * Build the key for s_replies: the function name, a colon, and the encoded
+ * args in hexadecimal.
+ */
+static void build_key(amxc_string_t* const key, const char* const name,
+                      const uint8_t* const args, size_t args_len) {
+    static const char HEX[] = "0123456789abcdef";
+    amxc_string_reset(key);
+    amxc_string_appendf(key, "%s:", name);
+    for(size_t i = 0; i < args_len; ++i) {
+        const char byte[2] = { HEX[args[i] >> 4], HEX[args[i] & 0xf] };
+        amxc_string_append(key, byte, sizeof(byte));
+    }
+}
+
+static bool add_reply(size_t index) {
+    bool rv = false;
+    const replay_record_t* const record = &s_records[index];
+    replay_reply_t* reply = NULL;
+    amxc_string_t key;
+    amxc_string_init(&key, 0);
+
+    build_key(&key, record->name, record->args, record->args_len);
+    amxc_htable_it_t* const it = amxc_htable_get(&s_replies, amxc_string_get(&key, 0));
+    if(it) {
+        reply = amxc_container_of(it, replay_reply_t, it);
+    } else {
+        reply = (replay_reply_t*) calloc(1, sizeof(replay_reply_t));
+        when_null_trace(reply, exit, ERROR, "Failed to allocate memory");
+        amxc_htable_insert(&s_replies, amxc_string_get(&key, 0), &reply->it);
+    }
+    size_t* const records =
+        (size_t*) realloc(reply->records, (reply->nr + 1) * sizeof(size_t));
+    when_null_trace(records, exit, ERROR, "Failed to allocate memory");
+    reply->records = records;
+    reply->records[reply->nr++] = index;
+    rv = true;
+
+exit:
+    amxc_string_clean(&key);
+    return rv;
+}
+
+static bool add_call(size_t index) {
+    const replay_record_t* const record = &s_records[index];
+    if((strcmp(record->name, "watch_file_descriptor_start") == 0) ||
+       (strcmp(record->name, "watch_file_descriptor_stop") == 0)) {
+        return true;
+    }
+    size_t* const calls = (size_t*) realloc(s_calls, (s_nr_of_calls + 1) * sizeof(size_t));
+    when_null_trace(calls, error, ERROR, "Failed to allocate memory");
+    s_calls = calls;
+    s_calls[s_nr_of_calls++] = index;
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Parse the records of the capture, and index the pon_stat calls to replay
+ * and the answers to the pon_ctrl calls.
+ */
+static bool parse_records(size_t len) {
+    bool rv = false;
+    capture_reader_t reader = { .data = s_data, .len = len, .pos = 0 };
+    uint8_t version = 0;
+    char magic[XPON_CAPTURE_MAGIC_LEN];
+
+    when_false_trace(capture_read(&reader, magic, sizeof(magic)) &&
+                     (memcmp(magic, XPON_CAPTURE_MAGIC, sizeof(magic)) == 0) &&
+                     capture_read(&reader, &version, 1), exit, ERROR,
+                     "%s is not a capture of tr181-xpon", s_file);
+    when_false_trace(version == XPON_CAPTURE_VERSION, exit, ERROR,
+                     "%s: unsupported version: %u", s_file, version);
+
+    while(reader.pos < reader.len) {
+        replay_record_t record;
+        memset(&record, 0, sizeof(record));
+        when_false_trace(capture_read(&reader, &record.hdr, sizeof(record.hdr)),
+                         exit, ERROR, "%s: truncated record", s_file);
+        when_false_trace(reader.len - reader.pos >= record.hdr.name_len, exit, ERROR,
+                         "%s: truncated record", s_file);
+        record.name = strndup((const char*) reader.data + reader.pos, record.hdr.name_len);
+        when_null_trace(record.name, exit, ERROR, "Failed to allocate memory");
+        reader.pos += record.hdr.name_len;
+
+        replay_record_t* const records = (replay_record_t*)
+            realloc(s_records, (s_nr_of_records + 1) * sizeof(replay_record_t));
+        if(NULL == records) {
+            SAH_TRACEZ_ERROR(ME, "Failed to allocate memory");
+            free(record.name);
+            goto exit;
+        }
+        s_records = records;
+        s_records[s_nr_of_records++] = record;
+        replay_record_t* const added = &s_records[s_nr_of_records - 1];
+
+        when_false_trace(capture_read(&reader, &added->args_len, sizeof(uint32_t)) &&
+                         (reader.len - reader.pos >= added->args_len), exit, ERROR,
+                         "%s: truncated record", s_file);
+        added->args = reader.data + reader.pos;
+        reader.pos += added->args_len;
+        when_false_trace(capture_read(&reader, &added->ret_len, sizeof(uint32_t)) &&
+                         (reader.len - reader.pos >= added->ret_len), exit, ERROR,
+                         "%s: truncated record", s_file);
+        added->ret = reader.data + reader.pos;
+        reader.pos += added->ret_len;
+
+        if(XPON_CAPTURE_PON_CTRL == added->hdr.kind) {
+            when_false(add_reply(s_nr_of_records - 1), exit);
+        } else if((XPON_CAPTURE_PON_STAT == added->hdr.kind) && (0 == added->hdr.depth)) {
+            when_false(add_call(s_nr_of_records - 1), exit);
+        }
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+static replay_stats_t* get_stats(const char* const name) {
+    amxc_htable_it_t* const it = amxc_htable_get(&s_stats, name);
+    if(it) {
+        return amxc_container_of(it, replay_stats_t, it);
+    }
+    replay_stats_t* const stats = (replay_stats_t*) calloc(1, sizeof(replay_stats_t));
+    if(stats) {
+        amxc_htable_insert(&s_stats, name, &stats->it);
+    }
+    return stats;
+}
+
+/**
+ * Call the pon_stat function of a record in tr181-xpon.
+ */
+static void replay_call(const replay_record_t* const record) {
+    capture_reader_t reader = { .data = record->args, .len = record->args_len, .pos = 0 };
+    void* blob = NULL;
+    amxc_var_t args;
+    amxc_var_t ret;
+    amxc_var_init(&args);
+    amxc_var_init(&ret);
+
+    when_false_trace(capture_decode_var(&reader, &args, &blob), exit, ERROR,
+                     "%s(): failed to decode args", record->name);
+
+    const uint64_t start_us = monotonic_us();
+    const int rc = amxm_execute_function("self", MOD_PON_STAT, record->name, &args, &ret);
+    const uint64_t latency_us = monotonic_us() - start_us;
+
+    if(rc != record->hdr.rc) {
+        SAH_TRACEZ_WARNING(ME, "%s(): rc=%d, captured rc=%d", record->name, rc,
+                           record->hdr.rc);
+        ++s_rc_mismatches;
+    }
+    replay_stats_t* const stats = get_stats(record->name);
+    when_null_trace(stats, exit, ERROR, "Failed to allocate memory");
+    stats->calls++;
+    stats->total_us += latency_us;
+    stats->captured_total_us += record->hdr.latency_us;
+    if(latency_us > stats->max_us) {
+        stats->max_us = latency_us;
+    }
+
+exit:
+    amxc_var_clean(&args);
+    amxc_var_clean(&ret);
+    free(blob);
+}
+
+static void report(uint64_t wall_us) {
+    uint64_t calls = 0;
+    uint64_t busy_us = 0;
+
+    amxc_htable_for_each(it, &s_stats) {
+        const replay_stats_t* const stats = amxc_container_of(it, replay_stats_t, it);
+        calls += stats->calls;
+        busy_us += stats->total_us;
+    }
+    const double wall_s = (double) wall_us / 1000000;
+    const double calls_per_s = wall_us ? (double) calls / wall_s : 0;
+    fprintf(stderr, "%s: replayed %" PRIu64 " calls of %s in %.3f s: %.0f calls/s, "
+            "%" PRIu64 " us in tr181-xpon\n", ME, calls, s_file, wall_s, calls_per_s,
+            busy_us);
+    SAH_TRACEZ_WARNING(ME, "Replayed %" PRIu64 " calls of %s in %.3f s: %.0f calls/s, "
+                       "%" PRIu64 " us in tr181-xpon", calls, s_file, wall_s, calls_per_s,
+                       busy_us);
+
+    amxc_htable_for_each(it, &s_stats) {
+        const replay_stats_t* const stats = amxc_container_of(it, replay_stats_t, it);
+        const char* const name = amxc_htable_it_get_key(it);
+        const uint64_t avg_us = stats->total_us / stats->calls;
+        const uint64_t captured_avg_us = stats->captured_total_us / stats->calls;
+        fprintf(stderr, "%s:   %s: calls=%" PRIu64 " avg=%" PRIu64 " us max=%" PRIu64
+                " us captured_avg=%" PRIu64 " us\n", ME, name, stats->calls, avg_us,
+                stats->max_us, captured_avg_us);
+        SAH_TRACEZ_WARNING(ME, "%s: calls=%" PRIu64 " avg=%" PRIu64 " us max=%" PRIu64
+                           " us captured_avg=%" PRIu64 " us", name, stats->calls, avg_us,
+                           stats->max_us, captured_avg_us);
+    }
+    fprintf(stderr, "%s: pon_ctrl calls without match: %" PRIu64 ", rc mismatches: %"
+            PRIu64 "\n", ME, s_unmatched, s_rc_mismatches);
+    SAH_TRACEZ_WARNING(ME, "pon_ctrl calls without match: %" PRIu64 ", rc mismatches: %"
+                       PRIu64, s_unmatched, s_rc_mismatches);
+}
+
+/**
+ * Replay the calls which are due, and restart the timer for the next ones.
+ */
+static void replay_next(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    const uint64_t first_us = s_records[s_calls[0]].hdr.time_us;
+    uint32_t count = 0;
+    uint64_t now_us = monotonic_us();
+    uint32_t wait_ms = 0;
+
+    while(s_next < s_nr_of_calls) {
+        const replay_record_t* const record = &s_records[s_calls[s_next]];
+        if(s_max_speed) {
+            if(count == REPLAY_CHUNK) {
+                break;
+            }
+        } else {
+            const uint64_t due_us = s_start_us + (record->hdr.time_us - first_us);
+            if(due_us > now_us) {
+                wait_ms = (uint32_t) ((due_us - now_us) / 1000);
+                break;
+            }
+        }
+        replay_call(record);
+        ++s_next;
+        ++count;
+        now_us = monotonic_us();
+    }
+    if(s_next < s_nr_of_calls) {
+        amxp_timer_start(s_timer, wait_ms);
+    } else {
+        report(monotonic_us() - s_start_us);
+    }
+}
+
+/**
+ * Load and index the capture file given by XPON_SIM_REPLAY.
+ *
+ * @return true if replaying is disabled or if the capture is loaded, false on
+ *         error
+ */
+bool sim_replay_init(const sim_config_t* const config) {
+    bool rv = false;
+    size_t len = 0;
+
+    amxc_htable_init(&s_replies, 64);
+    amxc_htable_init(&s_stats, 16);
+    when_true_status((NULL == config->replay_file) || (config->replay_file[0] == '\0'),
+                     exit, rv = true);
+    s_file = config->replay_file;
+    s_max_speed = config->replay_max_speed;
+
+    when_false(read_file(s_file, &len), exit);
+    when_false(parse_records(len), exit);
+    when_failed_trace(amxp_timer_new(&s_timer, replay_next, NULL), exit, ERROR,
+                      "Failed to create timer");
+    SAH_TRACEZ_WARNING(ME, "Replaying %s: %zu records, %zu pon_stat calls, max_speed=%d",
+                       s_file, s_nr_of_records, s_nr_of_calls, s_max_speed);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+void sim_replay_cleanup(void) {
+    amxp_timer_delete(&s_timer);
+    amxc_htable_clean(&s_replies, delete_reply);
+    amxc_htable_clean(&s_stats, delete_stats);
+    for(size_t i = 0; i < s_nr_of_records; ++i) {
+        free(s_records[i].name);
+    }
+    free(s_records);
+    s_records = NULL;
+    s_nr_of_records = 0;
+    free(s_calls);
+    s_calls = NULL;
+    s_nr_of_calls = 0;
+    s_next = 0;
+    free(s_data);
+    s_data = NULL;
+    s_file = NULL;
+}
+
+/**
+ * Return true if the module replays a capture instead of simulating a
+ * topology.
+ */
+bool sim_replay_is_enabled(void) {
+    return (s_timer != NULL);
+}
+
+/**
+ * Start replaying the pon_stat calls of the capture.
+ */
+void sim_replay_start(void) {
+    when_null(s_timer, exit);
+    when_true_trace(0 == s_nr_of_calls, exit, WARNING, "%s: no calls to replay", s_file);
+    s_next = 0;
+    s_start_us = monotonic_us();
+    amxp_timer_start(s_timer, 0);
+
+exit:
+    return;
+}
+
+/**
+ * Answer a pon_ctrl call of tr181-xpon with a recorded answer.
+ *
+ * @param[in] name  function name
+ * @param[in] args  args of the call
+ * @param[out] ret  the recorded return value
+ *
+ * @return the recorded return value, -1 if there is no recorded call of
+ *         @a name with the same @a args
+ */
+int sim_replay_pon_ctrl(const char* const name, amxc_var_t* const args,
+                        amxc_var_t* const ret) {
+    int rc = -1;
+    capture_buf_t buf;
+    amxc_string_t key;
+    capture_buf_init(&buf);
+    amxc_string_init(&key, 0);
+
+    /* Encode as the plugin does, e.g. with the password redacted */
+    when_false_trace(capture_encode_pon_ctrl_args(&buf, name, args), exit, ERROR,
+                     "%s(): failed to encode args", name);
+    build_key(&key, name, buf.data, buf.len);
+    amxc_htable_it_t* const it = amxc_htable_get(&s_replies, amxc_string_get(&key, 0));
+    if(NULL == it) {
+        SAH_TRACEZ_WARNING(ME, "%s(): no match in capture", name);
+        ++s_unmatched;
+        goto exit;
+    }
+    replay_reply_t* const reply = amxc_container_of(it, replay_reply_t, it);
+    const replay_record_t* const record = &s_records[reply->records[reply->next]];
+    if(reply->next + 1 < reply->nr) {
+        reply->next++;
+    }
+    capture_reader_t reader = { .data = record->ret, .len = record->ret_len, .pos = 0 };
+    when_false_trace(capture_decode_var(&reader, ret, NULL), exit, ERROR,
+                     "%s(): failed to decode return value", name);
+    rc = record->hdr.rc;
+
+exit:
+    amxc_string_clean(&key);
+    capture_buf_clean(&buf);
+    return rc;
+}
@@ -0,0 +1,280 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/* Related header */
+#include "sim_storm.h"
+
+/* System headers */
+#include <stdio.h> /* snprintf() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxc/amxc.h>
+#include <amxp/amxp_timer.h>
+
+/* Own headers */
+#include "sim_topology.h" /* sim_topology_get_nr_of_onus() */
+
+/** Max length of a path */
+#define SIM_PATH_LEN 256
+
+typedef enum _storm_id {
+    storm_pm,
+    storm_gem_pm,
+    storm_alarm,
+    storm_mib_upload,
+    storm_reset_mib,
+    storm_nr
+} storm_id_t;
+
+/**
+ * An update storm.
+ *
+ * - name         name for log messages
+ * - handle       callback called at each interval
+ * - timer        periodic timer. NULL if the storm is disabled.
+ * - next_onu     index of the ONU the next MIB reset or upload is for
+ */
+typedef struct _storm {
+    const char* const name;
+    const amxp_timer_cb_t handle;
+    amxp_timer_t* timer;
+    uint32_t next_onu;
+} storm_t;
+
+static void handle_pm(amxp_timer_t* timer, void* priv);
+static void handle_gem_pm(amxp_timer_t* timer, void* priv);
+static void handle_alarm(amxp_timer_t* timer, void* priv);
+static void handle_mib_upload(amxp_timer_t* timer, void* priv);
+static void handle_reset_mib(amxp_timer_t* timer, void* priv);
+
+static storm_t s_storms[storm_nr] = {
+    [storm_pm] = { .name = "pm", .handle = handle_pm },
+    [storm_gem_pm] = { .name = "gem_pm", .handle = handle_gem_pm },
+    [storm_alarm] = { .name = "alarm", .handle = handle_alarm },
+    [storm_mib_upload] = { .name = "mib_upload", .handle = handle_mib_upload },
+    [storm_reset_mib] = { .name = "reset_mib", .handle = handle_reset_mib }
+};
+
+static const sim_config_t* s_config = NULL;
+
+/**
+ * Return the index of the ONU the next MIB reset or upload is for, 0 if there
+ * are no ONUs.
+ */
+static uint32_t next_onu(storm_t* const storm) {
+    const uint32_t nr_of_onus = sim_topology_get_nr_of_onus();
+    if(0 == nr_of_onus) {
+        return 0;
+    }
+    storm->next_onu = (storm->next_onu % nr_of_onus) + 1;
+    return storm->next_onu;
+}
+
+/**
+ * Push the PM counters of all ANIs with dm_update_ani_pm().
+ */
+static void handle_pm(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    const uint32_t nr_of_onus = sim_topology_get_nr_of_onus();
+    for(uint32_t onu = 1; onu <= nr_of_onus; ++onu) {
+        for(uint32_t ani = 1; ani <= s_config->nr_of_anis; ++ani) {
+            sim_dm_update_ani_pm(onu, ani);
+        }
+    }
+}
+
+/**
+ * Push the PM counters of all GEM ports with dm_object_changed().
+ */
+static void handle_gem_pm(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    char path[SIM_PATH_LEN];
+    amxc_var_t params;
+    amxc_var_init(&params);
+
+    const uint32_t nr_of_onus = sim_topology_get_nr_of_onus();
+    for(uint32_t onu = 1; onu <= nr_of_onus; ++onu) {
+        const uint32_t nr_of_gem_ports = sim_topology_get_nr_of_gem_ports(onu);
+        for(uint32_t ani = 1; ani <= s_config->nr_of_anis; ++ani) {
+            for(uint32_t gem_port = 1; gem_port <= nr_of_gem_ports; ++gem_port) {
+                snprintf(path, sizeof(path), "XPON.ONU.%u.ANI.%u.TC.GEM.Port.%u.PM",
+                         onu, ani, gem_port);
+                amxc_var_set_type(&params, AMXC_VAR_ID_HTABLE);
+                sim_topology_get_gem_port_pm(onu, ani, gem_port, &params);
+                sim_dm_object_changed(path, &params);
+            }
+        }
+    }
+    amxc_var_clean(&params);
+}
+
+/**
+ * Toggle an alarm of all ANIs and push it with dm_object_changed().
+ */
+static void handle_alarm(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    char path[SIM_PATH_LEN];
+    amxc_var_t params;
+    amxc_var_init(&params);
+
+    const uint32_t nr_of_onus = sim_topology_get_nr_of_onus();
+    for(uint32_t onu = 1; onu <= nr_of_onus; ++onu) {
+        for(uint32_t ani = 1; ani <= s_config->nr_of_anis; ++ani) {
+            snprintf(path, sizeof(path), "XPON.ONU.%u.ANI.%u.TC.Alarms", onu, ani);
+            amxc_var_set_type(&params, AMXC_VAR_ID_HTABLE);
+            sim_topology_toggle_alarm(onu, ani, &params);
+            sim_dm_object_changed(path, &params);
+        }
+    }
+    amxc_var_clean(&params);
+}
+
+/**
+ * Do a MIB reset and a MIB upload for the next ONU.
+ *
+ * The MIB upload recreates all GEM ports of the ONU with one dm_apply_batch()
+ * call, and sets its Ethernet UNIs up again.
+ */
+static void handle_mib_upload(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    const uint32_t onu = next_onu(&s_storms[storm_mib_upload]);
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    when_true(0 == onu, exit);
+
+    sim_topology_reset_mib(onu);
+    sim_omci_reset_mib(onu);
+
+    amxc_var_t* const ops = amxc_var_add_key(amxc_llist_t, &args, "operations", NULL);
+    sim_topology_upload_mib(onu, ops);
+    sim_dm_apply_batch(&args);
+
+exit:
+    amxc_var_clean(&args);
+}
+
+/**
+ * Do a MIB reset for the next ONU. The ONU has no GEM ports until the next
+ * MIB upload.
+ */
+static void handle_reset_mib(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    const uint32_t onu = next_onu(&s_storms[storm_reset_mib]);
+    when_true(0 == onu, exit);
+    sim_topology_reset_mib(onu);
+    sim_omci_reset_mib(onu);
+exit:
+    return;
+}
+
+static uint32_t interval_of(storm_id_t id) {
+    switch(id) {
+    case storm_pm: return s_config->pm_interval_ms;
+    case storm_gem_pm: return s_config->gem_pm_interval_ms;
+    case storm_alarm: return s_config->alarm_interval_ms;
+    case storm_mib_upload: return s_config->mib_upload_interval_ms;
+    case storm_reset_mib: return s_config->reset_mib_interval_ms;
+    default: break;
+    }
+    return 0;
+}
+
+/**
+ * Start the update storms with a nonzero interval.
+ *
+ * @param[in] config  configuration of the simulator. Must remain valid until
+ *                    sim_storm_stop() is called.
+ *
+ * @return true on success, else false
+ */
+bool sim_storm_start(const sim_config_t* const config) {
+    bool rv = false;
+
+    s_config = config;
+    for(uint32_t i = 0; i < storm_nr; ++i) {
+        storm_t* const storm = &s_storms[i];
+        const uint32_t interval_ms = interval_of((storm_id_t) i);
+        if(0 == interval_ms) {
+            continue;
+        }
+        if(amxp_timer_new(&storm->timer, storm->handle, NULL)) {
+            SAH_TRACEZ_ERROR(ME, "Failed to create timer for storm '%s'", storm->name);
+            goto exit;
+        }
+        amxp_timer_set_interval(storm->timer, interval_ms);
+        amxp_timer_start(storm->timer, interval_ms);
+        SAH_TRACEZ_INFO(ME, "Started storm '%s': interval=%u ms", storm->name, interval_ms);
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Stop all update storms.
+ */
+void sim_storm_stop(void) {
+    for(uint32_t i = 0; i < storm_nr; ++i) {
+        if(s_storms[i].timer) {
+            amxp_timer_delete(&s_storms[i].timer);
+        }
+        s_storms[i].next_onu = 0;
+    }
+}
@@ -0,0 +1,869 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/* Related header */
+#include "sim_topology.h"
+
+/* System headers */
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* calloc() */
+#include <string.h> /* strcmp() */
+#include <time.h>   /* time() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+
+/** Max number of instance indexes in a path, e.g. 3 for a GEM port */
+#define SIM_MAX_INDEXES 3
+/** Max length of a path */
+#define SIM_PATH_LEN 256
+/** Number of alarms of TC.Alarms */
+#define SIM_NR_OF_ALARMS 15
+
+typedef enum _sim_obj_id {
+    sim_obj_onu = 0,
+    sim_obj_software_image,
+    sim_obj_ethernet_uni,
+    sim_obj_ani,
+    sim_obj_onu_activation,
+    sim_obj_authentication,
+    sim_obj_performance_thresholds,
+    sim_obj_alarms,
+    sim_obj_gem_port,
+    sim_obj_transceiver,
+    sim_obj_pm_phy,
+    sim_obj_pm_gem,
+    sim_obj_pm_ploam,
+    sim_obj_pm_omci,
+    sim_obj_gem_port_pm,
+    sim_obj_nr,
+    sim_obj_unknown = sim_obj_nr
+} sim_obj_id_t;
+
+/**
+ * Function returning the number of instances of a template object.
+ *
+ * @param[in] idx  indexes of the ancestors of the template object
+ */
+typedef uint32_t (* sim_nr_of_instances_t)(const uint32_t* idx);
+
+/**
+ * Function adding the params of an object.
+ *
+ * @param[in] idx          indexes in the path of the object. For an instance,
+ *                         the last one is the index of the instance itself.
+ * @param[in,out] params   htable to which the function adds the params
+ */
+typedef void (* sim_add_params_t)(const uint32_t* idx, amxc_var_t* params);
+
+/**
+ * An object of the simulated topology.
+ *
+ * - generic_path     object path with all instance indexes replaced by 'x'
+ * - parent           parent object. sim_obj_unknown for XPON.ONU.
+ * - name             name relative to the parent, e.g. "TC.ONUActivation"
+ * - in_tree          true if get_object_tree() returns the object as child
+ *                    of its parent. This is the case for the objects
+ *                    tr181-xpon queries at startup.
+ * - key_name         name of the key param of a template object
+ * - key_prefix       if not NULL, the key is a string: this prefix followed
+ *                    by the instance index. Else the key is an uint32: the
+ *                    instance index minus 'key_offset'.
+ * - nr_of_instances  NULL for a singleton
+ * - add_params       adds the params of the object
+ */
+typedef struct _sim_object {
+    const char* generic_path;
+    sim_obj_id_t parent;
+    const char* name;
+    bool in_tree;
+    const char* key_name;
+    const char* key_prefix;
+    uint32_t key_offset;
+    sim_nr_of_instances_t nr_of_instances;
+    sim_add_params_t add_params;
+} sim_object_t;
+
+/** State of an ANI the update storms change */
+typedef struct _sim_ani {
+    uint32_t alarms;        /* bit 'i' is set if alarm 'i' is active */
+    uint32_t next_alarm;    /* alarm to toggle next */
+    uint64_t pm_ticks;      /* number of times the PM counters were read */
+} sim_ani_t;
+
+/** State of an ONU the update storms change */
+typedef struct _sim_onu {
+    bool mib_reset;         /* true if the MIB was reset but not uploaded */
+    sim_ani_t* anis;
+} sim_onu_t;
+
+static const sim_config_t* s_config = NULL;
+static sim_onu_t* s_onus = NULL;
+/** Number of ONUs reported: the configured number limited to the max */
+static uint32_t s_nr_of_onus = 0;
+
+static const char* const ALARM_NAMES[SIM_NR_OF_ALARMS] = {
+    "LOS", "LOF", "SF", "SD", "LCDG", "TF", "SUF", "MEM",
+    "DACT", "DIS", "MIS", "PEE", "RDI", "LODS", "ROGUE"
+};
+
+static sim_ani_t* get_ani(uint32_t onu, uint32_t ani) {
+    if((onu < 1) || (onu > s_nr_of_onus) || (ani < 1) || (ani > s_config->nr_of_anis)) {
+        return NULL;
+    }
+    return &s_onus[onu - 1].anis[ani - 1];
+}
+
+static uint32_t nr_of_onus(UNUSED const uint32_t* idx) {
+    return s_nr_of_onus;
+}
+
+static uint32_t nr_of_software_images(UNUSED const uint32_t* idx) {
+    return 2;
+}
+
+static uint32_t nr_of_unis(UNUSED const uint32_t* idx) {
+    return s_config->nr_of_unis;
+}
+
+static uint32_t nr_of_anis(UNUSED const uint32_t* idx) {
+    return s_config->nr_of_anis;
+}
+
+static uint32_t nr_of_gem_ports(const uint32_t* idx) {
+    return s_onus[idx[0] - 1].mib_reset ? 0 : s_config->nr_of_gem_ports;
+}
+
+static uint32_t nr_of_transceivers(UNUSED const uint32_t* idx) {
+    return 1;
+}
+
+static void add_onu_params(const uint32_t* idx, amxc_var_t* params) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "SIM%08u", idx[0]);
+    amxc_var_add_key(bool, params, "Enable", true);
+    amxc_var_add_key(cstring_t, params, "Version", "sim-1.0");
+    amxc_var_add_key(cstring_t, params, "EquipmentID", buf);
+    amxc_var_add_key(bool, params, "UsePPTPEthernetUNIasIFtoNonOmciDomain", false);
+}
+
+static void add_software_image_params(const uint32_t* idx, amxc_var_t* params) {
+    const bool first = (1 == idx[1]);
+    amxc_var_add_key(cstring_t, params, "Version", first ? "sim-1.0" : "sim-0.9");
+    amxc_var_add_key(bool, params, "IsCommitted", first);
+    amxc_var_add_key(bool, params, "IsActive", first);
+    amxc_var_add_key(bool, params, "IsValid", true);
+}
+
+static void add_ethernet_uni_params(const uint32_t* idx, amxc_var_t* params) {
+    char buf[64];
+    amxc_var_add_key(bool, params, "Enable", true);
+    amxc_var_add_key(cstring_t, params, "Status",
+                     s_onus[idx[0] - 1].mib_reset ? "Down" : "Up");
+    snprintf(buf, sizeof(buf), "XPON.ONU.%u.ANI.1", idx[0]);
+    amxc_var_add_key(csv_string_t, params, "ANIs", buf);
+    snprintf(buf, sizeof(buf), "%u", idx[1]);
+    amxc_var_add_key(cstring_t, params, "InterdomainID", buf);
+    snprintf(buf, sizeof(buf), "eth%u", idx[1] - 1);
+    amxc_var_add_key(cstring_t, params, "InterdomainName", buf);
+}
+
+static void add_ani_params(UNUSED const uint32_t* idx, amxc_var_t* params) {
+    amxc_var_add_key(bool, params, "Enable", true);
+    amxc_var_add_key(cstring_t, params, "Status", "Up");
+    amxc_var_add_key(cstring_t, params, "PONMode", "XGS-PON");
+}
+
+static void add_onu_activation_params(const uint32_t* idx, amxc_var_t* params) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "SIMU%04X%04X", idx[0] & 0xFFFF, idx[1] & 0xFFFF);
+    amxc_var_add_key(cstring_t, params, "ONUState", "O5");
+    amxc_var_add_key(cstring_t, params, "VendorID", "SIMU");
+    amxc_var_add_key(cstring_t, params, "SerialNumber", buf);
+    amxc_var_add_key(uint32_t, params, "ONUID", idx[0]);
+}
+
+static void add_authentication_params(UNUSED const uint32_t* idx, amxc_var_t* params) {
+    amxc_var_add_key(bool, params, "HexadecimalPassword", false);
+}
+
+static void add_performance_thresholds_params(UNUSED const uint32_t* idx,
+                                              amxc_var_t* params) {
+    amxc_var_add_key(uint32_t, params, "SignalFail", 5);
+    amxc_var_add_key(uint32_t, params, "SignalDegrade", 9);
+}
+
+static void add_alarms_params(const uint32_t* idx, amxc_var_t* params) {
+    const sim_ani_t* const ani = get_ani(idx[0], idx[1]);
+    for(uint32_t i = 0; i < SIM_NR_OF_ALARMS; ++i) {
+        amxc_var_add_key(bool, params, ALARM_NAMES[i], (ani->alarms >> i) & 1);
+    }
+}
+
+static void add_gem_port_params(const uint32_t* idx, amxc_var_t* params) {
+    /* Every 8th GEM port is a multicast port in the downstream direction */
+    const bool multicast = (0 == (idx[2] % 8));
+    amxc_var_add_key(cstring_t, params, "Direction",
+                     multicast ? "ANI-to-UNI" : "bidirectional");
+    amxc_var_add_key(cstring_t, params, "PortType", multicast ? "multicast" : "unicast");
+}
+
+/**
+ * Add the params of a Transceiver.
+ *
+ * The DDM values vary slowly over time, such that reads of the volatile
+ * params do not always return the same values.
+ */
+static void add_transceiver_params(const uint32_t* idx, amxc_var_t* params) {
+    const int32_t jitter = (int32_t) (((uint32_t) time(NULL) / 10 + idx[0] + idx[1]) % 20);
+    amxc_var_add_key(uint32_t, params, "Identifier", 3);
+    amxc_var_add_key(cstring_t, params, "VendorName", "SIMU");
+    amxc_var_add_key(cstring_t, params, "VendorPartNumber", "SIM-XGS-1");
+    amxc_var_add_key(cstring_t, params, "VendorRevision", "1.0");
+    amxc_var_add_key(cstring_t, params, "PONMode", "XGS-PON");
+    amxc_var_add_key(cstring_t, params, "Connector", "SC");
+    amxc_var_add_key(uint32_t, params, "NominalBitRateDownstream", 9953);
+    amxc_var_add_key(uint32_t, params, "NominalBitRateUpstream", 9953);
+    amxc_var_add_key(int32_t, params, "RxPower", -200 + jitter);
+    amxc_var_add_key(int32_t, params, "TxPower", 30 - (jitter / 4));
+    amxc_var_add_key(uint32_t, params, "Voltage", 33000 + (uint32_t) jitter * 10);
+    amxc_var_add_key(uint32_t, params, "Bias", 3000 + (uint32_t) jitter * 5);
+    amxc_var_add_key(int32_t, params, "Temperature", 45 + (jitter / 5));
+}
+
+static void add_pm_phy_params(const uint32_t* idx, amxc_var_t* params) {
+    pon_stat_ani_pm_t pm;
+    sim_topology_get_ani_pm(idx[0], idx[1], &pm);
+    amxc_var_add_key(uint64_t, params, "CorrectedFECBytes", pm.phy.corrected_fec_bytes);
+    amxc_var_add_key(uint64_t, params, "CorrectedFECCodewords", pm.phy.corrected_fec_codewords);
+    amxc_var_add_key(uint64_t, params, "UncorrectableFECCodewords", pm.phy.uncorrectable_fec_codewords);
+    amxc_var_add_key(uint64_t, params, "TotalFECCodewords", pm.phy.total_fec_codewords);
+    amxc_var_add_key(uint32_t, params, "PSBdHECErrorCount", pm.phy.psbd_hec_error_count);
+    amxc_var_add_key(uint32_t, params, "HeaderHECErrorCount", pm.phy.header_hec_error_count);
+    amxc_var_add_key(uint32_t, params, "UnknownProfile", pm.phy.unknown_profile);
+}
+
+static void add_pm_gem_params(const uint32_t* idx, amxc_var_t* params) {
+    pon_stat_ani_pm_t pm;
+    sim_topology_get_ani_pm(idx[0], idx[1], &pm);
+    amxc_var_add_key(uint64_t, params, "FramesSent", pm.gem.frames_sent);
+    amxc_var_add_key(uint64_t, params, "FramesReceived", pm.gem.frames_received);
+    amxc_var_add_key(uint32_t, params, "FrameHeaderHECErrors", pm.gem.frame_header_hec_errors);
+    amxc_var_add_key(uint32_t, params, "KeyErrors", pm.gem.key_errors);
+}
+
+static void add_pm_ploam_params(const uint32_t* idx, amxc_var_t* params) {
+    pon_stat_ani_pm_t pm;
+    sim_topology_get_ani_pm(idx[0], idx[1], &pm);
+    amxc_var_add_key(uint32_t, params, "MICErrors", pm.ploam.mic_errors);
+    amxc_var_add_key(uint64_t, params, "DownstreamMessageCount", pm.ploam.downstream_message_count);
+    amxc_var_add_key(uint64_t, params, "RangingTime", pm.ploam.ranging_time);
+    amxc_var_add_key(uint64_t, params, "UpstreamMessageCount", pm.ploam.upstream_message_count);
+}
+
+static void add_pm_omci_params(const uint32_t* idx, amxc_var_t* params) {
+    pon_stat_ani_pm_t pm;
+    sim_topology_get_ani_pm(idx[0], idx[1], &pm);
+    amxc_var_add_key(uint64_t, params, "BaselineMessagesReceived", pm.omci.baseline_messages_received);
+    amxc_var_add_key(uint64_t, params, "ExtendedMessagesReceived", pm.omci.extended_messages_received);
+    amxc_var_add_key(uint32_t, params, "MICErrors", pm.omci.mic_errors);
+}
+
+static void add_gem_port_pm_params(const uint32_t* idx, amxc_var_t* params) {
+    sim_topology_get_gem_port_pm(idx[0], idx[1], idx[2], params);
+}
+
+/**
+ * The objects of the simulated topology.
+ *
+ * The element at index 'i' must have the id 'i'. A parent must come before
+ * its children.
+ */
+static const sim_object_t OBJECTS[sim_obj_nr] = {
+    [sim_obj_onu] = {
+        .generic_path = "XPON.ONU", .parent = sim_obj_unknown, .name = "ONU",
+        .key_name = "Name", .key_prefix = "ONU",
+        .nr_of_instances = nr_of_onus, .add_params = add_onu_params
+    },
+    [sim_obj_software_image] = {
+        .generic_path = "XPON.ONU.x.SoftwareImage", .parent = sim_obj_onu,
+        .name = "SoftwareImage", .in_tree = true, .key_name = "ID", .key_offset = 1,
+        .nr_of_instances = nr_of_software_images, .add_params = add_software_image_params
+    },
+    [sim_obj_ethernet_uni] = {
+        .generic_path = "XPON.ONU.x.EthernetUNI", .parent = sim_obj_onu,
+        .name = "EthernetUNI", .in_tree = true, .key_name = "Name", .key_prefix = "UNI",
+        .nr_of_instances = nr_of_unis, .add_params = add_ethernet_uni_params
+    },
+    [sim_obj_ani] = {
+        .generic_path = "XPON.ONU.x.ANI", .parent = sim_obj_onu,
+        .name = "ANI", .in_tree = true, .key_name = "Name", .key_prefix = "ANI",
+        .nr_of_instances = nr_of_anis, .add_params = add_ani_params
+    },
+    [sim_obj_onu_activation] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.ONUActivation", .parent = sim_obj_ani,
+        .name = "TC.ONUActivation", .in_tree = true,
+        .add_params = add_onu_activation_params
+    },
+    [sim_obj_authentication] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.Authentication", .parent = sim_obj_ani,
+        .name = "TC.Authentication", .add_params = add_authentication_params
+    },
+    [sim_obj_performance_thresholds] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PerformanceThresholds", .parent = sim_obj_ani,
+        .name = "TC.PerformanceThresholds", .in_tree = true,
+        .add_params = add_performance_thresholds_params
+    },
+    [sim_obj_alarms] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.Alarms", .parent = sim_obj_ani,
+        .name = "TC.Alarms", .in_tree = true, .add_params = add_alarms_params
+    },
+    [sim_obj_gem_port] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.GEM.Port", .parent = sim_obj_ani,
+        .name = "TC.GEM.Port", .in_tree = true, .key_name = "PortID",
+        .nr_of_instances = nr_of_gem_ports, .add_params = add_gem_port_params
+    },
+    [sim_obj_transceiver] = {
+        .generic_path = "XPON.ONU.x.ANI.x.Transceiver", .parent = sim_obj_ani,
+        .name = "Transceiver", .in_tree = true, .key_name = "ID", .key_offset = 1,
+        .nr_of_instances = nr_of_transceivers, .add_params = add_transceiver_params
+    },
+    [sim_obj_pm_phy] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.PHY", .parent = sim_obj_ani,
+        .name = "TC.PM.PHY", .add_params = add_pm_phy_params
+    },
+    [sim_obj_pm_gem] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.GEM", .parent = sim_obj_ani,
+        .name = "TC.PM.GEM", .add_params = add_pm_gem_params
+    },
+    [sim_obj_pm_ploam] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.PLOAM", .parent = sim_obj_ani,
+        .name = "TC.PM.PLOAM", .add_params = add_pm_ploam_params
+    },
+    [sim_obj_pm_omci] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.OMCI", .parent = sim_obj_ani,
+        .name = "TC.PM.OMCI", .add_params = add_pm_omci_params
+    },
+    [sim_obj_gem_port_pm] = {
+        .generic_path = "XPON.ONU.x.ANI.x.TC.GEM.Port.x.PM", .parent = sim_obj_gem_port,
+        .name = "PM", .add_params = add_gem_port_pm_params
+    }
+};
+
+/**
+ * Return the number of template objects from the root to an object, the
+ * object included.
+ */
+static uint32_t depth_of(sim_obj_id_t id) {
+    uint32_t depth = 0;
+    for(; id != sim_obj_unknown; id = OBJECTS[id].parent) {
+        if(OBJECTS[id].nr_of_instances) {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+/**
+ * Classify a path.
+ *
+ * @param[in] path         path of a singleton, a template or an instance
+ * @param[out] idx         the instance indexes in @a path
+ * @param[out] nr_of_idx   the number of indexes in @a idx
+ * @param[out] instance    true if @a path ends with an instance index
+ *
+ * The function also checks if the instances referred to by the indexes
+ * exist.
+ *
+ * @return the object @a path refers to, sim_obj_unknown if it does not exist
+ */
+static sim_obj_id_t classify(const char* const path, uint32_t idx[SIM_MAX_INDEXES],
+                             uint32_t* nr_of_idx, bool* instance) {
+
+    sim_obj_id_t id = sim_obj_unknown;
+    char generic[SIM_PATH_LEN] = "";
+    size_t len = 0;
+    const char* token = path;
+    uint32_t n = 0;
+
+    *instance = false;
+    when_null(path, exit);
+    while(*token) {
+        const size_t token_len = strcspn(token, ".");
+        const bool numeric = (token_len > 0) && (strspn(token, "0123456789") == token_len);
+        if(numeric) {
+            when_true(n == SIM_MAX_INDEXES, exit);
+            idx[n++] = (uint32_t) strtoul(token, NULL, 10);
+        }
+        const int written = snprintf(generic + len, SIM_PATH_LEN - len, "%s%.*s",
+                                     len ? "." : "", numeric ? 1 : (int) token_len,
+                                     numeric ? "x" : token);
+        when_true((written < 0) || ((size_t) written >= SIM_PATH_LEN - len), exit);
+        len += (size_t) written;
+        token += token_len;
+        if(*token == '.') {
+            token++;
+        }
+    }
+    if((len > 2) && (strcmp(generic + len - 2, ".x") == 0)) {
+        generic[len - 2] = '\0';
+        *instance = true;
+    }
+    for(uint32_t i = 0; i < sim_obj_nr; ++i) {
+        if(strcmp(OBJECTS[i].generic_path, generic) == 0) {
+            id = (sim_obj_id_t) i;
+            break;
+        }
+    }
+    when_true(sim_obj_unknown == id, exit);
+
+    /**
+     * Check that the instances in the path exist, from the root on: the
+     * number of instances of a template depends on the indexes before it.
+     */
+    sim_obj_id_t chain[sim_obj_nr];
+    uint32_t len_chain = 0;
+    for(sim_obj_id_t obj = id; obj != sim_obj_unknown; obj = OBJECTS[obj].parent) {
+        if(OBJECTS[obj].nr_of_instances && ((obj != id) || *instance)) {
+            chain[len_chain++] = obj;
+        }
+    }
+    while(len_chain > 0) {
+        const sim_obj_id_t obj = chain[--len_chain];
+        const uint32_t depth = depth_of(obj);
+        if((depth > n) || (idx[depth - 1] < 1) ||
+           (idx[depth - 1] > OBJECTS[obj].nr_of_instances(idx))) {
+            id = sim_obj_unknown;
+            break;
+        }
+    }
+
+exit:
+    *nr_of_idx = n;
+    return id;
+}
+
+/**
+ * Add the keys and params of an object to @a node.
+ */
+static void add_content(sim_obj_id_t id, const uint32_t* idx, uint32_t nr_of_idx,
+                        bool instance, amxc_var_t* const node) {
+    const sim_object_t* const obj = &OBJECTS[id];
+
+    amxc_var_set_type(node, AMXC_VAR_ID_HTABLE);
+    if(instance && obj->key_name) {
+        char key[32];
+        amxc_var_t* const keys = amxc_var_add_key(amxc_htable_t, node, "keys", NULL);
+        const uint32_t index = idx[nr_of_idx - 1];
+        if(obj->key_prefix) {
+            snprintf(key, sizeof(key), "%s%u", obj->key_prefix, index);
+            amxc_var_add_key(cstring_t, keys, obj->key_name, key);
+        } else {
+            amxc_var_add_key(uint32_t, keys, obj->key_name, index - obj->key_offset);
+        }
+    }
+    amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, node, "parameters", NULL);
+    obj->add_params(idx, params);
+}
+
+/**
+ * Add the content of an object and of all its descendants to @a node.
+ *
+ * @param[in,out] idx  has room for SIM_MAX_INDEXES indexes. The function uses
+ *                     the elements from @a nr_of_idx on as scratch space.
+ */
+static void add_tree(sim_obj_id_t id, uint32_t* idx, uint32_t nr_of_idx,
+                     bool instance, amxc_var_t* const node) {
+
+    amxc_var_t* children = NULL;
+
+    add_content(id, idx, nr_of_idx, instance, node);
+    for(uint32_t i = 0; i < sim_obj_nr; ++i) {
+        const sim_object_t* const child = &OBJECTS[i];
+        if((child->parent != id) || !child->in_tree) {
+            continue;
+        }
+        if(NULL == children) {
+            children = amxc_var_add_key(amxc_htable_t, node, "children", NULL);
+        }
+        amxc_var_t* const child_node =
+            amxc_var_add_key(amxc_htable_t, children, child->name, NULL);
+        if(NULL == child->nr_of_instances) {
+            add_tree((sim_obj_id_t) i, idx, nr_of_idx, false, child_node);
+            continue;
+        }
+        amxc_var_t* const instances =
+            amxc_var_add_key(amxc_llist_t, child_node, "instances", NULL);
+        const uint32_t n = child->nr_of_instances(idx);
+        for(uint32_t index = 1; index <= n; ++index) {
+            amxc_var_t* const inst = amxc_var_add(amxc_htable_t, instances, NULL);
+            idx[nr_of_idx] = index;
+            add_tree((sim_obj_id_t) i, idx, nr_of_idx + 1, true, inst);
+            amxc_var_add_key(uint32_t, inst, "index", index);
+        }
+    }
+}
+
+/**
+ * Initialize the topology.
+ *
+ * @param[in] config  configuration of the simulator. Must remain valid until
+ *                    sim_topology_cleanup() is called.
+ *
+ * @return true on success, else false
+ */
+bool sim_topology_init(const sim_config_t* const config) {
+    bool rv = false;
+
+    s_config = config;
+    s_nr_of_onus = config->nr_of_onus;
+    s_onus = (sim_onu_t*) calloc(config->nr_of_onus, sizeof(sim_onu_t));
+    when_null_trace(s_onus, exit, ERROR, "Failed to allocate %u ONUs", config->nr_of_onus);
+    for(uint32_t i = 0; i < config->nr_of_onus; ++i) {
+        s_onus[i].anis = (sim_ani_t*) calloc(config->nr_of_anis, sizeof(sim_ani_t));
+        when_null_trace(s_onus[i].anis, exit, ERROR, "Failed to allocate ANIs");
+    }
+    rv = true;
+
+exit:
+    if(!rv) {
+        sim_topology_cleanup();
+    }
+    return rv;
+}
+
+void sim_topology_cleanup(void) {
+    if(s_onus) {
+        for(uint32_t i = 0; i < s_config->nr_of_onus; ++i) {
+            free(s_onus[i].anis);
+        }
+        free(s_onus);
+        s_onus = NULL;
+    }
+    s_nr_of_onus = 0;
+}
+
+/**
+ * Limit the number of ONUs to the max number of ONUs tr181-xpon supports.
+ */
+void sim_topology_set_max_nr_of_onus(uint32_t max) {
+    if(s_config && (max < s_config->nr_of_onus)) {
+        SAH_TRACEZ_WARNING(ME, "Limit nr of ONUs from %u to %u", s_config->nr_of_onus, max);
+        s_nr_of_onus = max;
+    }
+}
+
+uint32_t sim_topology_get_nr_of_onus(void) {
+    return s_nr_of_onus;
+}
+
+/**
+ * Return the number of GEM ports per ANI of an ONU: 0 after a MIB reset.
+ */
+uint32_t sim_topology_get_nr_of_gem_ports(uint32_t onu) {
+    const uint32_t idx[SIM_MAX_INDEXES] = { onu, 0, 0 };
+    return ((onu < 1) || (onu > s_nr_of_onus)) ? 0 : nr_of_gem_ports(idx);
+}
+
+/**
+ * Implementation of pon_ctrl.get_list_of_instances().
+ */
+int sim_get_list_of_instances(const char* const path, amxc_var_t* const ret) {
+    int rc = -1;
+    uint32_t idx[SIM_MAX_INDEXES];
+    uint32_t n = 0;
+    bool instance = false;
+    amxc_string_t indexes;
+    amxc_string_init(&indexes, 0);
+
+    const sim_obj_id_t id = classify(path, idx, &n, &instance);
+    when_true_trace((sim_obj_unknown == id) || instance ||
+                    (NULL == OBJECTS[id].nr_of_instances), exit, ERROR,
+                    "%s: not a template", path);
+
+    const uint32_t nr = OBJECTS[id].nr_of_instances(idx);
+    for(uint32_t i = 1; i <= nr; ++i) {
+        amxc_string_appendf(&indexes, "%s%u", (i > 1) ? "," : "", i);
+    }
+    amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, ret, "indexes", amxc_string_get(&indexes, 0));
+    rc = 0;
+
+exit:
+    amxc_string_clean(&indexes);
+    return rc;
+}
+
+/**
+ * Implementation of pon_ctrl.get_object_content().
+ */
+int sim_get_object_content(const char* const path, uint32_t index,
+                           amxc_var_t* const ret) {
+    int rc = -1;
+    uint32_t idx[SIM_MAX_INDEXES + 1];
+    uint32_t n = 0;
+    bool instance = false;
+
+    const sim_obj_id_t id = classify(path, idx, &n, &instance);
+    when_true_trace((sim_obj_unknown == id) || instance, exit, ERROR,
+                    "%s: unknown object", path);
+    if(OBJECTS[id].nr_of_instances) {
+        when_true_trace((index < 1) || (index > OBJECTS[id].nr_of_instances(idx)),
+                        exit, ERROR, "%s.%u: no such instance", path, index);
+        idx[n++] = index;
+    }
+    add_content(id, idx, n, (index != 0), ret);
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Implementation of pon_ctrl.get_object_tree().
+ */
+int sim_get_object_tree(const char* const path, uint32_t index,
+                        amxc_var_t* const ret) {
+    int rc = -1;
+    uint32_t idx[SIM_MAX_INDEXES + 1];
+    uint32_t n = 0;
+    bool instance = false;
+
+    const sim_obj_id_t id = classify(path, idx, &n, &instance);
+    when_true_trace((sim_obj_unknown == id) || instance, exit, ERROR,
+                    "%s: unknown object", path);
+    if(OBJECTS[id].nr_of_instances) {
+        when_true_trace((index < 1) || (index > OBJECTS[id].nr_of_instances(idx)),
+                        exit, ERROR, "%s.%u: no such instance", path, index);
+        idx[n++] = index;
+    }
+    add_tree(id, idx, n, (index != 0), ret);
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Implementation of pon_ctrl.get_param_values().
+ *
+ * @param[in] path            path of a singleton or an instance
+ * @param[in] names           comma-separated list of param names
+ * @param[in,out] parameters  htable to which the function adds the values
+ */
+int sim_get_param_values(const char* const path, const char* const names,
+                         amxc_var_t* const parameters) {
+    int rc = -1;
+    uint32_t idx[SIM_MAX_INDEXES];
+    uint32_t n = 0;
+    bool instance = false;
+    amxc_var_t all;
+    amxc_var_init(&all);
+    amxc_var_set_type(&all, AMXC_VAR_ID_HTABLE);
+
+    const sim_obj_id_t id = classify(path, idx, &n, &instance);
+    when_true_trace((sim_obj_unknown == id) ||
+                    (instance != (NULL != OBJECTS[id].nr_of_instances)), exit, ERROR,
+                    "%s: unknown object", path);
+    when_null_trace(names, exit, ERROR, "%s: names is NULL", path);
+
+    OBJECTS[id].add_params(idx, &all);
+    const char* name = names;
+    while(*name) {
+        char buf[64];
+        const size_t len = strcspn(name, ",");
+        snprintf(buf, sizeof(buf), "%.*s", (int) len, name);
+        amxc_var_t* const value = GET_ARG(&all, buf);
+        when_null_trace(value, exit, ERROR, "%s: unknown param: %s", path, buf);
+        amxc_var_set_key(parameters, buf, value, AMXC_VAR_FLAG_COPY);
+        name += len;
+        if(*name == ',') {
+            name++;
+        }
+    }
+    rc = 0;
+
+exit:
+    amxc_var_clean(&all);
+    return rc;
+}
+
+/**
+ * Simulate a MIB reset of an ONU: it has no GEM ports anymore, and its
+ * Ethernet UNIs are down until the next MIB upload.
+ */
+void sim_topology_reset_mib(uint32_t onu) {
+    when_true((onu < 1) || (onu > s_nr_of_onus), exit);
+    s_onus[onu - 1].mib_reset = true;
+exit:
+    return;
+}
+
+/**
+ * Simulate a MIB upload of an ONU.
+ *
+ * @param[in] onu      index of the ONU
+ * @param[in,out] ops  list to which the function appends the batch operations
+ *                     for dm_apply_batch(): an 'add' operation per GEM port
+ *                     and a 'change' operation per Ethernet UNI
+ */
+void sim_topology_upload_mib(uint32_t onu, amxc_var_t* const ops) {
+    char path[SIM_PATH_LEN];
+    uint32_t idx[SIM_MAX_INDEXES] = { onu, 0, 0 };
+
+    when_true((onu < 1) || (onu > s_nr_of_onus), exit);
+    s_onus[onu - 1].mib_reset = false;
+
+    for(uint32_t ani = 1; ani <= s_config->nr_of_anis; ++ani) {
+        snprintf(path, sizeof(path), "XPON.ONU.%u.ANI.%u.TC.GEM.Port", onu, ani);
+        idx[1] = ani;
+        for(uint32_t gem_port = 1; gem_port <= s_config->nr_of_gem_ports; ++gem_port) {
+            amxc_var_t* const op = amxc_var_add(amxc_htable_t, ops, NULL);
+            idx[2] = gem_port;
+            add_content(sim_obj_gem_port, idx, 3, true, op);
+            amxc_var_add_key(cstring_t, op, "action", "add");
+            amxc_var_add_key(cstring_t, op, "path", path);
+            amxc_var_add_key(uint32_t, op, "index", gem_port);
+        }
+    }
+    for(uint32_t uni = 1; uni <= s_config->nr_of_unis; ++uni) {
+        amxc_var_t* const op = amxc_var_add(amxc_htable_t, ops, NULL);
+        snprintf(path, sizeof(path), "XPON.ONU.%u.EthernetUNI.%u", onu, uni);
+        amxc_var_add_key(cstring_t, op, "action", "change");
+        amxc_var_add_key(cstring_t, op, "path", path);
+        amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, op, "parameters", NULL);
+        amxc_var_add_key(cstring_t, params, "Status", "Up");
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Toggle the next alarm of an ANI.
+ *
+ * @param[in,out] parameters  htable to which the function adds the new value
+ *                            of the toggled alarm
+ */
+void sim_topology_toggle_alarm(uint32_t onu, uint32_t ani, amxc_var_t* const parameters) {
+    sim_ani_t* const state = get_ani(onu, ani);
+    when_null(state, exit);
+
+    const uint32_t alarm = state->next_alarm;
+    state->alarms ^= (1U << alarm);
+    state->next_alarm = (alarm + 1) % SIM_NR_OF_ALARMS;
+    amxc_var_add_key(bool, parameters, ALARM_NAMES[alarm], (state->alarms >> alarm) & 1);
+
+exit:
+    return;
+}
+
+/**
+ * Get the next PM counters of an ANI.
+ *
+ * The counters increase at each call.
+ */
+void sim_topology_get_ani_pm(uint32_t onu, uint32_t ani, pon_stat_ani_pm_t* const pm) {
+    sim_ani_t* const state = get_ani(onu, ani);
+
+    memset(pm, 0, sizeof(pon_stat_ani_pm_t));
+    pm->version = PON_STAT_ANI_PM_VERSION;
+    pm->size = sizeof(pon_stat_ani_pm_t);
+    pm->groups = PON_STAT_ANI_PM_PHY | PON_STAT_ANI_PM_GEM |
+        PON_STAT_ANI_PM_PLOAM | PON_STAT_ANI_PM_OMCI;
+    pm->onu_index = onu;
+    pm->ani_index = ani;
+    when_null(state, exit);
+
+    const uint64_t t = ++state->pm_ticks;
+    pm->phy.corrected_fec_bytes = t * 64;
+    pm->phy.corrected_fec_codewords = t * 4;
+    pm->phy.uncorrectable_fec_codewords = t / 16;
+    pm->phy.total_fec_codewords = t * 10000;
+    pm->phy.psbd_hec_error_count = (uint32_t) (t / 100);
+    pm->phy.header_hec_error_count = (uint32_t) (t / 50);
+    pm->gem.frames_sent = t * 5000;
+    pm->gem.frames_received = t * 20000;
+    pm->gem.frame_header_hec_errors = (uint32_t) (t / 10);
+    pm->ploam.downstream_message_count = t * 10;
+    pm->ploam.ranging_time = 42;
+    pm->ploam.upstream_message_count = t * 2;
+    pm->omci.baseline_messages_received = t * 3;
+
+exit:
+    return;
+}
+
+/**
+ * Get the PM counters of a GEM port.
+ *
+ * @param[in,out] parameters  htable to which the function adds the counters
+ *
+ * The counters increase with the time, such that the GEM ports do not need
+ * any state.
+ */
+void sim_topology_get_gem_port_pm(uint32_t onu, uint32_t ani, uint32_t gem_port,
+                                  amxc_var_t* const parameters) {
+    const uint64_t t = (uint64_t) time(NULL) + onu + ani;
+    amxc_var_add_key(uint64_t, parameters, "FramesSent", t * (100 + gem_port));
+    amxc_var_add_key(uint64_t, parameters, "FramesReceived", t * (400 + gem_port));
+}
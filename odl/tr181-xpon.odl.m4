@@ -20,6 +20,80 @@
         "nm_populate" = 200
     };
 
+    // Write-behind buffer for updates from the vendor module. Per object name
+    // as in OBJECT_INFO in dm_info.c: the max time in ms the plugin merges
+    // updates for the same object before writing them to the DM. Objects
+    // not listed here, or with value 0, are updated immediately.
+    coalesce_interval_ms = {
+        "TC.PM.PHY" = 0,
+        "TC.PM.GEM" = 0,
+        "TC.PM.PLOAM" = 0,
+        "TC.PM.OMCI" = 0,
+        "GEMPort.PM" = 0
+    };
+
+    // Update policy per object name as in OBJECT_INFO in dm_info.c:
+    // - "push": the vendor module pushes updates (default)
+    // - "pull": the plugin queries a param in the vendor module when it's read
+    // - "pull:<ms>": the plugin queries all params of the object when one is
+    //   read, and serves the next reads during <ms> from the DM.
+    // Only the objects listed here support a pull policy.
+    update_policy = {
+        "TC.PM.PHY" = "push",
+        "TC.PM.GEM" = "push",
+        "TC.PM.PLOAM" = "push",
+        "TC.PM.OMCI" = "push",
+        "GEMPort.PM" = "push"
+    };
+
+    // Time in ms the plugin serves reads of the volatile parameters of a
+    // Transceiver instance from a snapshot, before it asks the vendor module
+    // for a new snapshot. 0 disables the cache.
+    trx_cache_ttl_ms = 1000;
+
+    // Interval in ms at which a background sampler takes a snapshot of the
+    // volatile parameters of each Transceiver instance. Reads are then served
+    // from the latest sample. 0 disables the sampler.
+    trx_sample_interval_ms = 0;
+
+    // Number of samples per Transceiver instance over which the sampler
+    // calculates the min, max and average, e.g. RxPowerAvg.
+    trx_sample_window = 60;
+
+    // Max time in ms the plugin spends at once on populating the DM at
+    // startup before it yields to the event loop.
+    pplt_task_slice_ms = 5;
+
+    // Max number of ONUs on the board, e.g. the number of PON IFs. It
+    // defaults to the value set at compile time. 0 also selects that value.
+    max_nr_of_onus = ifdef(`CONFIG_SAH_AMX_TR181_XPON_MAX_ONUS', CONFIG_SAH_AMX_TR181_XPON_MAX_ONUS, 0);
+
+    // Minimum time in ms between 2 changes of the Status of an EthernetUNI or
+    // ANI instance. If the vendor module changes Status faster, the plugin
+    // holds back the new value until that time has passed. 0 disables the
+    // flap damping.
+    status_damping_ms = 0;
+
+    // File with the snapshot of the DM the plugin loads at startup (warm
+    // start). Keep it on tmpfs, in a directory only the plugin can write to.
+    // An empty string disables the warm start.
+    dm_snapshot_file = "";
+
+    // Interval in ms to save the DM snapshot. The plugin also saves it when
+    // it stops. 0 disables the periodic save.
+    dm_snapshot_interval_ms = 60000;
+
+    // If true, omci_reset_mib() emits one 'omci:reset-mib' event per ONU
+    // instead of an event per removed GEM port. The DM still emits the usual
+    // event per Ethernet UNI going down.
+    omci_reset_mib_aggregated_event = false;
+
+    // File to which the plugin writes each call between the plugin and the
+    // vendor module, to replay it with mod-xpon-sim. It grows without limit:
+    // only set it while reproducing an issue. An empty string disables the
+    // capture.
+    capture_file = "";
+
     NetModel = "nm_EUNI";
     nm_EUNI = {
         InstancePath = "XPON\.ONU\..*\.EthernetUNI.",
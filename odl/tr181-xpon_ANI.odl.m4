@@ -162,6 +162,24 @@
             on action read call lastchange_on_read;
         }
 
+        /**
+            Number of times the vendor module changed Status from Up to another
+            value. It includes the changes held back by the flap damping,
+            configured with the config option 'status_damping_ms'.
+        */
+        %protected %read-only %volatile uint32 StatusFlaps {
+            on action read call status_history_on_read;
+        }
+
+        /**
+            Comma-separated list with the last Status changes, newest first.
+            Each element has the format "<Status>:<seconds since change>",
+            e.g. "Up:12,Down:15".
+        */
+        %protected %read-only %volatile string StatusHistory {
+            on action read call status_history_on_read;
+        }
+
         /**
             PON mode.
 
@@ -320,42 +338,86 @@
                     PHY PM.
                 */
                 object PHY {
-                    %read-only uint64 CorrectedFECBytes;
-                    %read-only uint64 CorrectedFECCodewords;
-                    %read-only uint64 UncorrectableFECCodewords;
-                    %read-only uint64 TotalFECCodewords;
-                    %read-only uint32 PSBdHECErrorCount;
-                    %read-only uint32 HeaderHECErrorCount;
-                    %read-only uint32 UnknownProfile;
+                    on action destroy call pulled_object_destroyed;
+
+                    %read-only uint64 CorrectedFECBytes {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 CorrectedFECCodewords {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 UncorrectableFECCodewords {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 TotalFECCodewords {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 PSBdHECErrorCount {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 HeaderHECErrorCount {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 UnknownProfile {
+                        on action read call read_coalesced_param;
+                    }
                 }
 
                 /**
                     (X)GEM PM.
                 */
                 object GEM {
-                    %read-only uint64 FramesSent;
-                    %read-only uint64 FramesReceived;
-                    %read-only uint32 FrameHeaderHECErrors;
-                    %read-only uint32 KeyErrors;
+                    on action destroy call pulled_object_destroyed;
+
+                    %read-only uint64 FramesSent {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 FramesReceived {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 FrameHeaderHECErrors {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 KeyErrors {
+                        on action read call read_coalesced_param;
+                    }
                 }
 
                 /**
                     PLOAM PM.
                 */
                 object PLOAM {
-                    %read-only uint32 MICErrors;
-                    %read-only uint64 DownstreamMessageCount;
-                    %read-only uint64 RangingTime;
-                    %read-only uint64 UpstreamMessageCount;
+                    on action destroy call pulled_object_destroyed;
+
+                    %read-only uint32 MICErrors {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 DownstreamMessageCount {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 RangingTime {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 UpstreamMessageCount {
+                        on action read call read_coalesced_param;
+                    }
                 }
 
                 /**
                     OMCI PM.
                 */
                 object OMCI {
-                    %read-only uint64 BaselineMessagesReceived;
-                    %read-only uint64 ExtendedMessagesReceived;
-                    %read-only uint32 MICErrors;
+                    on action destroy call pulled_object_destroyed;
+
+                    %read-only uint64 BaselineMessagesReceived {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint64 ExtendedMessagesReceived {
+                        on action read call read_coalesced_param;
+                    }
+                    %read-only uint32 MICErrors {
+                        on action read call read_coalesced_param;
+                    }
                 }
             }
 
@@ -410,8 +472,14 @@
                         Performance monitoring (PM) counters for this (X)GEM port.
                     */
                     object PM {
-                        %read-only uint64 FramesSent;
-                        %read-only uint64 FramesReceived;
+                        on action destroy call pulled_object_destroyed;
+
+                        %read-only uint64 FramesSent {
+                            on action read call read_coalesced_param;
+                        }
+                        %read-only uint64 FramesReceived {
+                            on action read call read_coalesced_param;
+                        }
                     }
                 }
             }
@@ -484,6 +552,7 @@
         */
         %read-only object Transceiver[2] {
             counted with TransceiverNumberOfEntries;
+            on action destroy call trx_destroyed;
 
             /**
                 The ID as assigned by the CPE to this Transceiver entry.
@@ -568,6 +637,89 @@
                 on action read call read_trx_param;
                 on action validate call check_minimum -274;
             }
+
+            /*
+                Minimum, maximum and average of the parameters above over the
+                samples taken by the background sampler. The sampler is
+                configured with the config options 'trx_sample_interval_ms' and
+                'trx_sample_window'. The value is 0 as long as there are no
+                samples.
+            */
+
+            // Minimum measured RX power in 0.1 dBm.
+            %read-only %volatile int32 RxPowerMin {
+                on action read call read_trx_window_param;
+            }
+
+            // Maximum measured RX power in 0.1 dBm.
+            %read-only %volatile int32 RxPowerMax {
+                on action read call read_trx_window_param;
+            }
+
+            // Average measured RX power in 0.1 dBm.
+            %read-only %volatile int32 RxPowerAvg {
+                on action read call read_trx_window_param;
+            }
+
+            // Minimum measured TX power in 0.1 dBm.
+            %read-only %volatile int32 TxPowerMin {
+                on action read call read_trx_window_param;
+            }
+
+            // Maximum measured TX power in 0.1 dBm.
+            %read-only %volatile int32 TxPowerMax {
+                on action read call read_trx_window_param;
+            }
+
+            // Average measured TX power in 0.1 dBm.
+            %read-only %volatile int32 TxPowerAvg {
+                on action read call read_trx_window_param;
+            }
+
+            // Minimum measured supply voltage in mV.
+            %read-only %volatile uint32 VoltageMin {
+                on action read call read_trx_window_param;
+            }
+
+            // Maximum measured supply voltage in mV.
+            %read-only %volatile uint32 VoltageMax {
+                on action read call read_trx_window_param;
+            }
+
+            // Average measured supply voltage in mV.
+            %read-only %volatile uint32 VoltageAvg {
+                on action read call read_trx_window_param;
+            }
+
+            // Minimum measured bias current in µA.
+            %read-only %volatile uint32 BiasMin {
+                on action read call read_trx_window_param;
+            }
+
+            // Maximum measured bias current in µA.
+            %read-only %volatile uint32 BiasMax {
+                on action read call read_trx_window_param;
+            }
+
+            // Average measured bias current in µA.
+            %read-only %volatile uint32 BiasAvg {
+                on action read call read_trx_window_param;
+            }
+
+            // Minimum measured temperature in degrees celsius.
+            %read-only %volatile int32 TemperatureMin {
+                on action read call read_trx_window_param;
+            }
+
+            // Maximum measured temperature in degrees celsius.
+            %read-only %volatile int32 TemperatureMax {
+                on action read call read_trx_window_param;
+            }
+
+            // Average measured temperature in degrees celsius.
+            %read-only %volatile int32 TemperatureAvg {
+                on action read call read_trx_window_param;
+            }
         }
         
         ifdef(`CONFIG_SAH_AMX_TR181_XPON_USE_NETDEV_COUNTERS', /**
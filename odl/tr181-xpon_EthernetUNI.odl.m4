@@ -162,6 +162,24 @@
             on action read call lastchange_on_read;
         }
 
+        /**
+            Number of times the vendor module changed Status from Up to another
+            value. It includes the changes held back by the flap damping,
+            configured with the config option 'status_damping_ms'.
+        */
+        %protected %read-only %volatile uint32 StatusFlaps {
+            on action read call status_history_on_read;
+        }
+
+        /**
+            Comma-separated list with the last Status changes, newest first.
+            Each element has the format "<Status>:<seconds since change>",
+            e.g. "Up:12,Down:15".
+        */
+        %protected %read-only %volatile string StatusHistory {
+            on action read call status_history_on_read;
+        }
+
         /**
             Comma-separated list (maximum number of characters 1024) of strings.
             Each list item MUST be the Path Name of an interface object that is
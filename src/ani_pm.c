@@ -0,0 +1,409 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file ani_pm.c
+ *
+ * Implementation of the pon_stat function dm_update_ani_pm().
+ *
+ * The vendor module passes the PM counters of an ANI in a packed struct with
+ * a fixed layout. See pon_stat_ani_pm.h. The module resolves the parameters
+ * of the PM objects of an ANI once, and caches them in the private data of
+ * the ANI instance. Afterwards an update does not need any string lookup or
+ * memory allocation: it copies each counter from the struct into the
+ * parameter it maps to.
+ *
+ * The parameters are updated without transaction. Hence the DM does not emit
+ * a 'dm:object-changed' event for them. That's fine for these counters:
+ * nobody subscribes on their changes, and clients read them on demand.
+ */
+
+/* Related header */
+#include "ani_pm.h"
+
+/* System headers */
+#include <stddef.h> /* offsetof() */
+#include <stdint.h> /* uintptr_t */
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* memcpy(), strcmp() */
+
+/* Other libraries' headers */
+#include <amxp/amxp.h>
+#include <amxd/amxd_dm.h>               /* amxd_dm_findf() */
+#include <amxd/amxd_object.h>           /* amxd_object_get_param_def() */
+#include <amxd/amxd_object_hierarchy.h> /* amxd_object_get_instance() */
+#include <amxd/amxd_parameter.h>        /* amxd_param_set_value() */
+
+/* Own headers */
+#include "dm_coalesce.h"                /* dm_coalesce_discard_params() */
+#include "dm_info.h"                    /* object_id_t */
+#include "dm_xpon_mngr.h"               /* xpon_mngr_get_dm() */
+#include "object_intf_priv.h"           /* object_intf_priv_t */
+#include "pon_stat_ani_pm.h"            /* pon_stat_ani_pm_t */
+#include "xpon_trace.h"
+
+/**
+ * Size of version 1 of pon_stat_ani_pm_t. A struct from the vendor module
+ * must be at least this big. Later versions append fields after 'omci'.
+ */
+#define ANI_PM_V1_SIZE (offsetof(pon_stat_ani_pm_t, omci) + sizeof(pon_stat_ani_pm_omci_t))
+
+/**
+ * Info about one PM parameter.
+ *
+ * @group: PON_STAT_ANI_PM_* bit of the group the parameter belongs to
+ * @object: path of the PM object relative to the ANI instance
+ * @name: name of the parameter
+ * @offset: offset of the counter in pon_stat_ani_pm_t
+ * @size: size of the counter: 4 (uint32) or 8 (uint64)
+ */
+typedef struct _pm_param_info {
+    uint32_t group;
+    const char* object;
+    const char* name;
+    size_t offset;
+    size_t size;
+} pm_param_info_t;
+
+#define PM_PARAM(group, object, name, member) \
+    { group, object, name, offsetof(pon_stat_ani_pm_t, member), \
+      sizeof(((pon_stat_ani_pm_t*) 0)->member) }
+
+static const pm_param_info_t PM_PARAMS[] = {
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "CorrectedFECBytes", phy.corrected_fec_bytes),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "CorrectedFECCodewords", phy.corrected_fec_codewords),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "UncorrectableFECCodewords", phy.uncorrectable_fec_codewords),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "TotalFECCodewords", phy.total_fec_codewords),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "PSBdHECErrorCount", phy.psbd_hec_error_count),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "HeaderHECErrorCount", phy.header_hec_error_count),
+    PM_PARAM(PON_STAT_ANI_PM_PHY, "TC.PM.PHY", "UnknownProfile", phy.unknown_profile),
+    PM_PARAM(PON_STAT_ANI_PM_GEM, "TC.PM.GEM", "FramesSent", gem.frames_sent),
+    PM_PARAM(PON_STAT_ANI_PM_GEM, "TC.PM.GEM", "FramesReceived", gem.frames_received),
+    PM_PARAM(PON_STAT_ANI_PM_GEM, "TC.PM.GEM", "FrameHeaderHECErrors", gem.frame_header_hec_errors),
+    PM_PARAM(PON_STAT_ANI_PM_GEM, "TC.PM.GEM", "KeyErrors", gem.key_errors),
+    PM_PARAM(PON_STAT_ANI_PM_PLOAM, "TC.PM.PLOAM", "MICErrors", ploam.mic_errors),
+    PM_PARAM(PON_STAT_ANI_PM_PLOAM, "TC.PM.PLOAM", "DownstreamMessageCount", ploam.downstream_message_count),
+    PM_PARAM(PON_STAT_ANI_PM_PLOAM, "TC.PM.PLOAM", "RangingTime", ploam.ranging_time),
+    PM_PARAM(PON_STAT_ANI_PM_PLOAM, "TC.PM.PLOAM", "UpstreamMessageCount", ploam.upstream_message_count),
+    PM_PARAM(PON_STAT_ANI_PM_OMCI, "TC.PM.OMCI", "BaselineMessagesReceived", omci.baseline_messages_received),
+    PM_PARAM(PON_STAT_ANI_PM_OMCI, "TC.PM.OMCI", "ExtendedMessagesReceived", omci.extended_messages_received),
+    PM_PARAM(PON_STAT_ANI_PM_OMCI, "TC.PM.OMCI", "MICErrors", omci.mic_errors)
+};
+
+#define NR_OF_PM_PARAMS (sizeof(PM_PARAMS) / sizeof(PM_PARAMS[0]))
+
+/**
+ * Info about one PM group: the object type and path of its PM object.
+ */
+typedef struct _pm_group_info {
+    uint32_t group;
+    object_id_t id;
+    const char* object;
+} pm_group_info_t;
+
+static const pm_group_info_t PM_GROUPS[] = {
+    { PON_STAT_ANI_PM_PHY, obj_id_ani_tc_pm_phy, "TC.PM.PHY" },
+    { PON_STAT_ANI_PM_GEM, obj_id_ani_tc_pm_gem, "TC.PM.GEM" },
+    { PON_STAT_ANI_PM_PLOAM, obj_id_ani_tc_pm_ploam, "TC.PM.PLOAM" },
+    { PON_STAT_ANI_PM_OMCI, obj_id_ani_tc_pm_omci, "TC.PM.OMCI" }
+};
+
+#define NR_OF_PM_GROUPS (sizeof(PM_GROUPS) / sizeof(PM_GROUPS[0]))
+
+struct _ani_pm_params {
+    amxd_param_t* params[NR_OF_PM_PARAMS];
+};
+
+/**
+ * XPON.ONU: resolved at the 1st update. ani_pm_cleanup() resets it when the
+ * plugin stops, before the DM is destroyed.
+ */
+static amxd_object_t* s_onu_templ = NULL;
+
+static amxd_object_t* find_ani(uint32_t onu_index, uint32_t ani_index) {
+
+    amxd_object_t* ani = NULL;
+
+    if(NULL == s_onu_templ) {
+        s_onu_templ = amxd_dm_findf(xpon_mngr_get_dm(), "XPON.ONU");
+        when_null_trace(s_onu_templ, exit, ERROR, "Failed to find XPON.ONU");
+    }
+    const amxd_object_t* const onu = amxd_object_get_instance(s_onu_templ, NULL, onu_index);
+    when_null_trace(onu, exit, ERROR, "XPON.ONU.%d does not exist", onu_index);
+    const amxd_object_t* const ani_templ = amxd_object_get_child(onu, "ANI");
+    when_null_trace(ani_templ, exit, ERROR, "XPON.ONU.%d.ANI does not exist", onu_index);
+    ani = amxd_object_get_instance(ani_templ, NULL, ani_index);
+    when_null_trace(ani, exit, ERROR, "XPON.ONU.%d.ANI.%d does not exist",
+                    onu_index, ani_index);
+
+exit:
+    return ani;
+}
+
+static bool resolve_params(amxd_object_t* const ani, ani_pm_params_t* const pm_params) {
+
+    bool rv = false;
+    size_t i;
+    amxd_object_t* object = NULL;
+    const char* object_path = NULL;
+
+    for(i = 0; i < NR_OF_PM_PARAMS; ++i) {
+        if((NULL == object_path) || (strcmp(object_path, PM_PARAMS[i].object) != 0)) {
+            object_path = PM_PARAMS[i].object;
+            object = amxd_object_findf(ani, "%s", object_path);
+            when_null_trace(object, exit, ERROR, "Failed to find %s", object_path);
+        }
+        pm_params->params[i] = amxd_object_get_param_def(object, PM_PARAMS[i].name);
+        when_null_trace(pm_params->params[i], exit, ERROR, "Failed to find %s.%s",
+                        object_path, PM_PARAMS[i].name);
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Return the PM parameters of an ANI.
+ *
+ * @param[in] ani: ANI instance
+ * @param[in,out] tmp: used if @a ani does not have private data yet. This is
+ *                     the case if the vendor module updates the PM counters
+ *                     before this plugin handled the 'dm:instance-added'
+ *                     event for the ANI.
+ *
+ * @return the pre-resolved parameters on success, else NULL
+ */
+static const ani_pm_params_t* get_params(amxd_object_t* const ani,
+                                         ani_pm_params_t* const tmp) {
+
+    const ani_pm_params_t* rv = NULL;
+    object_intf_priv_t* const priv = (object_intf_priv_t*) ani->priv;
+
+    if(NULL == priv) {
+        when_false(resolve_params(ani, tmp), exit);
+        rv = tmp;
+        goto exit;
+    }
+    if(NULL == priv->pm_params) {
+        ani_pm_params_t* const pm_params = calloc(1, sizeof(ani_pm_params_t));
+        when_null_trace(pm_params, exit, ERROR, "Failed to allocate ani_pm_params_t");
+        if(!resolve_params(ani, pm_params)) {
+            free(pm_params);
+            goto exit;
+        }
+        priv->pm_params = pm_params;
+    }
+    rv = priv->pm_params;
+
+exit:
+    return rv;
+}
+
+/**
+ * Copy one counter from @a pm into the parameter it maps to.
+ *
+ * The struct is packed: use memcpy() to read the counter. The function only
+ * writes the parameter if the value changed.
+ */
+static bool update_param(const uint8_t* const pm, const pm_param_info_t* const info,
+                         amxd_param_t* const param) {
+
+    bool rv = false;
+    amxc_var_t value;
+    amxc_var_init(&value);
+
+    /* Read the current value directly: amxd_param_get_value() would invoke
+     * the read action (read_coalesced_param), which builds the object path. */
+    if(sizeof(uint64_t) == info->size) {
+        uint64_t counter;
+        memcpy(&counter, pm + info->offset, sizeof(counter));
+        if(amxc_var_constcast(uint64_t, &param->value) == counter) {
+            rv = true;
+            goto exit;
+        }
+        amxc_var_set(uint64_t, &value, counter);
+    } else {
+        uint32_t counter;
+        memcpy(&counter, pm + info->offset, sizeof(counter));
+        if(amxc_var_constcast(uint32_t, &param->value) == counter) {
+            rv = true;
+            goto exit;
+        }
+        amxc_var_set(uint32_t, &value, counter);
+    }
+    when_failed_trace(amxd_param_set_value(param, &value), exit, ERROR,
+                      "Failed to set %s", info->name);
+    rv = true;
+
+exit:
+    amxc_var_clean(&value);
+    return rv;
+}
+
+/**
+ * Discard buffered updates of the PM objects in @a pm.
+ *
+ * A vendor module might also report PM counters via dm_object_changed(). If
+ * that buffered update is flushed later, it would overwrite the newer counters
+ * written by ani_pm_update_counters().
+ */
+static void discard_buffered_updates(const pon_stat_ani_pm_t* const pm) {
+
+    size_t i;
+    char path[64];
+
+    for(i = 0; i < NR_OF_PM_GROUPS; ++i) {
+        if(((pm->groups & PM_GROUPS[i].group) == 0) ||
+           !dm_coalesce_has_pending(PM_GROUPS[i].id)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "XPON.ONU.%u.ANI.%u.%s", pm->onu_index,
+                 pm->ani_index, PM_GROUPS[i].object);
+        dm_coalesce_discard_params(path, 0, NULL);
+    }
+}
+
+/**
+ * Update the PM counters of an ANI.
+ *
+ * @param[in] args: variant of type uint64_t. Its value must be the address of
+ *                  a pon_stat_ani_pm_t.
+ *
+ * @return 0 on success, else -1
+ */
+int ani_pm_update(const amxc_var_t* const args) {
+
+    int rc = -1;
+
+    when_null_trace(args, exit, ERROR, "args is NULL");
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_UINT64, exit, ERROR,
+                     "Type of 'args' = %d != UINT64", amxc_var_type_of(args));
+
+    rc = ani_pm_update_counters(
+        (const pon_stat_ani_pm_t*) (uintptr_t) amxc_var_constcast(uint64_t, args));
+
+exit:
+    return rc;
+}
+
+/**
+ * Update the PM counters of an ANI.
+ *
+ * @param[in] pm: the counters
+ *
+ * Same as ani_pm_update(), but without the need to wrap the address of @a pm
+ * in a variant.
+ *
+ * @return 0 on success, else -1
+ */
+int ani_pm_update_counters(const pon_stat_ani_pm_t* const pm) {
+
+    int rc = -1;
+    size_t i;
+    ani_pm_params_t tmp;
+
+    when_null_trace(pm, exit, ERROR, "pm is NULL");
+    when_false_trace(pm->version >= 1, exit, ERROR, "Invalid version [%d]", pm->version);
+    when_false_trace(pm->size >= ANI_PM_V1_SIZE, exit, ERROR,
+                     "size=%d < %zu", pm->size, ANI_PM_V1_SIZE);
+
+    amxd_object_t* const ani = find_ani(pm->onu_index, pm->ani_index);
+    when_null(ani, exit);
+    const ani_pm_params_t* const pm_params = get_params(ani, &tmp);
+    when_null(pm_params, exit);
+
+    discard_buffered_updates(pm);
+
+    rc = 0;
+    for(i = 0; i < NR_OF_PM_PARAMS; ++i) {
+        if((pm->groups & PM_PARAMS[i].group) == 0) {
+            continue;
+        }
+        if(!update_param((const uint8_t*) pm, &PM_PARAMS[i], pm_params->params[i])) {
+            rc = -1;
+        }
+    }
+
+exit:
+    return rc;
+}
+
+/**
+ * Forget the objects the module resolved in the DM.
+ *
+ * The plugin must call this function when stopping. A next update resolves
+ * them again.
+ */
+void ani_pm_cleanup(void) {
+    s_onu_templ = NULL;
+}
+
+/**
+ * Delete the pre-resolved PM parameters of an ANI.
+ *
+ * tr181-xpon calls this function when it deletes the private data of an ANI.
+ */
+void ani_pm_delete_params(ani_pm_params_t* params) {
+    free(params);
+}
@@ -0,0 +1,228 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/* Related header */
+#include "call_stats.h"
+
+/* System headers */
+#include <inttypes.h> /* PRIu64 */
+#include <string.h>   /* memset() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+
+/* Own headers */
+#include "utils_time.h" /* time_get_monotonic_us() */
+#include "xpon_trace.h"
+
+/** Registered statistics per group */
+static amxc_llist_t s_groups[call_stats_group_nr];
+
+/**
+ * Register the statistics of a function.
+ *
+ * @param[in] group  group the function belongs to
+ * @param[in] name   function name. Must remain valid as long as @a stats.
+ * @param[in] stats  statistics of the function. The caller keeps ownership. It
+ *                   must remain valid until call_stats_cleanup() is called.
+ *
+ * Registering the statistics again (e.g. after a restart of the vendor module)
+ * is harmless.
+ */
+void call_stats_register(call_stats_group_t group, const char* const name,
+                         call_stats_t* const stats) {
+    when_null(stats, exit);
+    when_false_trace(group < call_stats_group_nr, exit, ERROR,
+                     "%s: invalid group: %d", name, group);
+    stats->name = name;
+    amxc_llist_append(&s_groups[group], &stats->it);
+exit:
+    return;
+}
+
+static uint32_t bucket_of(uint64_t latency_us) {
+    if(0 == latency_us) {
+        return 0;
+    }
+    const uint32_t bucket = 64 - (uint32_t) __builtin_clzll(latency_us);
+    return (bucket < CALL_STATS_NR_OF_BUCKETS) ? bucket : CALL_STATS_NR_OF_BUCKETS - 1;
+}
+
+/**
+ * Record a call of a function.
+ *
+ * @param[in] stats     statistics of the function
+ * @param[in] start_us  value of time_get_monotonic_us() before the call
+ * @param[in] rc        return value of the function. A nonzero value counts
+ *                      as an error.
+ *
+ * The function only updates some counters, so it is cheap enough to call it
+ * for each call.
+ */
+void call_stats_record(call_stats_t* const stats, uint64_t start_us, int rc) {
+    const uint64_t now_us = time_get_monotonic_us();
+    const uint64_t latency_us = (now_us > start_us) ? now_us - start_us : 0;
+
+    stats->calls++;
+    if(rc) {
+        stats->errors++;
+    }
+    if(latency_us > stats->max_us) {
+        stats->max_us = latency_us;
+    }
+    stats->buckets[bucket_of(latency_us)]++;
+}
+
+/**
+ * Return an estimate of a latency percentile of a function in us.
+ *
+ * @param[in] stats    statistics of the function
+ * @param[in] percent  percentile, e.g. 99 for the p99 latency
+ *
+ * The function returns the upper bound of the bucket of the histogram which
+ * has the percentile, limited to the max latency. Hence the estimate is at
+ * most a factor 2 too high.
+ *
+ * @return the percentile in us, 0 if the function was not called yet
+ */
+uint64_t call_stats_percentile(const call_stats_t* const stats, uint32_t percent) {
+    uint64_t rv = 0;
+    uint64_t count = 0;
+    uint32_t i;
+
+    when_null(stats, exit);
+    when_true(0 == stats->calls, exit);
+
+    /* Number of calls at or below the percentile, rounded up */
+    const uint64_t target = (stats->calls * percent + 99) / 100;
+    for(i = 0; i < CALL_STATS_NR_OF_BUCKETS; ++i) {
+        count += stats->buckets[i];
+        if(count >= target) {
+            break;
+        }
+    }
+    rv = (i < CALL_STATS_NR_OF_BUCKETS - 1) ? (UINT64_C(1) << i) : stats->max_us;
+    if(rv > stats->max_us) {
+        rv = stats->max_us;
+    }
+
+exit:
+    return rv;
+}
+
+/**
+ * Get a summary of the statistics of a group of functions.
+ *
+ * @param[in] group     group of functions
+ * @param[out] summary  comma-separated list with an element per function which
+ *                      was called at least once. An element has the format
+ *                      "name:calls/errors/p50/p99/max", with the latencies in
+ *                      us, e.g. "get_param_values:120/0/8/64/70".
+ */
+void call_stats_get_summary(call_stats_group_t group, amxc_string_t* const summary) {
+    amxc_string_set(summary, "");
+    when_false(group < call_stats_group_nr, exit);
+
+    amxc_llist_iterate(it, &s_groups[group]) {
+        const call_stats_t* const stats = amxc_llist_it_get_data(it, call_stats_t, it);
+        if(0 == stats->calls) {
+            continue;
+        }
+        amxc_string_appendf(summary,
+                            "%s%s:%" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64,
+                            amxc_string_is_empty(summary) ? "" : ",", stats->name,
+                            stats->calls, stats->errors,
+                            call_stats_percentile(stats, 50),
+                            call_stats_percentile(stats, 99), stats->max_us);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Reset the statistics of all registered functions.
+ */
+void call_stats_reset(void) {
+    uint32_t group;
+    for(group = 0; group < call_stats_group_nr; ++group) {
+        amxc_llist_iterate(it, &s_groups[group]) {
+            call_stats_t* const stats = amxc_llist_it_get_data(it, call_stats_t, it);
+            stats->calls = 0;
+            stats->errors = 0;
+            stats->max_us = 0;
+            memset(stats->buckets, 0, sizeof(stats->buckets));
+        }
+    }
+}
+
+/**
+ * Unregister all statistics.
+ *
+ * The plugin must call this function once when stopping.
+ */
+void call_stats_cleanup(void) {
+    uint32_t group;
+    for(group = 0; group < call_stats_group_nr; ++group) {
+        amxc_llist_clean(&s_groups[group], NULL);
+    }
+}
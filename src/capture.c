@@ -0,0 +1,306 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file capture.c
+ *
+ * Capture of the calls between the plugin and the vendor module.
+ *
+ * If the config option 'capture_file' is set, the module writes a record to
+ * that file for each call of a pon_stat function by the vendor module, and for
+ * each call of a pon_ctrl function by the plugin. The format is described in
+ * xpon_capture.h. The simulated vendor module mod-xpon-sim can replay the
+ * capture to reproduce a field issue or to measure the plugin without the
+ * hardware.
+ *
+ * The file is created with mode 0600, and the password of set_password() is
+ * redacted. See capture_encode_pon_ctrl_args().
+ *
+ * The fast ABI passes no variants. While capturing, pon_ctrl.c and
+ * module_mgmt.c therefore don't use the fast ABI.
+ */
+
+/**
+ * Define _GNU_SOURCE to avoid following errors:
+ * - implicit declaration of function ‘fdopen’
+ * - ‘O_NOFOLLOW’ undeclared
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* Related header */
+#include "capture.h"
+
+/* System headers */
+#include <fcntl.h>  /* open() */
+#include <stdio.h>  /* fdopen(), fwrite() */
+#include <string.h> /* strcmp(), strlen() */
+#include <unistd.h> /* close() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxo/amxo.h> /* amxo_parser_t */
+
+/* Own headers */
+#include "dm_xpon_mngr.h"     /* xpon_mngr_get_parser() */
+#include "pon_stat_ani_pm.h"  /* pon_stat_ani_pm_t */
+#include "utils_time.h"       /* time_get_monotonic_us() */
+#include "xpon_capture.h"
+#include "xpon_trace.h"
+
+#define CAPTURE_FILE_CONFIG "capture_file"
+
+/** Capture file. NULL if capturing is disabled. */
+static FILE* s_file = NULL;
+/** Start of the capture, as returned by time_get_monotonic_us() */
+static uint64_t s_start_us = 0;
+/** Number of ongoing captured calls */
+static uint8_t s_depth = 0;
+
+/**
+ * Open the capture file if the config option 'capture_file' is set.
+ *
+ * The plugin must call this function once at startup, before it loads the
+ * vendor module.
+ */
+void capture_init(void) {
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
+
+    const char* const file = GET_CHAR(&parser->config, CAPTURE_FILE_CONFIG);
+    when_true((NULL == file) || (file[0] == '\0'), exit);
+
+    /* Only the plugin may read the capture: it has the DM contents. Do not
+     * follow a symlink someone planted at that path. */
+    const int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600);
+    when_true_trace(fd < 0, exit, ERROR, "Failed to open %s", file);
+    s_file = fdopen(fd, "wb");
+    if(NULL == s_file) {
+        SAH_TRACEZ_ERROR(ME, "Failed to open stream for %s", file);
+        close(fd);
+        goto exit;
+    }
+
+    const uint8_t version = XPON_CAPTURE_VERSION;
+    if((fwrite(XPON_CAPTURE_MAGIC, 1, XPON_CAPTURE_MAGIC_LEN, s_file) != XPON_CAPTURE_MAGIC_LEN) ||
+       (fwrite(&version, 1, 1, s_file) != 1)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to write to %s", file);
+        capture_cleanup();
+        goto exit;
+    }
+    s_start_us = time_get_monotonic_us();
+    SAH_TRACEZ_WARNING(ME, "Capturing calls to %s", file);
+
+exit:
+    return;
+}
+
+/**
+ * Close the capture file.
+ *
+ * The plugin must call this function once when stopping, after it unloaded
+ * the vendor module.
+ */
+void capture_cleanup(void) {
+    when_null(s_file, exit);
+    if(fclose(s_file) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to close capture file");
+    }
+    s_file = NULL;
+    s_depth = 0;
+
+exit:
+    return;
+}
+
+/**
+ * Return true if the plugin captures the calls to and from the vendor module.
+ */
+bool capture_is_enabled(void) {
+    return (s_file != NULL);
+}
+
+/**
+ * Encode the args of dm_update_ani_pm().
+ *
+ * The args are the address of a pon_stat_ani_pm_t. Encode the struct itself:
+ * the address is meaningless in a replay.
+ */
+static bool encode_ani_pm(capture_buf_t* const buf, const amxc_var_t* const args) {
+    const pon_stat_ani_pm_t* const pm =
+        (const pon_stat_ani_pm_t*) (uintptr_t) amxc_var_constcast(uint64_t, args);
+    if(NULL == pm) {
+        return capture_encode_var(buf, args);
+    }
+    const uint32_t len = (pm->size < sizeof(pon_stat_ani_pm_t)) ?
+        pm->size : sizeof(pon_stat_ani_pm_t);
+    return capture_encode_blob(buf, pm, len);
+}
+
+/**
+ * Start capturing a call.
+ *
+ * The caller must call this function before the call, because the callee may
+ * modify @a args.
+ *
+ * @param[out] call  ongoing call. If the function returns true, the caller
+ *                   must pass it to capture_call_end() when the call returns.
+ * @param[in] kind   XPON_CAPTURE_PON_STAT or XPON_CAPTURE_PON_CTRL
+ * @param[in] name   function name. Must remain valid until
+ *                   capture_call_end().
+ * @param[in] args   args of the call
+ *
+ * @return true if the call is captured, false if capturing is disabled or on
+ *         error
+ */
+bool capture_call_begin(capture_call_t* const call, uint8_t kind,
+                        const char* const name, const amxc_var_t* const args) {
+    bool rv = false;
+    bool encoded = false;
+
+    when_null(s_file, exit);
+
+    call->kind = kind;
+    call->name = name;
+    call->depth = s_depth;
+    capture_buf_init(&call->args);
+    if((XPON_CAPTURE_PON_STAT == kind) && (strcmp(name, "dm_update_ani_pm") == 0) &&
+       (amxc_var_type_of(args) == AMXC_VAR_ID_UINT64)) {
+        encoded = encode_ani_pm(&call->args, args);
+    } else if(XPON_CAPTURE_PON_CTRL == kind) {
+        encoded = capture_encode_pon_ctrl_args(&call->args, name, args);
+    } else {
+        encoded = capture_encode_var(&call->args, args);
+    }
+    if(!encoded) {
+        SAH_TRACEZ_ERROR(ME, "%s(): failed to encode args", name);
+        capture_buf_clean(&call->args);
+        goto exit;
+    }
+    if(s_depth < UINT8_MAX) {
+        ++s_depth;
+    }
+    call->start_us = time_get_monotonic_us();
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Write the record of a call to the capture file.
+ *
+ * @param[in] call  call started with capture_call_begin()
+ * @param[in] rc    return value of the call
+ * @param[in] ret   return value of the call. May be NULL.
+ */
+void capture_call_end(capture_call_t* const call, int rc,
+                      const amxc_var_t* const ret) {
+
+    const uint64_t end_us = time_get_monotonic_us();
+    const size_t name_len = strlen(call->name);
+    xpon_capture_record_t record;
+    capture_buf_t buf;
+    capture_buf_init(&buf);
+
+    if(s_depth > 0) {
+        --s_depth;
+    }
+    when_null(s_file, exit);
+
+    record.kind = call->kind;
+    record.time_us = call->start_us - s_start_us;
+    record.latency_us = (uint32_t) (end_us - call->start_us);
+    record.rc = rc;
+    record.depth = call->depth;
+    record.name_len = (uint8_t) ((name_len > UINT8_MAX) ? UINT8_MAX : name_len);
+
+    amxc_var_t null_var;
+    amxc_var_init(&null_var);
+    const uint32_t args_len = (uint32_t) call->args.len;
+    bool ok = capture_buf_append(&buf, &record, sizeof(record)) &&
+        capture_buf_append(&buf, call->name, record.name_len) &&
+        capture_buf_append(&buf, &args_len, sizeof(args_len)) &&
+        capture_buf_append(&buf, call->args.data, call->args.len);
+    const size_t ret_len_pos = buf.len;
+    uint32_t ret_len = 0;
+    ok = ok && capture_buf_append(&buf, &ret_len, sizeof(ret_len)) &&
+        capture_encode_var(&buf, ret ? ret : &null_var);
+    amxc_var_clean(&null_var);
+    when_false_trace(ok, exit, ERROR, "%s(): failed to encode record", call->name);
+
+    ret_len = (uint32_t) (buf.len - ret_len_pos - sizeof(ret_len));
+    memcpy(buf.data + ret_len_pos, &ret_len, sizeof(ret_len));
+
+    /* Flush per record: the capture must be complete up to the last call if
+     * the plugin crashes, which is often why it's captured in the first place. */
+    if((fwrite(buf.data, 1, buf.len, s_file) != buf.len) || (fflush(s_file) != 0)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to write to capture file: stop capturing");
+        capture_cleanup();
+    }
+
+exit:
+    capture_buf_clean(&buf);
+    capture_buf_clean(&call->args);
+}
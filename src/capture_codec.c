@@ -0,0 +1,408 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/* Related header */
+#include "capture_codec.h"
+
+/* System headers */
+#include <stdlib.h> /* free(), realloc() */
+#include <string.h> /* memcpy(), strcmp(), strlen() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+
+/* Own headers */
+#include "xpon_capture.h"
+
+/** Max nesting depth of a variant to decode */
+#define MAX_DEPTH 16
+
+void capture_buf_init(capture_buf_t* const buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->size = 0;
+}
+
+void capture_buf_clean(capture_buf_t* const buf) {
+    free(buf->data);
+    capture_buf_init(buf);
+}
+
+bool capture_buf_append(capture_buf_t* const buf, const void* const data, size_t len) {
+    if(buf->len + len > buf->size) {
+        size_t size = buf->size ? buf->size * 2 : 256;
+        while(size < buf->len + len) {
+            size *= 2;
+        }
+        uint8_t* const new_data = (uint8_t*) realloc(buf->data, size);
+        if(NULL == new_data) {
+            return false;
+        }
+        buf->data = new_data;
+        buf->size = size;
+    }
+    if(len > 0) {
+        memcpy(buf->data + buf->len, data, len);
+        buf->len += len;
+    }
+    return true;
+}
+
+static bool append_tag(capture_buf_t* const buf, uint8_t tag) {
+    return capture_buf_append(buf, &tag, 1);
+}
+
+static bool append_string(capture_buf_t* const buf, uint8_t tag, const char* str) {
+    const uint32_t len = str ? (uint32_t) strlen(str) : 0;
+    return append_tag(buf, tag) &&
+           capture_buf_append(buf, &len, sizeof(len)) &&
+           capture_buf_append(buf, str, len);
+}
+
+/**
+ * Encode a variant and append it to @a buf.
+ *
+ * @return true on success, false if out of memory
+ */
+bool capture_encode_var(capture_buf_t* const buf, const amxc_var_t* const var) {
+    bool rv = false;
+    uint32_t count = 0;
+
+    switch(amxc_var_type_of(var)) {
+    case AMXC_VAR_ID_NULL:
+        rv = append_tag(buf, XPON_CAPTURE_TAG_NULL);
+        break;
+    case AMXC_VAR_ID_CSTRING:
+        rv = append_string(buf, XPON_CAPTURE_TAG_STRING, amxc_var_constcast(cstring_t, var));
+        break;
+    case AMXC_VAR_ID_CSV_STRING:
+        rv = append_string(buf, XPON_CAPTURE_TAG_CSV_STRING,
+                           amxc_var_constcast(csv_string_t, var));
+        break;
+    case AMXC_VAR_ID_BOOL: {
+        const uint8_t value = amxc_var_constcast(bool, var) ? 1 : 0;
+        rv = append_tag(buf, XPON_CAPTURE_TAG_BOOL) && capture_buf_append(buf, &value, 1);
+        break;
+    }
+    case AMXC_VAR_ID_INT32: {
+        const int32_t value = amxc_var_constcast(int32_t, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_INT32) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_UINT32: {
+        const uint32_t value = amxc_var_constcast(uint32_t, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_UINT32) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_INT64: {
+        const int64_t value = amxc_var_constcast(int64_t, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_INT64) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_UINT64: {
+        const uint64_t value = amxc_var_constcast(uint64_t, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_UINT64) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_DOUBLE: {
+        const double value = amxc_var_constcast(double, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_DOUBLE) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_FD: {
+        const int32_t value = amxc_var_constcast(fd_t, var);
+        rv = append_tag(buf, XPON_CAPTURE_TAG_FD) &&
+            capture_buf_append(buf, &value, sizeof(value));
+        break;
+    }
+    case AMXC_VAR_ID_LIST:
+    case AMXC_VAR_ID_HTABLE: {
+        const bool htable = (amxc_var_type_of(var) == AMXC_VAR_ID_HTABLE);
+        amxc_var_for_each(element, var) {
+            count++;
+        }
+        rv = append_tag(buf, htable ? XPON_CAPTURE_TAG_HTABLE : XPON_CAPTURE_TAG_LIST) &&
+            capture_buf_append(buf, &count, sizeof(count));
+        amxc_var_for_each(element, var) {
+            if(htable) {
+                const char* const key = amxc_var_key(element);
+                const uint16_t key_len = (uint16_t) strlen(key);
+                rv = rv && capture_buf_append(buf, &key_len, sizeof(key_len)) &&
+                    capture_buf_append(buf, key, key_len);
+            }
+            rv = rv && capture_encode_var(buf, element);
+        }
+        break;
+    }
+    default: {
+        char* const str = amxc_var_dyncast(cstring_t, var);
+        rv = append_string(buf, XPON_CAPTURE_TAG_STRING, str);
+        free(str);
+        break;
+    }
+    }
+    return rv;
+}
+
+/**
+ * Append @a len bytes of @a data encoded as BLOB to @a buf.
+ *
+ * @return true on success, false if out of memory
+ */
+bool capture_encode_blob(capture_buf_t* const buf, const void* const data, uint32_t len) {
+    return append_tag(buf, XPON_CAPTURE_TAG_BLOB) &&
+           capture_buf_append(buf, &len, sizeof(len)) &&
+           capture_buf_append(buf, data, len);
+}
+
+/**
+ * Encode the args of a pon_ctrl function and append them to @a buf.
+ *
+ * @param[in,out] buf  buffer to append to
+ * @param[in] name     name of the pon_ctrl function
+ * @param[in] args     args of the call
+ *
+ * Same as capture_encode_var(), but the 'password' of set_password() is
+ * replaced by XPON_CAPTURE_REDACTED. The plugin uses this function to write
+ * the args, and mod-xpon-sim to build the key to match a call in a replay,
+ * such that both agree on the encoding.
+ *
+ * @return true on success, false if out of memory
+ */
+bool capture_encode_pon_ctrl_args(capture_buf_t* const buf, const char* const name,
+                                  const amxc_var_t* const args) {
+
+    bool rv = false;
+    amxc_var_t redacted;
+    amxc_var_init(&redacted);
+
+    if((strcmp(name, "set_password") != 0) || (NULL == GET_ARG(args, "password"))) {
+        rv = capture_encode_var(buf, args);
+        goto exit;
+    }
+    amxc_var_copy(&redacted, args);
+    amxc_var_t* const password = GET_ARG(&redacted, "password");
+    amxc_var_set(cstring_t, password, XPON_CAPTURE_REDACTED);
+    rv = capture_encode_var(buf, &redacted);
+
+exit:
+    amxc_var_clean(&redacted);
+    return rv;
+}
+
+/**
+ * Read @a len bytes from @a reader.
+ *
+ * @return false if fewer than @a len bytes are left
+ */
+bool capture_read(capture_reader_t* const reader, void* const out, size_t len) {
+    if(len > reader->len - reader->pos) {
+        return false;
+    }
+    memcpy(out, reader->data + reader->pos, len);
+    reader->pos += len;
+    return true;
+}
+
+static bool read_string(capture_reader_t* const reader, size_t len, char** const str) {
+    if(len > reader->len - reader->pos) {
+        return false;
+    }
+    *str = (char*) malloc(len + 1);
+    if(NULL == *str) {
+        return false;
+    }
+    memcpy(*str, reader->data + reader->pos, len);
+    (*str)[len] = '\0';
+    reader->pos += len;
+    return true;
+}
+
+static bool decode_var(capture_reader_t* const reader, amxc_var_t* const var,
+                       void** const blob, uint32_t depth) {
+    bool rv = false;
+    uint8_t tag = 0;
+    uint32_t len = 0;
+    char* str = NULL;
+
+    if((depth > MAX_DEPTH) || !capture_read(reader, &tag, 1)) {
+        goto exit;
+    }
+    switch(tag) {
+    case XPON_CAPTURE_TAG_NULL:
+        amxc_var_set_type(var, AMXC_VAR_ID_NULL);
+        rv = true;
+        break;
+    case XPON_CAPTURE_TAG_STRING:
+    case XPON_CAPTURE_TAG_CSV_STRING:
+        if(capture_read(reader, &len, sizeof(len)) && read_string(reader, len, &str)) {
+            if(tag == XPON_CAPTURE_TAG_STRING) {
+                amxc_var_set(cstring_t, var, str);
+            } else {
+                amxc_var_set(csv_string_t, var, str);
+            }
+            rv = true;
+        }
+        break;
+    case XPON_CAPTURE_TAG_BOOL: {
+        uint8_t value = 0;
+        rv = capture_read(reader, &value, 1);
+        amxc_var_set(bool, var, value != 0);
+        break;
+    }
+    case XPON_CAPTURE_TAG_INT32: {
+        int32_t value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(int32_t, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_UINT32: {
+        uint32_t value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(uint32_t, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_INT64: {
+        int64_t value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(int64_t, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_UINT64: {
+        uint64_t value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(uint64_t, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_DOUBLE: {
+        double value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(double, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_FD: {
+        int32_t value = 0;
+        rv = capture_read(reader, &value, sizeof(value));
+        amxc_var_set(fd_t, var, value);
+        break;
+    }
+    case XPON_CAPTURE_TAG_LIST:
+    case XPON_CAPTURE_TAG_HTABLE: {
+        const bool htable = (tag == XPON_CAPTURE_TAG_HTABLE);
+        when_false(capture_read(reader, &len, sizeof(len)), exit);
+        amxc_var_set_type(var, htable ? AMXC_VAR_ID_HTABLE : AMXC_VAR_ID_LIST);
+        for(uint32_t i = 0; i < len; ++i) {
+            amxc_var_t* element = NULL;
+            if(htable) {
+                uint16_t key_len = 0;
+                when_false(capture_read(reader, &key_len, sizeof(key_len)), exit);
+                when_false(read_string(reader, key_len, &str), exit);
+                element = amxc_var_add_new_key(var, str);
+                free(str);
+                str = NULL;
+            } else {
+                element = amxc_var_add_new(var);
+            }
+            when_null(element, exit);
+            when_false(decode_var(reader, element, blob, depth + 1), exit);
+        }
+        rv = true;
+        break;
+    }
+    case XPON_CAPTURE_TAG_BLOB:
+        when_true((NULL == blob) || (*blob != NULL), exit);
+        when_false(capture_read(reader, &len, sizeof(len)), exit);
+        when_false(read_string(reader, len, &str), exit);
+        /* Keep the blob: the variant refers to it by address */
+        *blob = str;
+        str = NULL;
+        amxc_var_set(uint64_t, var, (uint64_t) (uintptr_t) *blob);
+        rv = true;
+        break;
+    default:
+        break;
+    }
+
+exit:
+    free(str);
+    return rv;
+}
+
+/**
+ * Decode a variant from @a reader.
+ *
+ * @param[out] var   the decoded variant
+ * @param[out] blob  must point to NULL. If the variant is a BLOB, the function
+ *                   sets it to a copy of the bytes, and sets @a var to the
+ *                   address of that copy. The caller must free it.
+ *
+ * @return true on success, false if the data is invalid or truncated
+ */
+bool capture_decode_var(capture_reader_t* const reader, amxc_var_t* const var,
+                        void** const blob) {
+    return decode_var(reader, var, blob, 0);
+}
@@ -64,9 +64,10 @@
 #include "data_model.h"
 
 /* System headers */
+#include <inttypes.h> /* PRIu64 */
 #include <stdio.h>  /* snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strncmp() */
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strcmp(), strlen(), strncmp() */
 
 /* Other libraries' headers */
 #include <amxc/amxc.h>
@@ -81,16 +82,26 @@
 #include <amxd/amxd_transaction.h>
 
 /* Own headers */
-#include "ani.h"            /* ani_append_tc_authentication() */
-#include "dm_actions.h"     /* dm_actions_set_ignore_param_reads() */
+#include "ani.h"              /* ani_append_tc_authentication() */
+#include "dm_actions.h"       /* dm_actions_set_ignore_param_reads() */
+#include "dm_coalesce.h"      /* dm_coalesce_discard_params() */
 #include "dm_info.h"
-#include "dm_xpon_mngr.h"   /* xpon_mngr_get_dm() */
-#include "onu_priv.h"       /* onu_priv_attach_private_data() */
+#include "dm_xpon_mngr.h"     /* xpon_mngr_get_dm() */
+#include "object_intf_priv.h" /* oipriv_hold_status() */
+#include "onu_priv.h"         /* onu_priv_attach_private_data() */
 #include "persistency.h"
 #include "password.h"
-#include "restore_to_hal.h" /* rth_schedule_enable() */
+#include "restore_to_hal.h"   /* rth_schedule_enable() */
+#include "utils_time.h"       /* time_get_monotonic_ms() */
 #include "xpon_trace.h"
 
+/**
+ * Config option: if true, dm_omci_reset_mib() emits one OMCI_RESET_MIB_EVENT
+ * event instead of an instance-removed event per GEM port.
+ */
+#define OMCI_RESET_MIB_AGGREGATED_EVENT "omci_reset_mib_aggregated_event"
+#define OMCI_RESET_MIB_EVENT "omci:reset-mib"
+
 #define ADD_INST_N_ARGS_REQUIRED 3
 static const char* ADD_INST_PARAMS_REQUIRED[ADD_INST_N_ARGS_REQUIRED] = {
     "path", "index", "keys"
@@ -200,6 +211,39 @@ exit:
     return;
 }
 
+/**
+ * Set XPON.StartupPopulationTime to @a duration.
+ *
+ * @param[in] duration: time in ms it took to populate the DM at startup
+ */
+void dm_set_startup_population_time(uint32_t duration) {
+
+    amxd_object_t* xpon = dm_get_xpon_object();
+    when_null(xpon, exit);
+    if(amxd_object_set_value(uint32_t, xpon, "StartupPopulationTime", duration)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to update XPON.StartupPopulationTime");
+    }
+exit:
+    return;
+}
+
+/**
+ * Set XPON.StaleInstances to @a nr_of_instances.
+ *
+ * @param[in] nr_of_instances: number of instances loaded from the snapshot
+ *                             the vendor module did not confirm yet
+ */
+void dm_set_nr_of_stale_instances(uint32_t nr_of_instances) {
+
+    amxd_object_t* xpon = dm_get_xpon_object();
+    when_null(xpon, exit);
+    if(amxd_object_set_value(uint32_t, xpon, "StaleInstances", nr_of_instances)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to update XPON.StaleInstances");
+    }
+exit:
+    return;
+}
+
 static bool get_ref_to_params(const amxc_var_t* const args,
                               const amxc_var_t** params) {
     bool rv = false;
@@ -415,21 +459,96 @@ exit:
     return rv;
 }
 
+/**
+ * Return true if a param of an object already has a certain value.
+ *
+ * @param[in] object  the object
+ * @param[in] name    param name
+ * @param[in] value   the value to compare the current value with
+ *
+ * The function uses the value as stored in the DM. It does not call a read
+ * action for the param.
+ *
+ * @return true if the param has the value @a value, else false
+ */
+static bool is_param_unchanged(const amxd_object_t* const object,
+                               const char* const name,
+                               const amxc_var_t* const value) {
+    int result = -1;
+    const amxc_var_t* const current = amxd_object_get_param_value(object, name);
+    if(!current || (amxc_var_type_of(current) != amxc_var_type_of(value))) {
+        return false;
+    }
+    if(amxc_var_compare(current, value, &result) != 0) {
+        return false;
+    }
+    return (0 == result);
+}
+
+/**
+ * Return true if a set of param values changes at least one param of an object.
+ *
+ * @param[in] object  the object
+ * @param[in] params  htable with values for one or more params of @a object
+ * @param[in] id      object ID
+ *
+ * The function returns as soon as it finds a changed value. It skips the
+ * params add_params_to_transaction() would skip: unknown params and params
+ * with a value of the wrong type. Else an update with only such params would
+ * apply an empty transaction. add_params_to_transaction() logs the
+ * appropriate messages for them if another param changed.
+ */
+static bool has_changed_params(const amxd_object_t* const object,
+                               const amxc_var_t* const params,
+                               object_id_t id) {
+
+    const amxc_htable_t* const params_table = amxc_var_constcast(amxc_htable_t, params);
+    when_null(params_table, exit);
+
+    const param_info_t* param_info;
+    const amxc_var_t* value;
+    const char* key;
+    amxc_htable_for_each(it, params_table) {
+        key = amxc_htable_it_get_key(it);
+        if(!key) {
+            continue;
+        }
+        param_info = dm_get_param_info(id, key);
+        if(NULL == param_info) {
+            SAH_TRACEZ_DEBUG(ME, "Unknown param name: %s: skip it", key);
+            continue;
+        }
+        value = amxc_var_from_htable_it(it);
+        if((NULL == value) || (amxc_var_type_of(value) != param_info->type)) {
+            continue;
+        }
+        if(!is_param_unchanged(object, key, value)) {
+            return true;
+        }
+    }
+
+exit:
+    return false;
+}
+
 /**
  * Add set value actions to a transaction to set params of an object.
  *
  * @param[in,out] transaction  transaction to add set value actions to
  * @param[in] params           htable with values for one or more params of an object
  * @param[in] id               object ID
+ * @param[in] object           the object if it already exists, else NULL
  *
  * The function iterates over all elements in @a params. It adds a set value
- * action to @a transaction for each known element.
+ * action to @a transaction for each known element. If @a object is not NULL,
+ * it skips the elements whose value equals the current value in the DM.
  *
  * @return true on success, else false
  */
 static bool add_params_to_transaction(amxd_trans_t* transaction,
                                       const amxc_var_t* const params,
-                                      object_id_t id) {
+                                      object_id_t id,
+                                      const amxd_object_t* const object) {
     bool rv = false;
 
     const amxc_htable_t* const params_table = amxc_var_constcast(amxc_htable_t, params);
@@ -438,37 +557,21 @@ static bool add_params_to_transaction(amxd_trans_t* transaction,
     const object_info_t* const obj_info = dm_get_object_info(id);
     when_null(obj_info, exit);
 
-    const param_info_t* param_info;
     const param_info_t* single_param;
-    uint32_t n_params;
-
-    if(!dm_get_object_param_info(id, &param_info, &n_params)) {
-        SAH_TRACEZ_ERROR(ME, "%s: failed to get info about its params", obj_info->name);
-        goto exit;
-    }
-
     amxc_var_t* param_value = NULL;
-    uint32_t i;
     const char* key;
 
     amxc_htable_for_each(it, params_table) {
-        single_param = NULL;
         key = amxc_htable_it_get_key(it);
         if(!key) {
             continue;
         }
-        for(i = 0; i < n_params; ++i) {
-            if((strncmp(key, param_info[i].name, strlen(key)) == 0) &&
-               (strlen(key) == strlen(param_info[i].name))) {
-                single_param = &param_info[i];
-                break; /* out of for loop */
-            }
-        }
+        single_param = dm_get_param_info(id, key);
         if(NULL == single_param) {
             SAH_TRACEZ_WARNING(ME, "%s: unknown param name: %s", obj_info->name, key);
             continue;
         }
-        param_value = GET_ARG(params, key);
+        param_value = amxc_var_from_htable_it(it);
         if(NULL == param_value) {
             SAH_TRACEZ_ERROR(ME, "%s: failed to get value for %s", obj_info->name, key);
             continue;
@@ -479,6 +582,10 @@ static bool add_params_to_transaction(amxd_trans_t* transaction,
                              single_param->type);
             continue;
         }
+        if(object && is_param_unchanged(object, key, param_value)) {
+            SAH_TRACEZ_DEBUG(ME, "%s: value for %s is unchanged", obj_info->name, key);
+            continue;
+        }
         if(amxd_trans_set_param(transaction, key, param_value)) {
             SAH_TRACEZ_ERROR(ME, "%s: failed to add value for %s to transaction",
                              obj_info->name, key);
@@ -555,15 +662,63 @@ exit:
 }
 
 /**
- * Add an instance to the XPON DM.
+ * Add the actions to create an instance to a transaction.
  *
- * @param[in] info  all the info needed to create the instance
+ * @param[in,out] transaction  transaction to add the actions to
+ * @param[in] info             all the info needed to create the instance
+ * @param[in] templ            template object to create the instance for
  *
  * If the instance to be created has a read-write Enable parameter, and if that
- * instance is enabled according to the persistent data, create the instance
- * with that Enable parameter set to true, and schedule a timer to let this
+ * instance is enabled according to the persistent data, the function adds an
+ * action to set that Enable parameter to true, and schedules a timer to let this
  * know to the vendor module in 100 ms.
  *
+ * @return true on success, else false
+ */
+static bool add_instance_to_transaction(amxd_trans_t* const transaction,
+                                        const dm_action_info_t* const info,
+                                        amxd_object_t* const templ) {
+
+    bool rv = false;
+
+    const object_info_t* const obj_info = dm_get_object_info(info->obj_id);
+    when_null_trace(obj_info, exit, ERROR,
+                    "obj_info is NULL for obj_id=%d", info->obj_id);
+
+    const char* const key_name = obj_info->key_name; /* alias */
+
+    amxd_status_t rc = amxd_trans_select_object(transaction, templ);
+    when_failed_trace(rc, exit, ERROR, "Failed to select %s for transaction (rc=%d)",
+                      info->path, rc);
+
+    rc = amxd_trans_add_inst(transaction, info->index, NULL);
+    when_failed_trace(rc, exit, ERROR,
+                      "Failed to add creation of %s.%d to transaction (rc=%d)",
+                      info->path, info->index, rc);
+
+    rc = amxd_trans_set_param(transaction, key_name, info->key_value);
+    when_failed_trace(rc, exit, ERROR,
+                      "Failed to add value for key to transaction (rc=%d)", rc);
+
+    if(info->params) {
+        add_params_to_transaction(transaction, info->params, info->obj_id, NULL);
+    }
+
+    if(obj_info->has_rw_enable) {
+        update_enable(transaction, info->path, info->index);
+    }
+
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Finish adding an instance after the transaction creating it was applied.
+ *
+ * @param[in] info  all the info used to create the instance
+ *
  * If the instance created is an ONU instance, create and attach private data to
  * the instance to indicate the persistency of the RW Enable parameter has been
  * handled. The ANI also a has RW Enable parameter. The approach with the
@@ -583,6 +738,30 @@ exit:
  *
  * If the instance created is an ANI instance, restore its PON password if there
  * is one.
+ */
+static void add_instance_done(const dm_action_info_t* const info) {
+
+    SAH_TRACEZ_DEBUG(ME, "Created %s.%d", info->path, info->index);
+
+    if(info->obj_id == obj_id_onu) {
+        add_private_data_to_onu(info->path, info->index);
+    } else if(info->obj_id == obj_id_ani) {
+        amxc_string_t ani_instance;
+        amxc_string_init(&ani_instance, 0);
+        amxc_string_setf(&ani_instance, "%s.%d", info->path, info->index);
+        passwd_restore_password(amxc_string_get(&ani_instance, 0));
+        amxc_string_clean(&ani_instance);
+    }
+}
+
+/**
+ * Add an instance to the XPON DM.
+ *
+ * @param[in] info  all the info needed to create the instance
+ *
+ * See add_instance_to_transaction() and add_instance_done() for the extra
+ * actions done for instances with a read-write Enable parameter, and for ONU
+ * and ANI instances.
  *
  * @return true on success, else false
  */
@@ -593,10 +772,6 @@ static bool add_instance(const dm_action_info_t* const info) {
 
     SAH_TRACEZ_INFO(ME, "Create %s.%d", info->path, info->index);
 
-    const object_info_t* const obj_info = dm_get_object_info(info->obj_id);
-    when_null_trace(obj_info, exit_no_cleanup, ERROR,
-                    "obj_info is NULL for obj_id=%d", info->obj_id);
-
     if(!prepare_adding_instance(info->path, info->index, &templ)) {
         return false;
     }
@@ -608,44 +783,15 @@ static bool add_instance(const dm_action_info_t* const info) {
     amxd_trans_init(&transaction);
     amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
 
-    const char* const key_name = obj_info->key_name; /* alias */
-
-    amxd_status_t rc = amxd_trans_select_object(&transaction, templ);
-    when_failed_trace(rc, exit, ERROR, "Failed to select %s for transaction (rc=%d)",
-                      info->path, rc);
-
-    rc = amxd_trans_add_inst(&transaction, info->index, NULL);
-    when_failed_trace(rc, exit, ERROR,
-                      "Failed to add creation of %s.%d to transaction (rc=%d)",
-                      info->path, info->index, rc);
-
-    rc = amxd_trans_set_param(&transaction, key_name, info->key_value);
-    when_failed_trace(rc, exit, ERROR,
-                      "Failed to add value for key to transaction (rc=%d)", rc);
-
-    if(info->params) {
-        add_params_to_transaction(&transaction, info->params, info->obj_id);
-    }
-
-    if(obj_info->has_rw_enable) {
-        update_enable(&transaction, info->path, info->index);
+    if(!add_instance_to_transaction(&transaction, info, templ)) {
+        goto exit;
     }
 
-    rc = amxd_trans_apply(&transaction, dm);
+    const amxd_status_t rc = amxd_trans_apply(&transaction, dm);
     when_failed_trace(rc, exit, ERROR, "Failed to create %s.%d (rc=%d)",
                       info->path, info->index, rc);
 
-    SAH_TRACEZ_DEBUG(ME, "Created %s.%d", info->path, info->index);
-
-    if(obj_info->id == obj_id_onu) {
-        add_private_data_to_onu(info->path, info->index);
-    } else if(obj_info->id == obj_id_ani) {
-        amxc_string_t ani_instance;
-        amxc_string_init(&ani_instance, 0);
-        amxc_string_setf(&ani_instance, "%s.%d", info->path, info->index);
-        passwd_restore_password(amxc_string_get(&ani_instance, 0));
-        amxc_string_clean(&ani_instance);
-    }
+    add_instance_done(info);
 
     rv = true;
 
@@ -684,60 +830,121 @@ exit:
 }
 
 /**
- * Remove an from instance from to the XPON DM.
+ * Find the template object of an instance to be removed.
  *
- * @param[in] info  all the info needed to remove the instance
+ * @param[in] info        all the info needed to remove the instance
+ * @param[in,out] templ   function assigns pointer to template object if the
+ *                        instance exists, else it assigns NULL
  *
  * The function logs a warning and returns true if the instance does not exist.
  *
  * @return true on success, else false
  */
-static bool remove_instance(const dm_action_info_t* const info) {
+static bool find_instance_to_remove(const dm_action_info_t* const info,
+                                    amxd_object_t** templ) {
 
     bool rv = false;
-    amxd_object_t* obj;
-
-    SAH_TRACEZ_INFO(ME, "Delete %s.%d", info->path, info->index);
+    *templ = NULL;
 
     amxd_dm_t* const dm = xpon_mngr_get_dm();
-    when_null(dm, exit_no_cleanup);
+    when_null(dm, exit);
 
-    amxd_object_t* templ = amxd_dm_findf(dm, "%s", info->path);
-    if(!templ) {
+    amxd_object_t* const templ_candidate = amxd_dm_findf(dm, "%s", info->path);
+    if(!templ_candidate) {
         SAH_TRACEZ_WARNING(ME, "Failed to find %s", info->path);
-        return true;
+        rv = true;
+        goto exit;
     }
 
-    const amxd_object_type_t type = amxd_object_get_type(templ);
-    when_false_trace(amxd_object_template == type, exit_no_cleanup, ERROR,
+    const amxd_object_type_t type = amxd_object_get_type(templ_candidate);
+    when_false_trace(amxd_object_template == type, exit, ERROR,
                      "%s is not a template object", info->path);
 
-    obj = amxd_object_get_instance(templ, NULL, info->index);
-    if(!obj) {
+    if(!amxd_object_get_instance(templ_candidate, NULL, info->index)) {
         SAH_TRACEZ_WARNING(ME, "Instance %s.%d does not exist", info->path,
                            info->index);
-        return true;
+        rv = true;
+        goto exit;
     }
 
-    amxd_trans_t transaction;
-    amxd_trans_init(&transaction);
-    amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
+    *templ = templ_candidate;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Add the action to remove an instance to a transaction.
+ *
+ * @param[in,out] transaction  transaction to add the action to
+ * @param[in] info             all the info needed to remove the instance
+ * @param[in] templ            template object of the instance
+ *
+ * @return true on success, else false
+ */
+static bool remove_instance_to_transaction(amxd_trans_t* const transaction,
+                                           const dm_action_info_t* const info,
+                                           amxd_object_t* const templ) {
 
-    amxd_status_t rc = amxd_trans_select_object(&transaction, templ);
+    bool rv = false;
+
+    amxd_status_t rc = amxd_trans_select_object(transaction, templ);
     when_failed_trace(rc, exit, ERROR, "Failed to select %s for transaction (rc=%d)",
                       info->path, rc);
 
-    rc = amxd_trans_del_inst(&transaction, info->index, NULL);
+    rc = amxd_trans_del_inst(transaction, info->index, NULL);
     when_failed_trace(rc, exit, ERROR,
                       "Failed to add %s.%d for deletion to transaction (rc=%d)",
                       info->path, info->index, rc);
 
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Remove an from instance from to the XPON DM.
+ *
+ * @param[in] info  all the info needed to remove the instance
+ *
+ * The function logs a warning and returns true if the instance does not exist.
+ *
+ * @return true on success, else false
+ */
+static bool remove_instance(const dm_action_info_t* const info) {
+
+    bool rv = false;
+    amxd_object_t* templ = NULL;
+
+    SAH_TRACEZ_INFO(ME, "Delete %s.%d", info->path, info->index);
+
+    amxd_dm_t* const dm = xpon_mngr_get_dm();
+    when_null(dm, exit_no_cleanup);
+
+    if(!find_instance_to_remove(info, &templ)) {
+        goto exit_no_cleanup;
+    }
+    if(!templ) {
+        return true;
+    }
+
+    amxd_trans_t transaction;
+    amxd_trans_init(&transaction);
+    amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
+
+    if(!remove_instance_to_transaction(&transaction, info, templ)) {
+        goto exit;
+    }
+
     dm_actions_set_ignore_param_reads(true);
-    rc = amxd_trans_apply(&transaction, dm);
+    const amxd_status_t rc = amxd_trans_apply(&transaction, dm);
     when_failed_trace(rc, exit, ERROR, "Failed to delete %s.%d (rc=%d)",
                       info->path, info->index, rc);
 
     SAH_TRACEZ_DEBUG(ME, "Deleted %s.%d", info->path, info->index);
+    dm_coalesce_discard_subtree(info->path, info->index);
 
     rv = true;
 
@@ -805,84 +1012,294 @@ exit:
 }
 
 /**
- * Update one of more params of an object in the XPON DM.
+ * Remove an instance from the XPON DM.
  *
- * @param[in] args : must be htable with the keys 'path' and 'parameters'. If it
- *                   has a non-zero value for 'index', the function assumes the
- *                   caller wants to update the instance 'path'.'index'.
+ * @param[in] path   template path, e.g. "XPON.ONU.1.SoftwareImage"
+ * @param[in] index  instance index
  *
- * If the object is an ONU instance, check if the instance has private data. If
- * it doesn't, attach private data, and call update_enable() for that instance.
- * If the ONU instance has no private data yet, this process did not check yet
- * the persistent data to find out if the ONU instance should be enabled.
+ * Same as dm_remove_instance(), but without the need to pass the arguments in
+ * an htable.
  *
  * @return 0 on success, else -1.
  */
-int dm_change_object(const amxc_var_t* const args) {
+int dm_remove_instance_at(const char* const path, uint32_t index) {
 
     int rc = -1;
+    dm_action_info_t info;
+    init_dm_action_info(&info);
+
+    when_null_trace(path, exit, ERROR, "path is NULL");
+    when_false_trace(index != 0, exit, ERROR, "Invalid index");
+    info.path = path;
+    info.index = index;
+    info.obj_id = dm_get_object_id(path);
+    when_false_trace(obj_id_unknown != info.obj_id, exit, ERROR,
+                     "path='%s': failed to get ID", path);
+    when_false(remove_instance(&info), exit);
 
-    SAH_TRACEZ_DEBUG2(ME, "called");
+    rc = 0;
+exit:
+    return rc;
+}
+
+/**
+ * Find the object to be updated by dm_change_object().
+ *
+ * @param[in] info       info extracted from the arguments of dm_change_object()
+ * @param[in,out] path   the function sets it to the path of the object. If
+ *                       info->index is non-zero, it assumes the caller wants
+ *                       to update the instance 'path'.'index'.
+ *
+ * @return the object if it exists, else NULL
+ */
+static amxd_object_t* find_object_to_change(const dm_action_info_t* const info,
+                                            amxc_string_t* const path) {
+
+    amxd_object_t* object = NULL;
 
     amxd_dm_t* const dm = xpon_mngr_get_dm();
     when_null(dm, exit);
 
-    dm_action_info_t info;
-    if(!process_args_common(args, &info, CHANGE_OBJ_ARGS_REQUIRED,
-                            CHANGE_OBJ_N_ARGS_REQUIRED)) {
-        goto exit;
+    amxc_string_set(path, info->path);
+    if(info->index) {
+        /* Assume caller wants to update 'path'.'index' */
+        amxc_string_appendf(path, ".%d", info->index);
     }
+    object = amxd_dm_findf(dm, "%s", amxc_string_get(path, 0));
 
-    amxc_string_t path;
-    amxc_string_init(&path, 0);
-    amxc_string_set(&path, info.path);
+exit:
+    return object;
+}
 
-    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d", info.path, info.index);
+/**
+ * Add the actions to update an object to a transaction.
+ *
+ * @param[in,out] transaction   transaction to add the actions to
+ * @param[in] info              info extracted from the arguments of
+ *                              dm_change_object()
+ * @param[in] object            the object to update
+ * @param[in,out] attach_priv   the function sets it to true if @a object is an
+ *                              ONU instance without private data. The caller
+ *                              must then attach private data to the ONU
+ *                              instance once the transaction is applied.
+ * @param[in,out] changed       the function sets it to false if nothing
+ *                              changes for @a object. Then it does not add any
+ *                              action to @a transaction.
+ *
+ * If the object is an ONU instance without private data, this process did not
+ * check yet the persistent data to find out if the ONU instance should be
+ * enabled. Then the function also calls update_enable() for that instance.
+ *
+ * The function only adds the params whose value differs from the current
+ * value in the DM. The vendor module often passes all params of an object,
+ * even if only few or none of them changed.
+ *
+ * The caller must already have removed the Status param from info->params if
+ * the flap damping holds it back. See params_to_write().
+ *
+ * @return true on success, else false
+ */
+static bool change_object_to_transaction(amxd_trans_t* const transaction,
+                                         const dm_action_info_t* const info,
+                                         amxd_object_t* const object,
+                                         bool* const attach_priv,
+                                         bool* const changed) {
 
-    if(info.index) {
-        /* Assume caller wants to update 'path'.'index' */
-        amxc_string_appendf(&path, ".%d", info.index);
-    }
-    const char* const path_cstr = amxc_string_get(&path, 0);
+    bool rv = false;
+    const amxc_var_t* const params = info->params;
 
-    amxd_object_t* object = amxd_dm_findf(dm, "%s", path_cstr);
-    if(!object) {
-        SAH_TRACEZ_WARNING(ME, "%s does not exist: ignore object-changed", path_cstr);
-        amxc_string_clean(&path);
-        rc = 0;
+    *attach_priv = (info->obj_id == obj_id_onu) && (object->priv == NULL);
+    *changed = *attach_priv || has_changed_params(object, params, info->obj_id);
+
+    if(!*changed) {
+        rv = true;
         goto exit;
     }
 
+    const amxd_status_t status = amxd_trans_select_object(transaction, object);
+    when_failed_trace(status, exit, ERROR,
+                      "Failed to select %s for transaction (status=%d)",
+                      info->path, status);
+
+    add_params_to_transaction(transaction, params, info->obj_id, object);
+
+    if(*attach_priv) {
+        SAH_TRACEZ_DEBUG(ME, "%s.%d has no private data", info->path, info->index);
+        update_enable(transaction, info->path, info->index);
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Return the params of an update to write to the DM.
+ *
+ * @param[in] info              info extracted from the arguments of the update
+ * @param[in] object            object being updated
+ * @param[in,out] params_no_status  the function copies the params without
+ *                                  Status to it if needed
+ *
+ * If the object is an EthernetUNI or ANI instance, and the flap damping holds
+ * back its Status change, the function returns the params without Status.
+ * See object_intf_priv.c. Else it returns info->params.
+ *
+ * oipriv_hold_status() counts the flaps. Hence the caller must call this
+ * function once per update, also if it writes the update twice, e.g., when
+ * a batch transaction fails and the plugin applies each operation on its own.
+ */
+static const amxc_var_t* params_to_write(const dm_action_info_t* const info,
+                                         amxd_object_t* const object,
+                                         amxc_var_t* const params_no_status) {
+
+    const amxc_var_t* params = info->params;
+
+    if(((info->obj_id == obj_id_ethernet_uni) || (info->obj_id == obj_id_ani)) &&
+       oipriv_hold_status(object, GET_ARG(params, "Status"))) {
+        SAH_TRACEZ_INFO(ME, "%s.%d: hold back Status change", info->path, info->index);
+        amxc_var_copy(params_no_status, params);
+        amxc_var_t* held = GET_ARG(params_no_status, "Status");
+        amxc_var_delete(&held);
+        params = params_no_status;
+    }
+    return params;
+}
+
+/**
+ * Update one of more params of an object in the XPON DM.
+ *
+ * @param[in] info  info extracted from the arguments of dm_change_object() or
+ *                  dm_change_object_params()
+ * @param[in] hold_checked  true if info->params is already the result of
+ *                          params_to_write() for this update
+ *
+ * @return 0 on success, else -1.
+ */
+static int change_object(const dm_action_info_t* const info, bool hold_checked) {
+
+    int rc = -1;
+    bool attach_priv = false;
+    bool changed = false;
+    dm_action_info_t to_write = *info;
+    amxc_var_t params_no_status;
+    amxc_var_init(&params_no_status);
+
+    amxd_dm_t* const dm = xpon_mngr_get_dm();
+    when_null(dm, exit);
+
+    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d", info->path, info->index);
+
+    amxc_string_t path;
+    amxc_string_init(&path, 0);
+
     amxd_trans_t transaction;
     amxd_trans_init(&transaction);
     amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
 
-    amxd_status_t status = amxd_trans_select_object(&transaction, object);
-    when_failed_trace(status, exit_cleanup, ERROR,
-                      "Failed to select %s for transaction (status=%d)",
-                      info.path, status);
+    amxd_object_t* const object = find_object_to_change(info, &path);
+    const char* const path_cstr = amxc_string_get(&path, 0);
+    if(!object) {
+        SAH_TRACEZ_WARNING(ME, "%s does not exist: ignore object-changed", path_cstr);
+        rc = 0;
+        goto exit_cleanup;
+    }
 
-    add_params_to_transaction(&transaction, info.params, info.obj_id);
+    /* The values written now are newer than any buffered ones */
+    dm_coalesce_discard_params(info->path, info->index, info->params);
 
-    if(info.obj_id == obj_id_onu) {
-        if(object->priv == NULL) {
-            SAH_TRACEZ_DEBUG(ME, "%s has no private data", path_cstr);
-            onu_priv_attach_private_data(object);
-            update_enable(&transaction, info.path, info.index);
-        } else {
-            SAH_TRACEZ_DEBUG(ME, "%s already has private data", path_cstr);
-        }
+    if(!hold_checked) {
+        to_write.params = params_to_write(info, object, &params_no_status);
+    }
+    if(!change_object_to_transaction(&transaction, &to_write, object, &attach_priv,
+                                     &changed)) {
+        goto exit_cleanup;
+    }
+    if(!changed) {
+        SAH_TRACEZ_DEBUG(ME, "%s: no changes", path_cstr);
+        rc = 0;
+        goto exit_cleanup;
     }
 
-    status = amxd_trans_apply(&transaction, dm);
+    const amxd_status_t status = amxd_trans_apply(&transaction, dm);
     when_failed_trace(status, exit_cleanup, ERROR, "Failed to update %s (status=%d)",
-                      info.path, status);
+                      path_cstr, status);
+
+    if(attach_priv) {
+        onu_priv_attach_private_data(object);
+    }
 
     rc = 0;
 
 exit_cleanup:
     amxc_string_clean(&path);
     amxd_trans_clean(&transaction);
+exit:
+    amxc_var_clean(&params_no_status);
+    return rc;
+}
+
+/**
+ * Update one of more params of an object in the XPON DM.
+ *
+ * @param[in] args : must be htable with the keys 'path' and 'parameters'. If it
+ *                   has a non-zero value for 'index', the function assumes the
+ *                   caller wants to update the instance 'path'.'index'.
+ *
+ * If the object is an ONU instance, check if the instance has private data. If
+ * it doesn't, attach private data, and call update_enable() for that instance.
+ * If the ONU instance has no private data yet, this process did not check yet
+ * the persistent data to find out if the ONU instance should be enabled.
+ *
+ * @return 0 on success, else -1.
+ */
+int dm_change_object(const amxc_var_t* const args) {
+
+    int rc = -1;
+    dm_action_info_t info;
+
+    SAH_TRACEZ_DEBUG2(ME, "called");
+
+    if(!process_args_common(args, &info, CHANGE_OBJ_ARGS_REQUIRED,
+                            CHANGE_OBJ_N_ARGS_REQUIRED)) {
+        goto exit;
+    }
+    rc = change_object(&info, /*hold_checked=*/ false);
+
+exit:
+    return rc;
+}
+
+/**
+ * Update one of more params of an object in the XPON DM.
+ *
+ * @param[in] path    object path. If @a index is non-zero, the template path.
+ * @param[in] index   instance index, or 0 to update the object @a path itself
+ * @param[in] params  htable with the new param values
+ *
+ * Same as dm_change_object(), but without the need to pass the arguments in
+ * an htable.
+ *
+ * @return 0 on success, else -1.
+ */
+int dm_change_object_params(const char* const path, uint32_t index,
+                            const amxc_var_t* const params) {
+
+    int rc = -1;
+    dm_action_info_t info;
+    init_dm_action_info(&info);
+
+    when_null_trace(path, exit, ERROR, "path is NULL");
+    when_false_trace(amxc_var_type_of(params) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "params is not an htable");
+    info.path = path;
+    info.index = index;
+    info.obj_id = dm_get_object_id(path);
+    when_false_trace(obj_id_unknown != info.obj_id, exit, ERROR,
+                     "path='%s': failed to get ID", path);
+    info.params = params;
+    rc = change_object(&info, /*hold_checked=*/ false);
+
 exit:
     return rc;
 }
@@ -947,90 +1364,587 @@ exit:
 }
 
 /**
- * Remove all instances from a template object.
+ * Type of an operation in the list passed to dm_apply_batch_impl().
+ */
+typedef enum _batch_op_type {
+    batch_op_add = 0,
+    batch_op_remove,
+    batch_op_change,
+    batch_op_add_or_change,
+    batch_op_invalid
+} batch_op_type_t;
+
+static const char* const BATCH_OP_NAMES[batch_op_invalid] = {
+    "add", "remove", "change", "add_or_change"
+};
+
+/**
+ * Outcome of trying to add an operation of a batch to the current transaction.
+ *
+ * - batch_op_queued: the operation is added to the current transaction.
+ * - batch_op_done: the operation does not need a transaction, e.g. because it
+ *     asks to remove an instance which does not exist.
+ * - batch_op_failed: the operation is invalid.
+ * - batch_op_flush_first: the operation depends on operations which are in the
+ *     current transaction. The caller must apply the current transaction first
+ *     and then try again.
+ */
+typedef enum _batch_op_status {
+    batch_op_queued = 0,
+    batch_op_done,
+    batch_op_failed,
+    batch_op_flush_first
+} batch_op_status_t;
+
+/**
+ * An operation in the list passed to dm_apply_batch_impl().
+ *
+ * - args: the arguments of the operation. They are the same as the ones of
+ *     dm_add_instance(), dm_remove_instance(), dm_change_object() or
+ *     dm_add_or_change_instance_impl(), depending on 'requested'.
+ * - requested: type of operation requested by the vendor module
+ * - type: actual type of operation. It's only different from 'requested' if
+ *     'requested' is batch_op_add_or_change.
+ * - info: info extracted from 'args'
+ * - object: for a change operation, the object being updated
+ * - attach_priv: true if private data must be attached to 'object' after the
+ *     transaction is applied. See change_object_to_transaction().
+ * - params_no_status: for a change operation, the params without Status if
+ *     the flap damping holds back the Status change. See params_to_write().
+ * - queued: true if the operation is part of the current transaction
+ * - result: 0 on success, else -1
+ */
+typedef struct _batch_op {
+    const amxc_var_t* args;
+    batch_op_type_t requested;
+    batch_op_type_t type;
+    dm_action_info_t info;
+    amxd_object_t* object;
+    bool attach_priv;
+    amxc_var_t params_no_status;
+    bool queued;
+    int result;
+} batch_op_t;
+
+/**
+ * State of dm_apply_batch_impl() while it processes the operations.
+ *
+ * - transaction: transaction to which the function adds the operations
+ * - ops: array with all the operations of the batch
+ * - first: index in 'ops' of the 1st operation not handled by an earlier
+ *     transaction
+ * - n_queued: number of operations in 'transaction'
+ * - n_transactions: number of transactions applied (for logging only)
+ * - pending: htable with the objects the current transaction adds, removes
+ *     or changes. The key is the path of the object, e.g. "XPON.ONU.1.ANI.1",
+ *     and the value is "add", "remove" or "change". A 2nd change of the same
+ *     object must start a new transaction: change_object_to_transaction()
+ *     compares the new values with the DM, not with the values queued in the
+ *     current transaction.
+ * - has_remove: true if the current transaction removes one or more instances
+ * - broken: true if the function failed to add an operation to 'transaction'.
+ *     Then 'transaction' might be incomplete and it must not be applied.
+ */
+typedef struct _batch {
+    amxd_trans_t transaction;
+    batch_op_t* ops;
+    uint32_t first;
+    uint32_t n_queued;
+    uint32_t n_transactions;
+    amxc_var_t pending;
+    bool has_remove;
+    bool broken;
+} batch_t;
+
+static void batch_reset_transaction(batch_t* const batch) {
+    amxd_trans_clean(&batch->transaction);
+    amxd_trans_init(&batch->transaction);
+    amxd_trans_set_attr(&batch->transaction, amxd_tattr_change_ro, true);
+    amxc_var_set_type(&batch->pending, AMXC_VAR_ID_HTABLE);
+    batch->n_queued = 0;
+    batch->has_remove = false;
+    batch->broken = false;
+}
+
+static void batch_init(batch_t* const batch, batch_op_t* const ops) {
+    amxd_trans_init(&batch->transaction);
+    amxc_var_init(&batch->pending);
+    batch->ops = ops;
+    batch->first = 0;
+    batch->n_transactions = 0;
+    batch_reset_transaction(batch);
+}
+
+static void batch_clean(batch_t* const batch) {
+    amxd_trans_clean(&batch->transaction);
+    amxc_var_clean(&batch->pending);
+}
+
+static batch_op_type_t batch_get_op_type(const amxc_var_t* const op_args) {
+
+    const char* const action = GET_CHAR(op_args, "action");
+    when_null_trace(action, exit, ERROR, "Operation has no 'action'");
+
+    uint32_t i;
+    for(i = 0; i < batch_op_invalid; ++i) {
+        if(strcmp(action, BATCH_OP_NAMES[i]) == 0) {
+            return (batch_op_type_t) i;
+        }
+    }
+    SAH_TRACEZ_ERROR(ME, "Unknown action: '%s'", action);
+
+exit:
+    return batch_op_invalid;
+}
+
+/**
+ * Return true if the current transaction of @a batch adds, removes or changes
+ * @a path, or if it removes an ancestor of @a path.
+ */
+static bool batch_conflicts(const batch_t* const batch, const char* const path) {
+
+    const amxc_htable_t* const pending = amxc_var_constcast(amxc_htable_t, &batch->pending);
+    if(amxc_htable_contains(pending, path)) {
+        return true;
+    }
+
+    size_t len;
+    const char* key;
+    amxc_var_for_each(action, &batch->pending) {
+        if(strcmp(amxc_var_constcast(cstring_t, action), "remove") != 0) {
+            continue;
+        }
+        key = amxc_var_key(action);
+        len = strlen(key);
+        if((strncmp(path, key, len) == 0) && (path[len] == '.')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Try to add a create, remove or change operation to the current transaction.
  *
- * @param[in] templ  template object to remove all instances from
+ * @param[in,out] batch  state of dm_apply_batch_impl()
+ * @param[in,out] op     the operation
  *
- * Example: @a template can refer to "XPON.ONU.1.ANI.1.TC.GEM.Port".
+ * @return see batch_op_status_t
+ */
+static batch_op_status_t batch_queue_op(batch_t* const batch, batch_op_t* const op) {
+
+    batch_op_status_t status = batch_op_failed;
+    const bool can_flush = (batch->n_queued != 0);
+    bool changed = false;
+    amxd_object_t* templ = NULL;
+    dm_action_info_t* const info = &op->info;
+
+    amxc_string_t path;
+    amxc_string_init(&path, 0);
+
+    op->type = op->requested;
+    if(batch_op_add_or_change == op->requested) {
+        if(!process_args_common(op->args, info, ADD_OR_CHANGE_INST_ARGS_REQUIRED,
+                                ADD_OR_CHANGE_INST_N_ARGS_REQUIRED)) {
+            goto exit;
+        }
+        amxc_string_setf(&path, "%s.%d", info->path, info->index);
+        if(can_flush && batch_conflicts(batch, amxc_string_get(&path, 0))) {
+            status = batch_op_flush_first;
+            goto exit;
+        }
+        op->type = dm_does_instance_exist(info->path, info->index) ?
+            batch_op_change : batch_op_add;
+    }
+
+    switch(op->type) {
+    case batch_op_add:
+        when_false(process_add_instance_args(op->args, info), exit);
+        amxc_string_setf(&path, "%s.%d", info->path, info->index);
+        if(can_flush && batch_conflicts(batch, amxc_string_get(&path, 0))) {
+            status = batch_op_flush_first;
+            goto exit;
+        }
+        if(!prepare_adding_instance(info->path, info->index, &templ)) {
+            /* The template might be created by the current transaction */
+            status = can_flush ? batch_op_flush_first : batch_op_failed;
+            goto exit;
+        }
+        if(!add_instance_to_transaction(&batch->transaction, info, templ)) {
+            batch->broken = true;
+        }
+        amxc_var_add_key(cstring_t, &batch->pending, amxc_string_get(&path, 0), "add");
+        break;
+
+    case batch_op_remove:
+        when_false(process_remove_instance_args(op->args, info), exit);
+        amxc_string_setf(&path, "%s.%d", info->path, info->index);
+        if(can_flush && batch_conflicts(batch, amxc_string_get(&path, 0))) {
+            status = batch_op_flush_first;
+            goto exit;
+        }
+        when_false(find_instance_to_remove(info, &templ), exit);
+        if(!templ) {
+            status = batch_op_done;
+            goto exit;
+        }
+        if(!remove_instance_to_transaction(&batch->transaction, info, templ)) {
+            batch->broken = true;
+        }
+        amxc_var_add_key(cstring_t, &batch->pending, amxc_string_get(&path, 0), "remove");
+        batch->has_remove = true;
+        break;
+
+    case batch_op_change:
+        if(!process_args_common(op->args, info, CHANGE_OBJ_ARGS_REQUIRED,
+                                CHANGE_OBJ_N_ARGS_REQUIRED)) {
+            goto exit;
+        }
+        op->object = find_object_to_change(info, &path);
+        if(can_flush && batch_conflicts(batch, amxc_string_get(&path, 0))) {
+            status = batch_op_flush_first;
+            goto exit;
+        }
+        if(!op->object) {
+            if(can_flush) {
+                /* The object might be created by the current transaction */
+                status = batch_op_flush_first;
+            } else {
+                SAH_TRACEZ_WARNING(ME, "%s does not exist: ignore object-changed",
+                                   amxc_string_get(&path, 0));
+                status = batch_op_done;
+            }
+            goto exit;
+        }
+        dm_coalesce_discard_params(info->path, info->index, info->params);
+        info->params = params_to_write(info, op->object, &op->params_no_status);
+        if(!change_object_to_transaction(&batch->transaction, info, op->object,
+                                         &op->attach_priv, &changed)) {
+            batch->broken = true;
+        } else if(!changed) {
+            status = batch_op_done;
+            goto exit;
+        }
+        amxc_var_add_key(cstring_t, &batch->pending, amxc_string_get(&path, 0), "change");
+        break;
+
+    default:
+        goto exit;
+    }
+
+    status = batch_op_queued;
+
+exit:
+    amxc_string_clean(&path);
+    return status;
+}
+
+/**
+ * Handle an operation of a batch on its own, outside of any batch transaction.
  *
- * @return true on success, else false
+ * @return 0 on success, else -1
  */
-static bool remove_all_instances(amxd_object_t* templ) {
+static int batch_apply_single_op(const batch_op_t* const op) {
+
+    switch(op->type) {
+    case batch_op_add:
+        return dm_add_instance(op->args);
+    case batch_op_remove:
+        return dm_remove_instance(op->args);
+    case batch_op_change:
+        /* Do not check the flap damping again: batch_queue_op() did */
+        return change_object(&op->info, /*hold_checked=*/ true);
+    default:
+        break;
+    }
+    return -1;
+}
 
-    bool rv = false;
+/**
+ * Apply the current transaction of a batch.
+ *
+ * @param[in,out] batch  state of dm_apply_batch_impl()
+ * @param[in] end        index in batch->ops of the 1st operation which is not
+ *                       part of the current transaction
+ *
+ * If the transaction fails, the function handles each operation of the
+ * transaction on its own to find out which operation(s) failed. This gives a
+ * correct result for each operation, at the cost of extra transactions in this
+ * (normally exceptional) case.
+ *
+ * Afterwards the function starts a new (empty) transaction.
+ */
+static void batch_flush(batch_t* const batch, uint32_t end) {
+
+    uint32_t i;
+    batch_op_t* op;
+    bool applied = false;
 
-    when_null(templ, exit_no_cleanup);
+    when_true(batch->n_queued == 0, exit);
 
     amxd_dm_t* const dm = xpon_mngr_get_dm();
-    when_null(dm, exit_no_cleanup);
+    when_null(dm, exit);
 
-    if(amxd_object_get_type(templ) != amxd_object_template) {
-        SAH_TRACEZ_ERROR(ME, "Parameter 'templ' is not a template");
-        goto exit_no_cleanup;
+    if(!batch->broken) {
+        if(batch->has_remove) {
+            dm_actions_set_ignore_param_reads(true);
+        }
+        const amxd_status_t status = amxd_trans_apply(&batch->transaction, dm);
+        dm_actions_set_ignore_param_reads(false);
+        ++batch->n_transactions;
+        if(status == amxd_status_ok) {
+            applied = true;
+        } else {
+            SAH_TRACEZ_WARNING(ME, "Failed to apply transaction with %d operations "
+                               "(status=%d): apply them one by one",
+                               batch->n_queued, status);
+        }
     }
 
-    const uint32_t nr_instances = amxd_object_get_instance_count(templ);
-    if(0 == nr_instances) {
-        SAH_TRACEZ_DEBUG(ME, "No instances");
-        rv = true;
+    for(i = batch->first; i < end; ++i) {
+        op = &batch->ops[i];
+        if(!op->queued) {
+            continue;
+        }
+        op->queued = false;
+        if(!applied) {
+            op->result = batch_apply_single_op(op);
+            ++batch->n_transactions;
+            continue;
+        }
+        op->result = 0;
+        if(batch_op_add == op->type) {
+            add_instance_done(&op->info);
+        } else if(batch_op_remove == op->type) {
+            dm_coalesce_discard_subtree(op->info.path, op->info.index);
+        } else if((batch_op_change == op->type) && op->attach_priv) {
+            onu_priv_attach_private_data(op->object);
+        }
+    }
+
+exit:
+    batch->first = end;
+    batch_reset_transaction(batch);
+}
+
+/**
+ * Apply an ordered list of create, remove and change operations to the XPON DM.
+ *
+ * @param[in] args : must be htable with the key 'operations'. Its value must be
+ *                   a list. Each element in the list must be an htable with
+ *                   the key 'action' and the arguments for that action. The
+ *                   value of 'action' must be one of:
+ *                   - "add": same arguments as dm_add_instance()
+ *                   - "remove": same arguments as dm_remove_instance()
+ *                   - "change": same arguments as dm_change_object()
+ *                   - "add_or_change": same arguments as
+ *                     dm_add_or_change_instance_impl()
+ * @param[in,out] ret : the function returns a list with one integer per
+ *                   operation via this parameter: 0 if the operation
+ *                   succeeded, else -1. It can be NULL.
+ *
+ * The function applies the operations in the order given by @a args, and it
+ * groups them in as few transactions as possible. It only starts a new
+ * transaction if an operation depends on an earlier operation in the current
+ * transaction, e.g. if it updates an instance the current transaction creates.
+ *
+ * @return 0 if all operations succeeded, else -1.
+ */
+int dm_apply_batch_impl(const amxc_var_t* const args, amxc_var_t* const ret) {
+
+    int rc = -1;
+    uint32_t i = 0;
+    uint32_t n_failed = 0;
+    batch_op_t* ops = NULL;
+    batch_t batch;
+
+    SAH_TRACEZ_DEBUG2(ME, "called");
+
+    when_null_trace(args, exit_no_cleanup, ERROR, "args is NULL");
+
+    const amxc_var_t* const operations = GET_ARG(args, "operations");
+    when_null_trace(operations, exit_no_cleanup, ERROR, "args has no 'operations'");
+    when_false_trace(amxc_var_type_of(operations) == AMXC_VAR_ID_LIST, exit_no_cleanup,
+                     ERROR, "'operations' is not a list");
+
+    const size_t n_ops = amxc_llist_size(amxc_var_constcast(amxc_llist_t, operations));
+    if(ret) {
+        amxc_var_set_type(ret, AMXC_VAR_ID_LIST);
+    }
+    if(0 == n_ops) {
+        rc = 0;
         goto exit_no_cleanup;
     }
 
-    amxd_trans_t transaction;
-    amxd_trans_init(&transaction);
-    amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
+    ops = (batch_op_t*) calloc(n_ops, sizeof(batch_op_t));
+    when_null_trace(ops, exit_no_cleanup, ERROR, "Failed to allocate memory");
+
+    batch_init(&batch, ops);
+
+    batch_op_t* op;
+    batch_op_status_t status;
+    amxc_var_for_each(op_args, operations) {
+        op = &ops[i];
+        amxc_var_init(&op->params_no_status);
+        op->args = op_args;
+        op->result = -1;
+        op->requested = batch_get_op_type(op_args);
+        if(batch_op_invalid != op->requested) {
+            status = batch_queue_op(&batch, op);
+            if(batch_op_flush_first == status) {
+                batch_flush(&batch, i);
+                status = batch_queue_op(&batch, op);
+            }
+            if(batch_op_queued == status) {
+                op->queued = true;
+                ++batch.n_queued;
+            } else if(batch_op_done == status) {
+                op->result = 0;
+            }
+        }
+        ++i;
+    }
+    batch_flush(&batch, i);
 
-    int rc = amxd_trans_select_object(&transaction, templ);
-    when_failed_trace(rc, exit, ERROR, "Failed to select template object");
+    for(i = 0; i < n_ops; ++i) {
+        if(ops[i].result != 0) {
+            ++n_failed;
+        }
+        if(ret) {
+            amxc_var_add(int32_t, ret, ops[i].result);
+        }
+    }
+    SAH_TRACEZ_INFO(ME, "Applied %zu operations in %d transaction(s): %d failed",
+                    n_ops, batch.n_transactions, n_failed);
 
-    uint32_t index;
+    rc = (0 == n_failed) ? 0 : -1;
+
+    batch_clean(&batch);
+    for(i = 0; i < n_ops; ++i) {
+        amxc_var_clean(&ops[i].params_no_status);
+    }
+    free(ops);
+
+exit_no_cleanup:
+    return rc;
+}
+
+/**
+ * Add the actions to remove all instances of a template object to a transaction.
+ *
+ * @param[in,out] transaction  transaction to add the actions to
+ * @param[in] templ            template object
+ *
+ * @return the number of instances the transaction will remove
+ */
+static uint32_t remove_all_instances_to_transaction(amxd_trans_t* const transaction,
+                                                    amxd_object_t* const templ) {
+
+    uint32_t n_removed = 0;
     amxd_object_t* obj_inst = NULL;
 
+    when_true(0 == amxd_object_get_instance_count(templ), exit);
+
+    amxd_status_t rc = amxd_trans_select_object(transaction, templ);
+    when_failed_trace(rc, exit, ERROR, "Failed to select template object");
+
     amxd_object_iterate(instance, it, templ) {
         obj_inst = amxc_container_of(it, amxd_object_t, it);
-        index = amxd_object_get_index(obj_inst);
-        rc = amxd_trans_del_inst(&transaction, index, NULL);
+        rc = amxd_trans_del_inst(transaction, amxd_object_get_index(obj_inst), NULL);
         when_failed_trace(rc, exit, ERROR, "Failed to add deletion to transaction");
+        ++n_removed;
     }
 
-    rc = amxd_trans_apply(&transaction, dm);
-    when_failed_trace(rc, exit, ERROR, "Failed to apply transaction (rc=%d)", rc);
+exit:
+    return n_removed;
+}
 
-    rv = true;
+/**
+ * Remove all instances of a template object without a transaction.
+ *
+ * Unlike a transaction, this does not emit an event per instance removed.
+ *
+ * @param[in] templ        template object
+ * @param[in] counter_obj  the object with the NumberOfEntries parameter which
+ *                         counts the instances of @a templ
+ * @param[in] counter      the name of that parameter
+ *
+ * @return the number of instances removed
+ */
+static uint32_t delete_all_instances(amxd_object_t* const templ,
+                                     amxd_object_t* const counter_obj,
+                                     const char* const counter) {
 
-exit:
-    amxd_trans_clean(&transaction);
+    uint32_t n_removed = 0;
+    amxd_object_t* obj_inst = NULL;
 
-exit_no_cleanup:
-    return rv;
+    amxd_object_for_each(instance, it, templ) {
+        obj_inst = amxc_container_of(it, amxd_object_t, it);
+        amxd_object_delete(&obj_inst);
+        ++n_removed;
+    }
+    if(n_removed != 0) {
+        amxd_object_set_value(uint32_t, counter_obj, counter,
+                              amxd_object_get_instance_count(templ));
+    }
+    return n_removed;
 }
 
 /**
- * For all EthernetUNI instances of the ONU, set Status to Down if it is Up now.
+ * Add the actions to set Status to Down for all EthernetUNI instances of an
+ * ONU whose Status is Up to a transaction.
+ *
+ * @return the number of EthernetUNI instances whose Status will change
  */
-static void set_ethernet_uni_status_to_down(const amxd_object_t* const onu_instance,
-                                            const char* const path) {
+static uint32_t ethernet_uni_status_down_to_transaction(amxd_trans_t* const transaction,
+                                                        const amxd_object_t* const onu_instance,
+                                                        const char* const path) {
+
+    uint32_t n_changed = 0;
+    const char* status;
+    char uni_path[32];
+    amxc_var_t status_param;
+    amxc_var_init(&status_param);
+    amxc_var_set_type(&status_param, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &status_param, "Status", "Down");
 
     const amxd_object_t* ethernet_uni = amxd_object_get_child(onu_instance, "EthernetUNI");
     when_null_trace(ethernet_uni, exit, ERROR, "%s.EthernetUNI does not exist", path);
 
-    char* current_status_cstr;
     amxd_object_iterate(instance, it, ethernet_uni) {
         amxd_object_t* const eth_uni_inst = amxc_container_of(it, amxd_object_t, it);
         if(NULL == eth_uni_inst) {
             SAH_TRACEZ_ERROR(ME, "Failed to get EthernetUNI object");
             continue;
         }
-        current_status_cstr = amxd_object_get_value(cstring_t, eth_uni_inst, "Status", NULL);
-        if(current_status_cstr) {
-            if(strncmp(current_status_cstr, "Up", 2) == 0) {
-                amxd_object_set_value(cstring_t, eth_uni_inst, "Status", "Down");
-            }
-            free(current_status_cstr);
+        status = amxc_var_constcast(cstring_t,
+                                    amxd_object_get_param_value(eth_uni_inst, "Status"));
+        if(!status || (strcmp(status, "Up") != 0)) {
+            continue;
+        }
+        if(amxd_trans_select_object(transaction, eth_uni_inst) ||
+           amxd_trans_set_value(cstring_t, transaction, "Status", "Down")) {
+            SAH_TRACEZ_ERROR(ME, "%s: failed to add Status change to transaction", path);
+            continue;
         }
+        snprintf(uni_path, sizeof(uni_path), "%s.EthernetUNI", path);
+        dm_coalesce_discard_params(uni_path, amxd_object_get_index(eth_uni_inst), &status_param);
+        ++n_changed;
     }
 exit:
-    return;
+    amxc_var_clean(&status_param);
+    return n_changed;
+}
+
+/**
+ * Return true if the plugin must emit one aggregated event for an OMCI reset
+ * MIB instead of an event per GEM port removed.
+ *
+ * See the config option OMCI_RESET_MIB_AGGREGATED_EVENT.
+ */
+static bool use_aggregated_reset_mib_event(void) {
+    const amxo_parser_t* const parser = xpon_mngr_get_parser();
+    return parser ? GET_BOOL(&parser->config, OMCI_RESET_MIB_AGGREGATED_EVENT) : false;
 }
 
 /**
@@ -1044,55 +1958,120 @@ exit:
  * - For all EthernetUNI instances of the ONU, set Status to Down if it is Up now.
  * - For all ANI instances of the ONU, remove all TC.GEM.Port instances.
  *
+ * It does all that with one transaction. An ONU might have thousands of GEM
+ * ports.
+ *
+ * If the config option OMCI_RESET_MIB_AGGREGATED_EVENT is true, the function
+ * removes the GEM ports outside the transaction, so no event is emitted per GEM
+ * port. It then emits one event OMCI_RESET_MIB_EVENT for the ONU instance. The
+ * Status changes of the EthernetUNI instances still emit the usual events.
+ *
  * @return 0 on success, else -1
  */
 int dm_omci_reset_mib(const amxc_var_t* const args) {
 
-    int rc = -1;
-
     SAH_TRACEZ_DEBUG2(ME, "called");
+    if(NULL == args) {
+        SAH_TRACEZ_ERROR(ME, "args is NULL");
+        return -1;
+    }
+    return dm_omci_reset_mib_onu(GET_UINT32(args, "index"));
+}
 
-    when_null_trace(args, exit, ERROR, "args is NULL");
+/**
+ * Handle an OMCI reset MIB message for an ONU.
+ *
+ * @param[in] index : index of the XPON.ONU instance
+ *
+ * Same as dm_omci_reset_mib(), but without the need to pass the index in an
+ * htable.
+ *
+ * @return 0 on success, else -1
+ */
+int dm_omci_reset_mib_onu(uint32_t index) {
+
+    int rc = -1;
+    uint32_t n_unis = 0;
+    uint32_t n_gem_ports = 0;
+    const uint64_t start = time_get_monotonic_ms();
 
     amxd_dm_t* const dm = xpon_mngr_get_dm();
-    when_null(dm, exit);
+    when_null(dm, exit_no_cleanup);
 
-    const uint32_t index = GET_UINT32(args, "index");
-    when_false_trace(index != 0, exit, ERROR, "Failed to extract valid index from args");
+    when_false_trace(index != 0, exit_no_cleanup, ERROR, "Invalid ONU index");
 
     char path[16];
     snprintf(path, 16, "XPON.ONU.%d", index);
-    const amxd_object_t* onu_instance = amxd_dm_findf(dm, "%s", path);
+    amxd_object_t* const onu_instance = amxd_dm_findf(dm, "%s", path);
     if(!onu_instance) {
         SAH_TRACEZ_WARNING(ME, "%s does not exist: ignore omci:reset-mib", path);
         rc = 0;
-        goto exit;
+        goto exit_no_cleanup;
     }
 
-    set_ethernet_uni_status_to_down(onu_instance, path);
+    const bool aggregated = use_aggregated_reset_mib_event();
+
+    amxd_trans_t transaction;
+    amxd_trans_init(&transaction);
+    amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
+
+    n_unis = ethernet_uni_status_down_to_transaction(&transaction, onu_instance, path);
 
     /* Remove GEM ports */
     const amxd_object_t* ani = amxd_object_get_child(onu_instance, "ANI");
     if(ani) {
         amxd_object_iterate(instance, it, ani) {
             amxd_object_t* const ani_inst = amxc_container_of(it, amxd_object_t, it);
-            amxd_object_t* const port_templ = amxd_object_findf(ani_inst, "TC.GEM.Port");
+            amxd_object_t* const gem = amxd_object_findf(ani_inst, "TC.GEM");
+            amxd_object_t* const port_templ = gem ? amxd_object_get_child(gem, "Port") : NULL;
             if(!port_templ) {
                 SAH_TRACEZ_ERROR(ME, "%s: failed to find TC.GEM.Port for ANI.%d",
                                  path, amxd_object_get_index(ani_inst));
                 continue;
             }
-            if(!remove_all_instances(port_templ)) {
-                SAH_TRACEZ_ERROR(ME, "%s: failed to delete GEM ports for ANI.%d",
-                                 path, amxd_object_get_index(ani_inst));
+            char port_path[64];
+            snprintf(port_path, sizeof(port_path), "%s.ANI.%d.TC.GEM.Port", path,
+                     amxd_object_get_index(ani_inst));
+            dm_coalesce_discard_subtree(port_path, 0);
+            if(aggregated) {
+                dm_actions_set_ignore_param_reads(true);
+                n_gem_ports += delete_all_instances(port_templ, gem, "PortNumberOfEntries");
+                dm_actions_set_ignore_param_reads(false);
+            } else {
+                n_gem_ports += remove_all_instances_to_transaction(&transaction, port_templ);
             }
         }
     } else {
         SAH_TRACEZ_ERROR(ME, "%s.ANI does not exist", path);
     }
 
+    if((n_unis != 0) || (!aggregated && (n_gem_ports != 0))) {
+        dm_actions_set_ignore_param_reads(true);
+        const amxd_status_t status = amxd_trans_apply(&transaction, dm);
+        dm_actions_set_ignore_param_reads(false);
+        when_failed_trace(status, exit, ERROR, "%s: failed to apply transaction (status=%d)",
+                          path, status);
+    }
+
+    if(aggregated) {
+        amxc_var_t data;
+        amxc_var_init(&data);
+        amxc_var_set_type(&data, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(uint32_t, &data, "EthernetUNIsDown", n_unis);
+        amxc_var_add_key(uint32_t, &data, "GEMPortsRemoved", n_gem_ports);
+        amxd_object_emit_signal(onu_instance, OMCI_RESET_MIB_EVENT, &data);
+        amxc_var_clean(&data);
+    }
+
+    SAH_TRACEZ_INFO(ME, "%s: handled omci:reset-mib in %" PRIu64 " ms: %d EthernetUNI(s) "
+                    "down, %d GEM port(s) removed", path, time_get_monotonic_ms() - start,
+                    n_unis, n_gem_ports);
     rc = 0;
+
 exit:
+    amxd_trans_clean(&transaction);
+
+exit_no_cleanup:
     return rc;
 }
 
@@ -69,7 +69,7 @@
 #include <stdio.h>
 #endif
 #include <stdlib.h> /* free() */
-#include <string.h> /* strlen() */
+#include <string.h> /* memcpy(), strcmp(), strlen() */
 
 /* Other libraries' headers */
 #include <amxc/amxc_macros.h>
@@ -81,11 +81,16 @@
 
 /* Own headers */
 #include "ani.h"              /* ani_strip_tc_authentication() */
+#include "call_stats.h"       /* call_stats_get_summary() */
+#include "dm_coalesce.h"      /* dm_coalesce_get_pending_value() */
+#include "dm_info.h"          /* dm_get_object_id() */
+#include "dm_pull.h"          /* dm_pull_param_value() */
 #include "object_intf_priv.h" /* object_intf_priv_t */
 #include "onu_priv.h"         /* onu_priv_t */
 #include "password.h"         /* passwd_check_password() */
 #include "pon_ctrl.h"         /* pon_ctrl_get_param_values() */
-#include "utils_time.h"       /* time_get_system_uptime() */
+#include "trx_cache.h"        /* trx_cache_get_value() */
+#include "utils_time.h"       /* time_get_cached_monotonic_ms() */
 #include "xpon_trace.h"
 
 /**
@@ -203,6 +208,12 @@ amxd_status_t _read_trx_param(amxd_object_t* object,
     amxc_var_t ret;
     amxc_var_init(&ret);
 
+    /* Try the snapshot cache first. See trx_cache.c. */
+    if(trx_cache_get_value(object, path, param_name, retval)) {
+        rv = 0;
+        goto exit_cleanup;
+    }
+
     if(pon_ctrl_get_param_values(path, param_name, &ret) != 0) {
         SAH_TRACEZ_ERROR(ME, "Failed to query %s.%s", path, param_name);
         goto exit_cleanup;
@@ -217,6 +228,7 @@ amxd_status_t _read_trx_param(amxd_object_t* object,
     if(!process_param_value(param_name, &ret, retval)) {
         goto exit_cleanup;
     }
+    trx_cache_evaluate_value(object, param_name, retval);
 
     rv = 0;
 
@@ -228,6 +240,254 @@ exit:
     return rv;
 }
 
+/**
+ * Write the indexed path of @a object to @a buf.
+ *
+ * Same as amxd_object_get_path(object, AMXD_OBJECT_INDEXED), but without
+ * allocating memory. _read_coalesced_param() is called for every read of a
+ * coalesced or pulled parameter.
+ *
+ * @return true on success, false if @a buf is too small
+ */
+#define MAX_PATH_DEPTH 16
+static bool get_object_path(amxd_object_t* object, char* const buf, size_t size) {
+
+    const char* names[MAX_PATH_DEPTH];
+    int depth = 0;
+    size_t len = 0;
+
+    while((object != NULL) && (amxd_object_get_type(object) != amxd_object_root)) {
+        when_true(depth == MAX_PATH_DEPTH, error);
+        names[depth++] = amxd_object_get_name(object, AMXD_OBJECT_INDEXED);
+        when_null(names[depth - 1], error);
+        object = amxd_object_get_parent(object);
+    }
+    when_true(depth == 0, error);
+
+    while(depth > 0) {
+        const char* const name = names[--depth];
+        const size_t name_len = strlen(name);
+        when_true(len + name_len + 2 > size, error);
+        memcpy(buf + len, name, name_len);
+        len += name_len;
+        if(depth > 0) {
+            buf[len++] = '.';
+        }
+    }
+    buf[len] = '\0';
+    return true;
+
+error:
+    return false;
+}
+
+/**
+ * Read a parameter whose updates might be in the write-behind buffer, or
+ * whose object might have a pull update policy.
+ *
+ * If the object has a pull update policy, query the value in the vendor
+ * module. See dm_pull.c. Else, if the buffer has a value for the parameter
+ * which is not yet written to the DM, return that value. See dm_coalesce.c.
+ */
+amxd_status_t _read_coalesced_param(amxd_object_t* object,
+                                    amxd_param_t* param,
+                                    amxd_action_t reason,
+                                    const amxc_var_t* const args,
+                                    amxc_var_t* const retval,
+                                    void* priv) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+
+    when_null_status(object, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    rv = amxd_action_param_read(object, param, reason, args, retval, priv);
+    when_failed(rv, exit);
+
+    when_true(amxd_object_template == amxd_object_get_type(object), exit);
+
+    char path[256];
+    when_false_trace(get_object_path(object, path, sizeof(path)), exit, ERROR,
+                     "Failed to get path of object");
+
+    /* Return early if neither dm_pull.c nor dm_coalesce.c handles the object */
+    const object_id_t id = dm_get_object_id(path);
+    when_true(obj_id_unknown == id, exit);
+    if((update_policy_push == dm_get_update_policy(id, NULL)) &&
+       !dm_coalesce_has_pending(id)) {
+        goto exit;
+    }
+
+    if(s_ignore_param_reads || !dm_pull_param_value(object, param, path, retval)) {
+        dm_coalesce_get_pending_value(path, amxd_param_get_name(param), retval);
+    }
+
+exit:
+    return rv;
+}
+
+/**
+ * Called if a parameter of XPON.Coalescing is read.
+ *
+ * The parameters are volatile: the function returns the statistics of the
+ * write-behind buffer. See dm_coalesce.c.
+ */
+amxd_status_t _coalescing_stats_on_read(UNUSED amxd_object_t* object,
+                                        amxd_param_t* param,
+                                        amxd_action_t reason,
+                                        UNUSED const amxc_var_t* const args,
+                                        amxc_var_t* const retval,
+                                        UNUSED void* priv) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+    amxc_string_t ratios;
+    amxc_string_init(&ratios, 0);
+
+    when_false_status(reason == action_param_read, exit, rv = amxd_status_invalid_action);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    const char* const name = amxd_param_get_name(param);
+    when_null(name, exit);
+
+    if(strcmp(name, "Updates") == 0) {
+        amxc_var_set(uint64_t, retval, dm_coalesce_get_nr_of_updates());
+    } else if(strcmp(name, "Writes") == 0) {
+        amxc_var_set(uint64_t, retval, dm_coalesce_get_nr_of_writes());
+    } else if(strcmp(name, "MergeRatios") == 0) {
+        dm_coalesce_get_merge_ratios(&ratios);
+        amxc_var_set(cstring_t, retval, amxc_string_get(&ratios, 0));
+    } else {
+        SAH_TRACEZ_ERROR(ME, "Unknown param: %s", name);
+        goto exit;
+    }
+    rv = amxd_status_ok;
+
+exit:
+    amxc_string_clean(&ratios);
+    return rv;
+}
+
+/**
+ * Read the min, max or average of a volatile Transceiver parameter.
+ *
+ * The function returns the value over the samples of the background
+ * sampler, e.g. RxPowerAvg. See trx_cache.c.
+ */
+amxd_status_t _read_trx_window_param(amxd_object_t* object,
+                                     amxd_param_t* param,
+                                     amxd_action_t reason,
+                                     const amxc_var_t* const args,
+                                     amxc_var_t* const retval,
+                                     void* priv) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+
+    when_null_status(object, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    rv = amxd_action_param_read(object, param, reason, args, retval, priv);
+    when_failed(rv, exit);
+
+    when_true(amxd_object_template == amxd_object_get_type(object), exit);
+
+    if(!trx_cache_get_window_value(object, amxd_param_get_name(param), retval)) {
+        rv = amxd_status_unknown_error;
+    }
+
+exit:
+    return rv;
+}
+
+/**
+ * Called if a parameter of XPON.TransceiverCache is read.
+ *
+ * The parameters are volatile: the function returns the statistics of the
+ * snapshot cache for the Transceiver instances. See trx_cache.c.
+ */
+amxd_status_t _trx_cache_stats_on_read(UNUSED amxd_object_t* object,
+                                       amxd_param_t* param,
+                                       amxd_action_t reason,
+                                       UNUSED const amxc_var_t* const args,
+                                       amxc_var_t* const retval,
+                                       UNUSED void* priv) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+
+    when_false_status(reason == action_param_read, exit, rv = amxd_status_invalid_action);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    const char* const name = amxd_param_get_name(param);
+    when_null(name, exit);
+
+    if(strcmp(name, "Hits") == 0) {
+        amxc_var_set(uint64_t, retval, trx_cache_get_nr_of_hits());
+    } else if(strcmp(name, "Misses") == 0) {
+        amxc_var_set(uint64_t, retval, trx_cache_get_nr_of_misses());
+    } else {
+        SAH_TRACEZ_ERROR(ME, "Unknown param: %s", name);
+        goto exit;
+    }
+    rv = amxd_status_ok;
+
+exit:
+    return rv;
+}
+
+/**
+ * Called if a parameter of XPON.Diagnostics is read.
+ *
+ * The parameters are volatile: the function returns the statistics of the
+ * calls between the plugin and the vendor module. See call_stats.c.
+ */
+amxd_status_t _call_stats_on_read(UNUSED amxd_object_t* object,
+                                  amxd_param_t* param,
+                                  amxd_action_t reason,
+                                  UNUSED const amxc_var_t* const args,
+                                  amxc_var_t* const retval,
+                                  UNUSED void* priv) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+    amxc_string_t summary;
+    amxc_string_init(&summary, 0);
+
+    when_false_status(reason == action_param_read, exit, rv = amxd_status_invalid_action);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    const char* const name = amxd_param_get_name(param);
+    when_null(name, exit);
+
+    if(strcmp(name, "PonCtrl") == 0) {
+        call_stats_get_summary(call_stats_pon_ctrl, &summary);
+    } else if(strcmp(name, "PonStat") == 0) {
+        call_stats_get_summary(call_stats_pon_stat, &summary);
+    } else {
+        SAH_TRACEZ_ERROR(ME, "Unknown param: %s", name);
+        goto exit;
+    }
+    amxc_var_set(cstring_t, retval, amxc_string_get(&summary, 0));
+    rv = amxd_status_ok;
+
+exit:
+    amxc_string_clean(&summary);
+    return rv;
+}
+
+/**
+ * Implementation of XPON.Diagnostics.Reset().
+ */
+amxd_status_t _Reset(UNUSED amxd_object_t* object,
+                     UNUSED amxd_function_t* func,
+                     UNUSED amxc_var_t* args,
+                     UNUSED amxc_var_t* ret) {
+    call_stats_reset();
+    return amxd_status_ok;
+}
+
 /**
  * Called if a LastChange parameter is read.
  *
@@ -236,6 +496,9 @@ exit:
  * @param[in,out] retval: the function returns the value for the LastChange
  *                        parameter via this 'retval' parameter
  *
+ * The function uses the cached monotonic clock: it does not make a syscall
+ * per read.
+ *
  * @return amxd_status_ok (=0) upon success, another value in case of an error
  */
 amxd_status_t _lastchange_on_read(amxd_object_t* const object,
@@ -247,8 +510,7 @@ amxd_status_t _lastchange_on_read(amxd_object_t* const object,
     amxd_status_t rv = amxd_status_unknown_error;
     object_intf_priv_t* priv = NULL;
     uint32_t since_change = 0;
-    uint32_t uptime = 0;
-    char* path = NULL;
+    uint64_t now = 0;
 
     if(reason != action_param_read) {
         SAH_TRACEZ_WARNING(ME, "wrong reason, expected action_param_read(%d) got %d",
@@ -258,33 +520,77 @@ amxd_status_t _lastchange_on_read(amxd_object_t* const object,
     }
 
     when_null_trace(object, skip, ERROR, "object can not be NULL");
-    path = amxd_object_get_path(object, AMXD_OBJECT_INDEXED);
     /**
      * This function is called when the object with the LastChange parameter is
      * is being created. Then 'object->priv' is still NULL. Therefore do not log
      * an error if 'object->priv' is NULL.
      */
-    when_null_trace(object->priv, skip, DEBUG, "object %s has no private data", path);
+    when_null_trace(object->priv, skip, DEBUG, "object has no private data");
     priv = (object_intf_priv_t*) object->priv;
-    uptime = time_get_system_uptime();
-    when_true_trace(uptime < priv->last_change, skip, ERROR,
-                    "uptime is smaller than LastChange");
-    since_change = uptime - priv->last_change;
+    now = time_get_cached_monotonic_ms();
+    when_true_trace(now < priv->last_change, skip, ERROR,
+                    "monotonic time is smaller than LastChange");
+    since_change = (uint32_t) ((now - priv->last_change) / 1000);
     rv = amxd_status_ok;
 
 skip:
     when_failed_trace(amxc_var_set_uint32_t(retval, since_change),
                       exit, ERROR, "Failed to set parameter LastChange");
 exit:
-    if(path) {
-        free(path);
+    return rv;
+}
+
+/**
+ * Called if the StatusFlaps or StatusHistory parameter of an interface object
+ * is read.
+ *
+ * See object_intf_priv.c.
+ */
+amxd_status_t _status_history_on_read(amxd_object_t* const object,
+                                      amxd_param_t* const param,
+                                      amxd_action_t reason,
+                                      UNUSED const amxc_var_t* const args,
+                                      amxc_var_t* const retval,
+                                      UNUSED void* priv_unused) {
+
+    amxd_status_t rv = amxd_status_unknown_error;
+    amxc_string_t history;
+    amxc_string_init(&history, 0);
+
+    when_false_status(reason == action_param_read, exit, rv = amxd_status_invalid_action);
+    when_null_status(object, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(param, exit, rv = amxd_status_invalid_function_argument);
+    when_null_status(retval, exit, rv = amxd_status_invalid_function_argument);
+
+    const char* const name = amxd_param_get_name(param);
+    when_null(name, exit);
+
+    /* The object has no private data yet while it's being created */
+    const object_intf_priv_t* const priv = (const object_intf_priv_t*) object->priv;
+
+    if(strcmp(name, "StatusFlaps") == 0) {
+        amxc_var_set(uint32_t, retval, priv ? priv->nr_of_flaps : 0);
+    } else if(strcmp(name, "StatusHistory") == 0) {
+        if(priv) {
+            oipriv_status_history_to_string(priv, &history);
+        }
+        amxc_var_set(cstring_t, retval, amxc_string_get(&history, 0));
+    } else {
+        SAH_TRACEZ_ERROR(ME, "Unknown param: %s", name);
+        goto exit;
     }
+    rv = amxd_status_ok;
+
+exit:
+    amxc_string_clean(&history);
     return rv;
 }
 
 typedef enum _private_data_type {
     private_data_for_onu = 0,
-    private_data_for_object_interface
+    private_data_for_object_interface,
+    private_data_for_trx,
+    private_data_for_pull
 } private_data_type_t;
 
 
@@ -325,6 +631,12 @@ amxd_status_t object_destroyed_common(amxd_object_t* object,
     case private_data_for_object_interface:
         oipriv_delete_private_data((object_intf_priv_t*) object->priv);
         break;
+    case private_data_for_trx:
+        trx_cache_delete_snapshot((trx_snapshot_t*) object->priv);
+        break;
+    case private_data_for_pull:
+        dm_pull_delete_state((pull_state_t*) object->priv);
+        break;
     default:
         break;
     }
@@ -380,6 +692,55 @@ amxd_status_t _interface_object_destroyed(amxd_object_t* object,
                                    private_data_for_object_interface);
 }
 
+/**
+ * Called if an object which supports a pull update policy is destroyed.
+ *
+ * @param[in] object: the object being destroyed
+ * @param[in] reason: this must be 'action_object_destroy'
+ *
+ * The function deletes the pull state attached to the object, if any.
+ *
+ * @return amxd_status_ok (=0) upon success, another value in case of an error
+ */
+amxd_status_t _pulled_object_destroyed(amxd_object_t* object,
+                                       UNUSED amxd_param_t* param,
+                                       amxd_action_t reason,
+                                       UNUSED const amxc_var_t* const args,
+                                       UNUSED amxc_var_t* const retval,
+                                       UNUSED void* priv_unused) {
+
+    if((object != NULL) && (NULL == object->priv)) {
+        /* The object was never pulled with a cache time */
+        return amxd_status_ok;
+    }
+    return object_destroyed_common(object, reason, private_data_for_pull);
+}
+
+/**
+ * Called if a Transceiver instance is destroyed.
+ *
+ * @param[in] object: the object/instance being destroyed
+ * @param[in] reason: this must be 'action_object_destroy'
+ *
+ * The function deletes the snapshot of the volatile parameters attached to
+ * the instance, if any.
+ *
+ * @return amxd_status_ok (=0) upon success, another value in case of an error
+ */
+amxd_status_t _trx_destroyed(amxd_object_t* object,
+                             UNUSED amxd_param_t* param,
+                             amxd_action_t reason,
+                             UNUSED const amxc_var_t* const args,
+                             UNUSED amxc_var_t* const retval,
+                             UNUSED void* priv_unused) {
+
+    if((object != NULL) && (NULL == object->priv)) {
+        /* No parameter of the instance was read: nothing to delete */
+        return amxd_status_ok;
+    }
+    return object_destroyed_common(object, reason, private_data_for_trx);
+}
+
 
 /**
  * Called if Password parameter of an ANI instance is changed.
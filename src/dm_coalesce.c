@@ -0,0 +1,528 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file dm_coalesce.c
+ *
+ * Write-behind buffer for dm_object_changed() calls.
+ *
+ * A vendor module might update objects such as the PM counters of an ANI
+ * much more often than anyone reads them. The plugin can buffer those updates
+ * per object, instead of applying a transaction for each of them. Updates for
+ * the same object are merged: per param the last value wins. The plugin
+ * writes the merged updates of an object type to the DM when the interval
+ * configured for that object type expires.
+ *
+ * The interval is configured per object type with the config option
+ * 'coalesce_interval_ms' in tr181-xpon.odl. The key of each entry is the name
+ * of the object as in OBJECT_INFO (see dm_info.c), e.g. "TC.PM.PHY". Object
+ * types without an entry, or with 0 as interval, are not buffered.
+ *
+ * A param being read while it has a buffered value must show that value. If
+ * such a param has _read_coalesced_param() as read handler, the handler
+ * returns the buffered value and this part writes the buffered updates of
+ * that object type to the DM asap.
+ *
+ * Other paths write to the DM without passing via the buffer, e.g. a batch
+ * or dm_update_ani_pm(). A buffered value must not overwrite the newer value
+ * such a path wrote. Hence those paths call dm_coalesce_discard_params() for
+ * the params they write, and dm_coalesce_discard_subtree() for the instances
+ * they remove.
+ */
+
+/* Related header */
+#include "dm_coalesce.h"
+
+/* System headers */
+#include <string.h> /* strcmp(), strlen() */
+
+/* Other libraries' headers */
+#include <amxc/amxc_macros.h>
+#include <amxp/amxp_timer.h>
+
+/* Own headers */
+#include "data_model.h"   /* dm_change_object() */
+#include "dm_info.h"      /* dm_get_object_id() */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_parser() */
+#include "xpon_trace.h"
+
+#define COALESCE_CONFIG "coalesce_interval_ms"
+
+/**
+ * Buffer for one object type.
+ *
+ * - interval_ms: max time in ms an update stays in the buffer. 0 if updates
+ *     for this object type are not buffered.
+ * - timer: timer to write the buffered updates to the DM
+ * - pending: htable with the buffered updates. The key is the object path,
+ *     e.g. "XPON.ONU.1.ANI.1.TC.PM.PHY". The value has the same format as the
+ *     args of dm_change_object(), with the params of all updates merged.
+ * - n_updates: number of updates put in the buffer
+ * - n_writes: number of merged updates written to the DM
+ */
+typedef struct _coalesce_type {
+    uint32_t interval_ms;
+    amxp_timer_t* timer;
+    amxc_var_t pending;
+    uint64_t n_updates;
+    uint64_t n_writes;
+} coalesce_type_t;
+
+static coalesce_type_t s_types[obj_id_nbr];
+
+/* True if the buffer is enabled for at least one object type */
+static bool s_enabled = false;
+
+static void flush_type(coalesce_type_t* const type) {
+
+    amxc_var_t pending;
+    amxc_var_init(&pending);
+
+    amxp_timer_stop(type->timer);
+
+    /* dm_change_object() might trigger code adding updates to the buffer */
+    amxc_var_move(&pending, &type->pending);
+    amxc_var_set_type(&type->pending, AMXC_VAR_ID_HTABLE);
+
+    amxc_var_for_each(update, &pending) {
+        dm_change_object(update);
+        ++type->n_writes;
+    }
+    amxc_var_clean(&pending);
+}
+
+static void flush_timer_expired(UNUSED amxp_timer_t* timer, void* priv) {
+    flush_type((coalesce_type_t*) priv);
+}
+
+/**
+ * Get the key for an update in coalesce_type_t.pending.
+ *
+ * The key is the path of the object, without trailing dot.
+ */
+static void get_key(const char* path, uint32_t index, amxc_string_t* const key) {
+
+    size_t len = strlen(path);
+    if((len > 0) && (path[len - 1] == '.')) {
+        --len;
+    }
+    amxc_string_set(key, "");
+    amxc_string_append(key, path, len);
+    if(index != 0) {
+        amxc_string_appendf(key, ".%d", index);
+    }
+}
+
+/**
+ * Initialize the write-behind buffer.
+ *
+ * The function reads the interval per object type from the config section of
+ * the odl files.
+ *
+ * The plugin must call this function once at startup, after dm_info_init().
+ *
+ * @return true on success, else false
+ */
+bool dm_coalesce_init(void) {
+
+    bool rv = false;
+    uint32_t i;
+    object_id_t id;
+    const object_info_t* info;
+
+    for(i = 0; i < obj_id_nbr; ++i) {
+        amxc_var_init(&s_types[i].pending);
+        amxc_var_set_type(&s_types[i].pending, AMXC_VAR_ID_HTABLE);
+    }
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
+
+    const amxc_var_t* const config = GET_ARG(&parser->config, COALESCE_CONFIG);
+    if(!config) {
+        rv = true;
+        goto exit;
+    }
+
+    amxc_var_for_each(interval, config) {
+        for(id = 0; id < obj_id_nbr; ++id) {
+            info = dm_get_object_info(id);
+            if(info && (strcmp(info->name, amxc_var_key(interval)) == 0)) {
+                break;
+            }
+        }
+        if(obj_id_nbr == id) {
+            SAH_TRACEZ_ERROR(ME, "%s: unknown object: %s", COALESCE_CONFIG,
+                             amxc_var_key(interval));
+            continue;
+        }
+        s_types[id].interval_ms = amxc_var_dyncast(uint32_t, interval);
+        if(0 == s_types[id].interval_ms) {
+            continue;
+        }
+        if(amxp_timer_new(&s_types[id].timer, flush_timer_expired, &s_types[id])) {
+            SAH_TRACEZ_ERROR(ME, "Failed to create timer for %s", amxc_var_key(interval));
+            s_types[id].interval_ms = 0;
+            continue;
+        }
+        SAH_TRACEZ_INFO(ME, "Coalesce updates of %s during %d ms",
+                        amxc_var_key(interval), s_types[id].interval_ms);
+        s_enabled = true;
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Clean up the write-behind buffer.
+ *
+ * The function drops any buffered updates: the DM is going away.
+ *
+ * The plugin must call this function once when stopping.
+ */
+void dm_coalesce_cleanup(void) {
+    uint32_t i;
+    for(i = 0; i < obj_id_nbr; ++i) {
+        amxp_timer_delete(&s_types[i].timer);
+        amxc_var_clean(&s_types[i].pending);
+        s_types[i].interval_ms = 0;
+    }
+    s_enabled = false;
+}
+
+/**
+ * Put an update of an object in the buffer if it's enabled for that object.
+ *
+ * @param[in] args : same as for dm_change_object()
+ *
+ * If the buffer has an update for the same object, the function merges
+ * the params of @a args into that update.
+ *
+ * @return true if the function took over the update. Then the caller must not
+ *         pass it to dm_change_object(). Else false.
+ */
+bool dm_coalesce_change_object(const amxc_var_t* const args) {
+    if(NULL == args) {
+        return false;
+    }
+    return dm_coalesce_change_object_params(GET_CHAR(args, "path"),
+                                            GET_UINT32(args, "index"),
+                                            GET_ARG(args, "parameters"));
+}
+
+/**
+ * Put an update of an object in the buffer if it's enabled for that object.
+ *
+ * @param[in] path, index, params : same as for dm_change_object_params()
+ *
+ * Same as dm_coalesce_change_object(), but without the need to pass the
+ * arguments in an htable.
+ *
+ * @return true if the function took over the update. Then the caller must not
+ *         pass it to dm_change_object_params(). Else false.
+ */
+bool dm_coalesce_change_object_params(const char* const path, uint32_t index,
+                                      const amxc_var_t* const params) {
+
+    bool rv = false;
+    amxc_string_t key;
+    amxc_string_init(&key, 0);
+
+    when_false(s_enabled, exit);
+    when_null(path, exit);
+
+    const object_id_t id = dm_get_object_id(path);
+    when_true(obj_id_unknown == id, exit);
+
+    coalesce_type_t* const type = &s_types[id];
+    when_true(0 == type->interval_ms, exit);
+
+    when_false(amxc_var_type_of(params) == AMXC_VAR_ID_HTABLE, exit);
+
+    get_key(path, index, &key);
+    const char* const key_cstr = amxc_string_get(&key, 0);
+
+    amxc_var_t* update = GET_ARG(&type->pending, key_cstr);
+    if(!update) {
+        update = amxc_var_add_new_key(&type->pending, key_cstr);
+        when_null(update, exit);
+        amxc_var_set_type(update, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(cstring_t, update, "path", path);
+        if(index) {
+            amxc_var_add_key(uint32_t, update, "index", index);
+        }
+        amxc_var_t* const pending_params = amxc_var_add_new_key(update, "parameters");
+        amxc_var_copy(pending_params, params);
+    } else {
+        amxc_var_t* const pending_params = GET_ARG(update, "parameters");
+        amxc_var_for_each(value, params) {
+            amxc_var_set_key(pending_params, amxc_var_key(value), value,
+                             AMXC_VAR_FLAG_COPY | AMXC_VAR_FLAG_UPDATE);
+        }
+    }
+    ++type->n_updates;
+
+    const amxp_timer_state_t state = amxp_timer_get_state(type->timer);
+    if((state != amxp_timer_started) && (state != amxp_timer_running)) {
+        amxp_timer_start(type->timer, type->interval_ms);
+    }
+    rv = true;
+
+exit:
+    amxc_string_clean(&key);
+    return rv;
+}
+
+/**
+ * Get the buffered value of a param, if any.
+ *
+ * @param[in] path       object path, e.g. "XPON.ONU.1.ANI.1.TC.PM.PHY"
+ * @param[in] name       param name
+ * @param[in,out] value  the function copies the buffered value to this
+ *                       parameter if there is one
+ *
+ * If the object has buffered updates, the function also schedules writing the
+ * buffered updates of its object type to the DM asap.
+ *
+ * @return true if the param has a buffered value, else false
+ */
+bool dm_coalesce_get_pending_value(const char* const path, const char* const name,
+                                   amxc_var_t* const value) {
+
+    bool rv = false;
+    when_false(s_enabled, exit);
+    when_null(path, exit);
+    when_null(name, exit);
+
+    const object_id_t id = dm_get_object_id(path);
+    when_true(obj_id_unknown == id, exit);
+
+    coalesce_type_t* const type = &s_types[id];
+    const amxc_var_t* const update = GET_ARG(&type->pending, path);
+    when_null(update, exit);
+
+    /* Start timer with 0 ms: the reader might read more params of this object */
+    amxp_timer_start(type->timer, 0);
+
+    const amxc_var_t* const pending_params = GET_ARG(update, "parameters");
+    const amxc_var_t* const pending_value = GET_ARG(pending_params, name);
+    when_null(pending_value, exit);
+
+    rv = (amxc_var_copy(value, pending_value) == 0);
+
+exit:
+    return rv;
+}
+
+/**
+ * Return true if the buffer has updates for objects of type @a id.
+ */
+bool dm_coalesce_has_pending(object_id_t id) {
+    if(!s_enabled || (id >= obj_id_nbr)) {
+        return false;
+    }
+    const amxc_htable_t* const pending = amxc_var_constcast(amxc_htable_t, &s_types[id].pending);
+    return (pending != NULL) && !amxc_htable_is_empty(pending);
+}
+
+/**
+ * Discard the buffered values of params written to the DM via another path.
+ *
+ * @param[in] path, index  same as for dm_change_object_params()
+ * @param[in] params       htable with the params written. The function
+ *                         discards the buffered values of these params. NULL
+ *                         to discard all buffered values of the object.
+ *
+ * The buffered values of other params of the object remain buffered.
+ */
+void dm_coalesce_discard_params(const char* const path, uint32_t index,
+                                const amxc_var_t* const params) {
+
+    amxc_string_t key;
+    amxc_string_init(&key, 0);
+
+    when_null(path, exit);
+    const object_id_t id = dm_get_object_id(path);
+    when_false(dm_coalesce_has_pending(id), exit);
+
+    get_key(path, index, &key);
+    amxc_var_t* update = GET_ARG(&s_types[id].pending, amxc_string_get(&key, 0));
+    when_null(update, exit);
+
+    if(amxc_var_type_of(params) == AMXC_VAR_ID_HTABLE) {
+        amxc_var_t* const pending_params = GET_ARG(update, "parameters");
+        amxc_var_for_each(value, params) {
+            amxc_var_t* pending_value = GET_ARG(pending_params, amxc_var_key(value));
+            amxc_var_delete(&pending_value);
+        }
+        const amxc_htable_t* const left = amxc_var_constcast(amxc_htable_t, pending_params);
+        when_false((NULL == left) || amxc_htable_is_empty(left), exit);
+    }
+    SAH_TRACEZ_DEBUG(ME, "Discard buffered update of %s", amxc_string_get(&key, 0));
+    amxc_var_delete(&update);
+
+exit:
+    amxc_string_clean(&key);
+}
+
+/**
+ * Discard the buffered updates of an instance and of all its descendants.
+ *
+ * @param[in] path, index  same as for dm_remove_instance_at(). If @a index is
+ *                         0, @a path is the object whose subtree is discarded.
+ *
+ * tr181-xpon calls this function when it removes instances from the DM.
+ */
+void dm_coalesce_discard_subtree(const char* const path, uint32_t index) {
+
+    uint32_t i;
+    amxc_string_t prefix;
+    amxc_string_init(&prefix, 0);
+
+    when_false(s_enabled, exit);
+    when_null(path, exit);
+
+    get_key(path, index, &prefix);
+    const char* const prefix_cstr = amxc_string_get(&prefix, 0);
+    const size_t len = amxc_string_text_length(&prefix);
+
+    for(i = 0; i < obj_id_nbr; ++i) {
+        if(!dm_coalesce_has_pending((object_id_t) i)) {
+            continue;
+        }
+        amxc_var_for_each(update, &s_types[i].pending) {
+            const char* const key = amxc_var_key(update);
+            if((strncmp(key, prefix_cstr, len) == 0) &&
+               ((key[len] == '\0') || (key[len] == '.'))) {
+                SAH_TRACEZ_DEBUG(ME, "Discard buffered update of %s", key);
+                amxc_var_delete(&update);
+            }
+        }
+    }
+
+exit:
+    amxc_string_clean(&prefix);
+}
+
+/**
+ * Write all buffered updates to the DM.
+ *
+ * The plugin calls this function when stopping, before it saves the DM
+ * snapshot.
+ */
+void dm_coalesce_flush_all(void) {
+    uint32_t i;
+    when_false(s_enabled, exit);
+    for(i = 0; i < obj_id_nbr; ++i) {
+        if(s_types[i].interval_ms != 0) {
+            flush_type(&s_types[i]);
+        }
+    }
+exit:
+    return;
+}
+
+uint64_t dm_coalesce_get_nr_of_updates(void) {
+    uint64_t n = 0;
+    uint32_t i;
+    for(i = 0; i < obj_id_nbr; ++i) {
+        n += s_types[i].n_updates;
+    }
+    return n;
+}
+
+uint64_t dm_coalesce_get_nr_of_writes(void) {
+    uint64_t n = 0;
+    uint32_t i;
+    for(i = 0; i < obj_id_nbr; ++i) {
+        n += s_types[i].n_writes;
+    }
+    return n;
+}
+
+/**
+ * Get the merge ratio of each object type for which the buffer is enabled.
+ *
+ * @param[in,out] ratios  the function returns a comma-separated list of
+ *     "<name>=<ratio>" via this parameter, e.g. "TC.PM.PHY=10.00". The ratio
+ *     is the number of updates received divided by the number of updates
+ *     written to the DM.
+ */
+void dm_coalesce_get_merge_ratios(amxc_string_t* const ratios) {
+
+    uint32_t i;
+    const object_info_t* info;
+
+    amxc_string_set(ratios, "");
+    for(i = 0; i < obj_id_nbr; ++i) {
+        if(0 == s_types[i].interval_ms) {
+            continue;
+        }
+        info = dm_get_object_info((object_id_t) i);
+        amxc_string_appendf(ratios, "%s%s=%.2f",
+                            amxc_string_is_empty(ratios) ? "" : ",", info->name,
+                            (0 == s_types[i].n_writes) ? 0.0 :
+                            (double) s_types[i].n_updates / (double) s_types[i].n_writes);
+    }
+}
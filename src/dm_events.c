@@ -86,6 +86,8 @@
 #include "persistency.h"      /* persistency_enable() */
 #include "pon_ctrl.h"         /* pon_ctrl_set_enable() */
 #include "restore_to_hal.h"   /* rth_disable() */
+#include "trx_alarm.h"        /* trx_alarm_thresholds_changed() */
+#include "trx_cache.h"        /* trx_cache_thresholds_changed() */
 #include "xpon_trace.h"
 
 static int isdot(int c) {
@@ -202,6 +204,20 @@ void _status_changed(UNUSED const char* const event_name,
     oipriv_update_last_change(event_data);
 }
 
+/**
+ * A parameter of XPON.TransceiverThresholds or of one of its child objects
+ * changed value.
+ *
+ * The function makes the module which evaluates the thresholds read them
+ * again, and starts or stops the sampler which evaluates them periodically.
+ */
+void _trx_thresholds_changed(UNUSED const char* const event_name,
+                             UNUSED const amxc_var_t* const event_data,
+                             UNUSED void* const priv) {
+    trx_alarm_thresholds_changed();
+    trx_cache_thresholds_changed();
+}
+
 /**
  * The Password parameter of an ANI instance changed value.
  *
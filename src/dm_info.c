@@ -64,11 +64,15 @@
 #include "dm_info.h"
 
 /* System headers */
-#include <string.h> /* strncmp() */
+#include <stdlib.h> /* strtoul() */
+#include <string.h> /* memcpy(), memset(), strchr(), strcmp(), strlen(), strncmp() */
 
 /* Other libraries' headers */
 #include <amxc/amxc.h>
 #include <amxc/amxc_macros.h>
+#include <amxd/amxd_dm.h>        /* amxd_dm_get_root() */
+#include <amxd/amxd_object.h>    /* amxd_object_get_child() */
+#include <amxd/amxd_parameter.h> /* amxd_param_get_type() */
 
 /* Own headers */
 #include "xpon_trace.h"
@@ -163,6 +167,41 @@ static const param_info_t TC_ALARMS_PARAMS[] = {
     { .name = "ROGUE", .type = AMXC_VAR_ID_BOOL }
 };
 
+static const param_info_t TC_PM_PHY_PARAMS[] = {
+    { .name = "CorrectedFECBytes", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "CorrectedFECCodewords", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "UncorrectableFECCodewords", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "TotalFECCodewords", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "PSBdHECErrorCount", .type = AMXC_VAR_ID_UINT32 },
+    { .name = "HeaderHECErrorCount", .type = AMXC_VAR_ID_UINT32 },
+    { .name = "UnknownProfile", .type = AMXC_VAR_ID_UINT32 }
+};
+
+static const param_info_t TC_PM_GEM_PARAMS[] = {
+    { .name = "FramesSent", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "FramesReceived", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "FrameHeaderHECErrors", .type = AMXC_VAR_ID_UINT32 },
+    { .name = "KeyErrors", .type = AMXC_VAR_ID_UINT32 }
+};
+
+static const param_info_t TC_PM_PLOAM_PARAMS[] = {
+    { .name = "MICErrors", .type = AMXC_VAR_ID_UINT32 },
+    { .name = "DownstreamMessageCount", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "RangingTime", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "UpstreamMessageCount", .type = AMXC_VAR_ID_UINT64 }
+};
+
+static const param_info_t TC_PM_OMCI_PARAMS[] = {
+    { .name = "BaselineMessagesReceived", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "ExtendedMessagesReceived", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "MICErrors", .type = AMXC_VAR_ID_UINT32 }
+};
+
+static const param_info_t GEM_PORT_PM_PARAMS[] = {
+    { .name = "FramesSent", .type = AMXC_VAR_ID_UINT64 },
+    { .name = "FramesReceived", .type = AMXC_VAR_ID_UINT64 }
+};
+
 /**
  * Array with info about objects in the XPON DM.
  *
@@ -178,7 +217,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = "SoftwareImage,EthernetUNI,ANI",
         .params = ONU_PARAMS,
         .n_params = ARRAY_SIZE(ONU_PARAMS),
-        .has_rw_enable = true
+        .has_rw_enable = true,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_software_image,
@@ -190,7 +231,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = SOFTWARE_IMAGE_PARAMS,
         .n_params = ARRAY_SIZE(SOFTWARE_IMAGE_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ethernet_uni,
@@ -201,7 +244,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = ETHERNET_UNI_PARAMS,
         .n_params = ARRAY_SIZE(ETHERNET_UNI_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ani,
@@ -212,7 +257,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = "TC.GEM.Port,Transceiver",
         .params = ANI_PARAMS,
         .n_params = ARRAY_SIZE(ANI_PARAMS),
-        .has_rw_enable = true
+        .has_rw_enable = true,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_gem_port,
@@ -224,7 +271,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = GEM_PORT_PARAMS,
         .n_params = ARRAY_SIZE(GEM_PORT_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_transceiver,
@@ -236,7 +285,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = TRANSCEIVER_PARAMS,
         .n_params = ARRAY_SIZE(TRANSCEIVER_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ani_tc_onu_activation,
@@ -247,7 +298,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = ONU_ACTIVATION_PARAMS,
         .n_params = ARRAY_SIZE(ONU_ACTIVATION_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ani_tc_authentication,
@@ -258,7 +311,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = AUTHENTICATION_PARAMS,
         .n_params = ARRAY_SIZE(AUTHENTICATION_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ani_tc_performance_thresholds,
@@ -269,7 +324,9 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = PERFORMANCE_THRESHOLDS_PARAMS,
         .n_params = ARRAY_SIZE(PERFORMANCE_THRESHOLDS_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
     },
     {
         .id = obj_id_ani_tc_alarms,
@@ -280,15 +337,319 @@ const object_info_t OBJECT_INFO[obj_id_nbr] = {
         .templates = NULL,
         .params = TC_ALARMS_PARAMS,
         .n_params = ARRAY_SIZE(TC_ALARMS_PARAMS),
-        .has_rw_enable = false
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = false
+    },
+    {
+        .id = obj_id_ani_tc_pm_phy,
+        .name = "TC.PM.PHY",
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.PHY",
+        .key_name = NULL,
+        .singletons = NULL,
+        .templates = NULL,
+        .params = TC_PM_PHY_PARAMS,
+        .n_params = ARRAY_SIZE(TC_PM_PHY_PARAMS),
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = true
+    },
+    {
+        .id = obj_id_ani_tc_pm_gem,
+        .name = "TC.PM.GEM",
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.GEM",
+        .key_name = NULL,
+        .singletons = NULL,
+        .templates = NULL,
+        .params = TC_PM_GEM_PARAMS,
+        .n_params = ARRAY_SIZE(TC_PM_GEM_PARAMS),
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = true
+    },
+    {
+        .id = obj_id_ani_tc_pm_ploam,
+        .name = "TC.PM.PLOAM",
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.PLOAM",
+        .key_name = NULL,
+        .singletons = NULL,
+        .templates = NULL,
+        .params = TC_PM_PLOAM_PARAMS,
+        .n_params = ARRAY_SIZE(TC_PM_PLOAM_PARAMS),
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = true
+    },
+    {
+        .id = obj_id_ani_tc_pm_omci,
+        .name = "TC.PM.OMCI",
+        .generic_path = "XPON.ONU.x.ANI.x.TC.PM.OMCI",
+        .key_name = NULL,
+        .singletons = NULL,
+        .templates = NULL,
+        .params = TC_PM_OMCI_PARAMS,
+        .n_params = ARRAY_SIZE(TC_PM_OMCI_PARAMS),
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = true
+    },
+    {
+        .id = obj_id_gem_port_pm,
+        .name = "GEMPort.PM",
+        .generic_path = "XPON.ONU.x.ANI.x.TC.GEM.Port.x.PM",
+        .key_name = NULL,
+        .singletons = NULL,
+        .templates = NULL,
+        .params = GEM_PORT_PM_PARAMS,
+        .n_params = ARRAY_SIZE(GEM_PORT_PM_PARAMS),
+        .has_rw_enable = false,
+        .update_policy = update_policy_push,
+        .pull_supported = true
     }
 };
 
 
+/**
+ * Max number of nodes in the trie used to classify paths. The trie has one
+ * node per unique prefix of the generic paths in OBJECT_INFO, and a root node.
+ */
+#define MAX_TRIE_NODES 32
+
+/**
+ * Value of trie_node_t.first_child or trie_node_t.next_sibling if the node has
+ * no child or sibling.
+ */
+#define TRIE_NO_NODE UINT8_MAX
+
+/**
+ * Node in the trie dm_classify_path() uses to find the ID of a path.
+ *
+ * - segment: part of a generic path between 2 dots, e.g., "ANI" or "x". It
+ *     points into OBJECT_INFO[].generic_path, hence it's not 0-terminated.
+ * - segment_len: length of 'segment'
+ * - first_child: index of the 1st child in s_trie, or TRIE_NO_NODE
+ * - next_sibling: index of the next sibling in s_trie, or TRIE_NO_NODE
+ * - id: ID of the object whose generic path ends at this node, or
+ *     obj_id_unknown if no generic path ends at this node
+ */
+typedef struct _trie_node {
+    const char* segment;
+    uint8_t segment_len;
+    uint8_t first_child;
+    uint8_t next_sibling;
+    object_id_t id;
+} trie_node_t;
+
+/**
+ * Trie built from OBJECT_INFO by dm_info_init(). The element at index 0 is the
+ * root node. It has an empty segment.
+ */
+static trie_node_t s_trie[MAX_TRIE_NODES];
+static uint32_t s_trie_size = 0;
+
+static uint8_t trie_find_child(uint8_t node, const char* segment, size_t len) {
+
+    uint8_t child = s_trie[node].first_child;
+    while(child != TRIE_NO_NODE) {
+        if((s_trie[child].segment_len == len) &&
+           (strncmp(s_trie[child].segment, segment, len) == 0)) {
+            break;
+        }
+        child = s_trie[child].next_sibling;
+    }
+    return child;
+}
+
+static uint8_t trie_add_node(const char* segment, size_t len) {
+
+    if((s_trie_size >= MAX_TRIE_NODES) || (len > UINT8_MAX)) {
+        return TRIE_NO_NODE;
+    }
+    const uint8_t node = (uint8_t) s_trie_size++;
+    s_trie[node].segment = segment;
+    s_trie[node].segment_len = (uint8_t) len;
+    s_trie[node].first_child = TRIE_NO_NODE;
+    s_trie[node].next_sibling = TRIE_NO_NODE;
+    s_trie[node].id = obj_id_unknown;
+    return node;
+}
+
+/**
+ * Add the generic path of an object to the trie.
+ *
+ * @return true on success, else false
+ */
+static bool trie_insert(const object_info_t* const info) {
+
+    const char* segment = info->generic_path;
+    const char* end;
+    size_t len;
+    uint8_t node = 0;
+    uint8_t child;
+
+    while(true) {
+        end = strchr(segment, '.');
+        len = end ? (size_t) (end - segment) : strlen(segment);
+        child = trie_find_child(node, segment, len);
+        if(TRIE_NO_NODE == child) {
+            child = trie_add_node(segment, len);
+            when_true_trace(TRIE_NO_NODE == child, error, ERROR,
+                            "Failed to add '%s' to trie", info->generic_path);
+            s_trie[child].next_sibling = s_trie[node].first_child;
+            s_trie[node].first_child = child;
+        }
+        node = child;
+        if(!end) {
+            break;
+        }
+        segment = end + 1;
+    }
+    s_trie[node].id = info->id;
+    return true;
+
+error:
+    return false;
+}
+
+static bool trie_build(void) {
+
+    uint32_t i;
+    s_trie_size = 0;
+    trie_add_node("", 0);
+    for(i = 0; i < obj_id_nbr; ++i) {
+        if(!trie_insert(&OBJECT_INFO[i])) {
+            s_trie_size = 0;
+            return false;
+        }
+    }
+    SAH_TRACEZ_DEBUG(ME, "Built trie with %d nodes", s_trie_size);
+    return true;
+}
+
+/**
+ * Max number of params per object in OBJECT_INFO.
+ */
+#define MAX_PARAMS_PER_OBJECT 32
+
+/**
+ * Max number of slots in the hash table of an object, and max number of seeds
+ * build_param_hash() tries per table size.
+ */
+#define PARAM_HASH_MAX_SIZE 256
+#define PARAM_HASH_MAX_SEEDS 256
+
+/**
+ * Perfect hash table to look up a param of an object by name.
+ *
+ * - params: copy of the params in OBJECT_INFO[].params. Their types are
+ *     replaced by the types in the ODL files by dm_info_sync_param_types().
+ * - n_params: number of elements in 'params'
+ * - slots: index + 1 in 'params' of the param whose name hashes to this slot,
+ *     or 0 if no param hashes to this slot
+ * - seed: seed for param_hash() for which the names of all params hash to a
+ *     different slot
+ * - mask: number of slots in use minus 1. The number of slots in use is a
+ *     power of 2.
+ */
+typedef struct _param_hash {
+    param_info_t params[MAX_PARAMS_PER_OBJECT];
+    uint32_t n_params;
+    uint8_t slots[PARAM_HASH_MAX_SIZE];
+    uint32_t seed;
+    uint32_t mask;
+} param_hash_t;
+
+static param_hash_t s_param_hash[obj_id_nbr];
+
+/* FNV-1a, with the seed mixed into the offset basis */
+static uint32_t param_hash(const char* name, uint32_t seed) {
+    uint32_t hash = 2166136261U ^ seed;
+    while(*name != '\0') {
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static bool try_param_hash(param_hash_t* const table, uint32_t size, uint32_t seed) {
+
+    uint32_t i;
+    uint32_t slot;
+
+    memset(table->slots, 0, sizeof(table->slots));
+    for(i = 0; i < table->n_params; ++i) {
+        slot = param_hash(table->params[i].name, seed) & (size - 1);
+        if(table->slots[slot] != 0) {
+            return false;
+        }
+        table->slots[slot] = (uint8_t) (i + 1);
+    }
+    table->seed = seed;
+    table->mask = size - 1;
+    return true;
+}
+
+/**
+ * Build the perfect hash table for the params of an object.
+ *
+ * The function looks for the smallest table size, being a power of 2 and at
+ * least twice the number of params, and a seed for which all param names hash
+ * to a different slot.
+ *
+ * @return true on success, else false
+ */
+static bool build_param_hash(const object_info_t* const info) {
+
+    param_hash_t* const table = &s_param_hash[info->id];
+    uint32_t size = 4;
+    uint32_t seed;
+
+    when_true_trace(info->n_params > MAX_PARAMS_PER_OBJECT, error, ERROR,
+                    "%s: too many params: %d > %d", info->name, info->n_params,
+                    MAX_PARAMS_PER_OBJECT);
+
+    memcpy(table->params, info->params, info->n_params * sizeof(param_info_t));
+    table->n_params = info->n_params;
+
+    while(size < (2 * info->n_params)) {
+        size *= 2;
+    }
+    for(; size <= PARAM_HASH_MAX_SIZE; size *= 2) {
+        for(seed = 0; seed < PARAM_HASH_MAX_SEEDS; ++seed) {
+            if(try_param_hash(table, size, seed)) {
+                SAH_TRACEZ_DEBUG(ME, "%s: %d params in %d slots (seed=%d)",
+                                 info->name, info->n_params, size, seed);
+                return true;
+            }
+        }
+    }
+    SAH_TRACEZ_ERROR(ME, "%s: failed to build param hash table", info->name);
+
+error:
+    return false;
+}
+
+/**
+ * Update policy per object in use: the default in OBJECT_INFO, possibly
+ * overridden by the config option 'update_policy'.
+ *
+ * - policy: update policy
+ * - cache_ms: only applicable for update_policy_pull_cached: time in ms the
+ *     plugin serves reads from the DM after pulling the object
+ */
+typedef struct _object_update_policy {
+    update_policy_t policy;
+    uint32_t cache_ms;
+} object_update_policy_t;
+
+static object_update_policy_t s_update_policy[obj_id_nbr];
+
 /**
  * Initialize the dm_info part.
  *
- * The function only runs a sanity check on the OBJECT_INFO array.
+ * The function runs a sanity check on the OBJECT_INFO array, and builds the
+ * trie dm_get_object_id() and dm_classify_path() use, and the hash tables
+ * dm_get_param_info() uses.
  *
  * The plugin must call this function once at startup.
  *
@@ -302,111 +663,347 @@ bool dm_info_init(void) {
                              i, OBJECT_INFO[i].id, i);
             return false;
         }
+        s_update_policy[i].policy = OBJECT_INFO[i].update_policy;
+        s_update_policy[i].cache_ms = 0;
+        if(!build_param_hash(&OBJECT_INFO[i])) {
+            return false;
+        }
     }
-    return true;
+    return trie_build();
 }
 
 /**
- * Convert an actual path to a generic path.
+ * Find the definition of an object in the DM based on its generic path.
  *
- * @param[in] path  actual path with real instance indexes, e.g.,
- *                  "XPON.ONU.1.ANI.1.Transceiver"
- * @param[in,out] generic_path  the function returns the generic version of
- *     @a path. The generic version of a path is the path with all instance
- *     indexes replaced by 'x', e.g., "XPON.ONU.x.ANI.x.Transceiver".
+ * @return the object (a template object if the generic path ends with the
+ *         name of a template) on success, else NULL
+ */
+static amxd_object_t* find_object_def(amxd_dm_t* const dm, const char* generic_path) {
+
+    amxd_object_t* object = amxd_dm_get_root(dm);
+    const char* segment = generic_path;
+    const char* end;
+    size_t len;
+    char name[64];
+
+    while(object && segment) {
+        end = strchr(segment, '.');
+        len = end ? (size_t) (end - segment) : strlen(segment);
+        /* A template object has the definitions of its instances' children */
+        if((len != 1) || (segment[0] != 'x')) {
+            when_true(len >= sizeof(name), error);
+            memcpy(name, segment, len);
+            name[len] = '\0';
+            object = amxd_object_get_child(object, name);
+        }
+        segment = end ? end + 1 : NULL;
+    }
+    return object;
+
+error:
+    return NULL;
+}
+
+/**
+ * Take over the types of the params from the ODL files.
+ *
+ * The *_PARAMS arrays in this file also list the type of each param. The
+ * function compares those types with the ones in the DM as defined by the ODL
+ * files. If they differ, it logs a warning and uses the type from the ODL
+ * files, so the type checks on values passed by the vendor module can't drift
+ * from the DM definition.
+ *
+ * The plugin must call this function once at startup, after dm_info_init()
+ * and after the ODL files are loaded.
+ *
+ * @param[in] dm  the data model
  *
  * @return true on success, else false
  */
-static bool dm_convert_to_generic_path(const char* path, amxc_string_t* generic_path) {
+bool dm_info_sync_param_types(amxd_dm_t* const dm) {
 
     bool rv = false;
-    when_null(path, exit_no_cleanup);
-    when_null(generic_path, exit_no_cleanup);
-
-    amxc_llist_t list;
-    amxc_llist_init(&list);
+    uint32_t i;
+    uint32_t j;
+    uint32_t type;
+    param_info_t* param;
+    amxd_object_t* object;
+    const amxd_param_t* def;
 
-    amxc_string_t input;
-    amxc_string_init(&input, 0);
-    amxc_string_set(&input, path);
+    when_null(dm, exit);
 
-    if(AMXC_STRING_SPLIT_OK != amxc_string_split_to_llist(&input, &list, '.')) {
-        SAH_TRACEZ_ERROR(ME, "Failed to split '%s'", path);
-        goto exit;
+    for(i = 0; i < obj_id_nbr; ++i) {
+        object = find_object_def(dm, OBJECT_INFO[i].generic_path);
+        if(!object) {
+            SAH_TRACEZ_ERROR(ME, "%s: not found in DM", OBJECT_INFO[i].generic_path);
+            continue;
+        }
+        for(j = 0; j < s_param_hash[i].n_params; ++j) {
+            param = &s_param_hash[i].params[j];
+            def = amxd_object_get_param_def(object, param->name);
+            if(!def) {
+                SAH_TRACEZ_ERROR(ME, "%s.%s: not found in DM",
+                                 OBJECT_INFO[i].generic_path, param->name);
+                continue;
+            }
+            type = amxd_param_get_type(def);
+            if(type != param->type) {
+                SAH_TRACEZ_WARNING(ME, "%s.%s: type=%d in DM != %d: use %d",
+                                   OBJECT_INFO[i].generic_path, param->name,
+                                   type, param->type, type);
+                param->type = type;
+            }
+        }
     }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Parse an update policy from the config.
+ *
+ * @param[in] value: "push", "pull" or "pull:<ms>", e.g. "pull:1000"
+ * @param[in,out] policy: the function returns the parsed policy via this
+ *                        parameter
+ *
+ * @return true on success, else false
+ */
+static bool parse_update_policy(const char* value, object_update_policy_t* const policy) {
 
-    /* Remove the last elem from 'list' if it's numeric */
-    amxc_llist_it_t* last_it = amxc_llist_get_last(&list);
-    when_null(last_it, exit);
-    amxc_string_t* const last_elem = amxc_string_from_llist_it(last_it);
-    if(amxc_string_is_numeric(last_elem)) {
-        amxc_llist_take_last(&list);
-        amxc_string_list_it_free(last_it);
+    char* end = NULL;
+
+    if(NULL == value) {
+        return false;
+    }
+    if(strcmp(value, "push") == 0) {
+        policy->policy = update_policy_push;
+        policy->cache_ms = 0;
+        return true;
+    }
+    if(strcmp(value, "pull") == 0) {
+        policy->policy = update_policy_pull;
+        policy->cache_ms = 0;
+        return true;
+    }
+    if((strncmp(value, "pull:", 5) != 0) || (value[5] < '0') || (value[5] > '9')) {
+        return false;
     }
+    const unsigned long cache_ms = strtoul(value + 5, &end, 10);
+    if((*end != '\0') || (cache_ms > UINT32_MAX)) {
+        return false;
+    }
+    policy->policy = (0 == cache_ms) ? update_policy_pull : update_policy_pull_cached;
+    policy->cache_ms = (uint32_t) cache_ms;
+    return true;
+}
 
-    amxc_llist_iterate(it, &list) {
-        amxc_string_t* part = amxc_string_from_llist_it(it);
-        if(amxc_string_is_numeric(part)) {
-            amxc_string_set(part, "x");
+/**
+ * Set the update policy per object from the config.
+ *
+ * @param[in] config: value of the config option 'update_policy': htable with
+ *                    per object name as in OBJECT_INFO a string: "push",
+ *                    "pull" or "pull:<ms>". NULL if the option is not set.
+ *
+ * Objects not in @a config keep their default policy from OBJECT_INFO. The
+ * function ignores a pull policy for an object which does not support it.
+ *
+ * The plugin must call this function once at startup, after dm_info_init().
+ *
+ * @return true on success, false if @a config has an invalid entry
+ */
+bool dm_info_set_update_policies(const amxc_var_t* const config) {
+
+    bool rv = true;
+    object_id_t id;
+    object_update_policy_t policy;
+
+    when_null(config, exit);
+
+    amxc_var_for_each(value, config) {
+        const char* const name = amxc_var_key(value);
+        for(id = 0; id < obj_id_nbr; ++id) {
+            if(strcmp(OBJECT_INFO[id].name, name) == 0) {
+                break;
+            }
+        }
+        if(obj_id_nbr == id) {
+            SAH_TRACEZ_ERROR(ME, "update_policy: unknown object: %s", name);
+            rv = false;
+            continue;
+        }
+        if(!parse_update_policy(amxc_var_constcast(cstring_t, value), &policy)) {
+            SAH_TRACEZ_ERROR(ME, "update_policy: %s: invalid policy", name);
+            rv = false;
+            continue;
         }
+        if((policy.policy != update_policy_push) && !OBJECT_INFO[id].pull_supported) {
+            SAH_TRACEZ_ERROR(ME, "update_policy: %s does not support pull", name);
+            rv = false;
+            continue;
+        }
+        SAH_TRACEZ_INFO(ME, "update_policy: %s: policy=%d cache_ms=%d", name,
+                        policy.policy, policy.cache_ms);
+        s_update_policy[id] = policy;
     }
 
-    if(amxc_string_join_llist(generic_path, &list, '.') != 0) {
-        SAH_TRACEZ_ERROR(ME, "Failed to generate generic path from '%s'", path);
-        goto exit;
+exit:
+    return rv;
+}
+
+/**
+ * Return the update policy of an object.
+ *
+ * @param[in] id: object ID
+ * @param[in,out] cache_ms: if not NULL, the function returns the cache time
+ *                          in ms for update_policy_pull_cached via this
+ *                          parameter
+ *
+ * @return the update policy of the object
+ */
+update_policy_t dm_get_update_policy(object_id_t id, uint32_t* cache_ms) {
+
+    if(id >= obj_id_nbr) {
+        return update_policy_push;
     }
-    rv = true;
+    if(cache_ms) {
+        *cache_ms = s_update_policy[id].cache_ms;
+    }
+    return s_update_policy[id].policy;
+}
 
-exit:
-    amxc_llist_clean(&list, amxc_string_list_it_free);
-    amxc_string_clean(&input);
+/**
+ * Parse a path segment consisting of decimal digits only.
+ *
+ * @return true if the segment is numeric and fits in an uint32, else false
+ */
+static bool parse_index(const char* segment, size_t len, uint32_t* index) {
 
-exit_no_cleanup:
-    return rv;
+    uint64_t value = 0;
+    size_t i;
+
+    if((0 == len) || (len > 10)) {
+        return false;
+    }
+    for(i = 0; i < len; ++i) {
+        if((segment[i] < '0') || (segment[i] > '9')) {
+            return false;
+        }
+        value = (value * 10) + (uint64_t) (segment[i] - '0');
+    }
+    if(value > UINT32_MAX) {
+        return false;
+    }
+    *index = (uint32_t) value;
+    return true;
 }
 
+static void store_index(object_id_t id, uint32_t index, dm_object_indexes_t* indexes) {
+
+    if(!indexes) {
+        return;
+    }
+    switch(id) {
+    case obj_id_onu:
+        indexes->onu = index;
+        break;
+    case obj_id_ani:
+        indexes->ani = index;
+        break;
+    case obj_id_gem_port:
+        indexes->gem_port = index;
+        break;
+    default:
+        break;
+    }
+}
 
 /**
- * Return the ID of an object.
+ * Return the ID of an object, and the instance indexes in its path.
  *
- * @param[in] path  object path, e.g., "XPON.ONU.1.SoftwareImage".
+ * @param[in] path      object path, e.g., "XPON.ONU.1.ANI.2.TC.GEM.Port.3".
+ *                      If the last part of the path is an instance index, the
+ *                      function ignores it to find the ID. It does return the
+ *                      index via @a indexes.
+ * @param[in,out] indexes  if not NULL, the function returns the instance
+ *                      indexes it finds in @a path via this parameter. It sets
+ *                      each index not present in @a path to 0.
  *
- * Example: if @a path is "XPON.ONU.1.SoftwareImage", the function returns
- *          obj_id_software_image
+ * Example: if @a path is "XPON.ONU.1.ANI.2.TC.GEM.Port.3", the function
+ *          returns obj_id_gem_port, and it sets indexes to { .onu = 1,
+ *          .ani = 2, .gem_port = 3 }.
+ *
+ * The function walks over @a path once, and it does not allocate memory.
  *
  * @return one of the value of object_id_t smaller than obj_id_nbr upon
  *         success, else obj_id_unknown
  */
-object_id_t dm_get_object_id(const char* path) {
+object_id_t dm_classify_path(const char* path, dm_object_indexes_t* indexes) {
 
     object_id_t id = obj_id_unknown;
+    const char* segment = path;
+    const char* end;
+    size_t len;
+    uint32_t index;
+    uint8_t node = 0;
+    uint8_t child;
 
-    amxc_string_t generic_path_str;
-    amxc_string_init(&generic_path_str, 0);
-
-    if(!dm_convert_to_generic_path(path, &generic_path_str)) {
-        goto exit;
+    if(indexes) {
+        indexes->onu = 0;
+        indexes->ani = 0;
+        indexes->gem_port = 0;
     }
+    when_null(path, exit);
+    when_true_trace(0 == s_trie_size, exit, ERROR, "dm_info_init() not called");
 
-    const char* const generic_path = amxc_string_get(&generic_path_str, 0);
-    const size_t generic_path_len = strlen(generic_path);
+    while(*segment != '\0') {
+        end = segment;
+        while((*end != '.') && (*end != '\0')) {
+            ++end;
+        }
+        len = (size_t) (end - segment);
+        /* The segment is the last one if the path ends after it, optionally
+         * with a trailing dot. */
+        const bool last = (*end == '\0') || (*(end + 1) == '\0');
 
-    uint32_t i;
-    size_t len;
-    for(i = 0; i < obj_id_nbr; ++i) {
-        len = strlen(OBJECT_INFO[i].generic_path);
-        if((generic_path_len == len) &&
-           (strncmp(generic_path, OBJECT_INFO[i].generic_path, len) == 0)) {
-            id = OBJECT_INFO[i].id;
+        if(parse_index(segment, len, &index)) {
+            store_index(s_trie[node].id, index, indexes);
+            if(last) {
+                break;
+            }
+            child = trie_find_child(node, "x", 1);
+        } else {
+            child = trie_find_child(node, segment, len);
+        }
+        when_true(TRIE_NO_NODE == child, exit);
+        node = child;
+        if(last) {
             break;
         }
+        segment = end + 1;
     }
+    id = s_trie[node].id;
 
 exit:
-    amxc_string_clean(&generic_path_str);
     return id;
 }
 
+/**
+ * Return the ID of an object.
+ *
+ * @param[in] path  object path, e.g., "XPON.ONU.1.SoftwareImage".
+ *
+ * Example: if @a path is "XPON.ONU.1.SoftwareImage", the function returns
+ *          obj_id_software_image
+ *
+ * @return one of the value of object_id_t smaller than obj_id_nbr upon
+ *         success, else obj_id_unknown
+ */
+object_id_t dm_get_object_id(const char* path) {
+    return dm_classify_path(path, NULL);
+}
+
 const object_info_t* dm_get_object_info(object_id_t id) {
     if(id < obj_id_nbr) {
         return &OBJECT_INFO[id];
@@ -430,10 +1027,40 @@ bool dm_get_object_param_info(object_id_t id,
                               const param_info_t** param_info,
                               uint32_t* size) {
     if(id < obj_id_nbr) {
-        *param_info = OBJECT_INFO[id].params;
-        *size = OBJECT_INFO[id].n_params;
+        *param_info = s_param_hash[id].params;
+        *size = s_param_hash[id].n_params;
         return true;
     }
     SAH_TRACEZ_ERROR(ME, "Invalid id [%d]", id);
     return false;
 }
+
+/**
+ * Return info about a param of an object.
+ *
+ * @param[in] id    object ID
+ * @param[in] name  param name, e.g. "Version"
+ *
+ * The function uses a perfect hash table. It only compares @a name with the
+ * name of one param of the object.
+ *
+ * @return info about the param if the object has a param with name @a name,
+ *         else NULL
+ */
+const param_info_t* dm_get_param_info(object_id_t id, const char* name) {
+
+    const param_info_t* param = NULL;
+    when_null(name, exit);
+    when_false_trace(id < obj_id_nbr, exit, ERROR, "Invalid id [%d]", id);
+
+    const param_hash_t* const table = &s_param_hash[id];
+    when_true(0 == table->n_params, exit);
+
+    const uint8_t slot = table->slots[param_hash(name, table->seed) & table->mask];
+    if((slot != 0) && (strcmp(table->params[slot - 1].name, name) == 0)) {
+        param = &table->params[slot - 1];
+    }
+
+exit:
+    return param;
+}
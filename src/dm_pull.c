@@ -0,0 +1,265 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file dm_pull.c
+ *
+ * Pull the param values of an object from the vendor module when they are
+ * read.
+ *
+ * By default the vendor module pushes the values of all objects. For objects
+ * which support it, e.g. the PM objects, the config option 'update_policy'
+ * can select another policy. See update_policy_t in dm_info.h:
+ * - "pull": each read of a param of the object results in a
+ *   get_param_values() call for that param.
+ * - "pull:<ms>": a read of a param of the object results in one
+ *   get_param_values() call for all params of the object, if the last one is
+ *   older than <ms>. The values are written to the DM. Reads within <ms>
+ *   afterwards are served from the DM.
+ *
+ * The vendor module then does not need to push updates for such an object.
+ *
+ * The API of get_param_values() allows the vendor module to only support one
+ * parameter name per call. The module applies the same policy as trx_cache.c:
+ * if pulling all params of an object fails, it pulls the param being read on
+ * its own. If that succeeds, the module remembers that the vendor module
+ * only supports one name per call for that object type, and pulls each param
+ * on its own for all objects of that type from then on. Else it considers the
+ * error transient, and tries again after <ms>.
+ */
+
+/* Related header */
+#include "dm_pull.h"
+
+/* System headers */
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strcmp() */
+
+/* Other libraries' headers */
+#include <amxd/amxd_object.h>    /* amxd_object_get_param_def() */
+#include <amxd/amxd_parameter.h> /* amxd_param_set_value() */
+
+/* Own headers */
+#include "dm_info.h"      /* dm_get_update_policy() */
+#include "pon_ctrl.h"     /* pon_ctrl_get_param_values() */
+#include "utils_time.h"   /* time_get_monotonic_ms() */
+#include "xpon_trace.h"
+
+/**
+ * @pulled_at: time in ms of the monotonic clock when the plugin pulled all
+ *             params of the object the last time. 0 if never.
+ */
+struct _pull_state {
+    uint64_t pulled_at;
+};
+
+/**
+ * Element 'i' is true if the vendor module only supports one name per
+ * get_param_values() call for objects of type 'i'.
+ */
+static bool s_single_name_only[obj_id_nbr];
+
+static pull_state_t* get_state(amxd_object_t* const object) {
+
+    pull_state_t* state = (pull_state_t*) object->priv;
+    if(NULL == state) {
+        state = calloc(1, sizeof(pull_state_t));
+        when_null_trace(state, exit, ERROR, "Failed to allocate pull_state_t");
+        object->priv = state;
+    }
+
+exit:
+    return state;
+}
+
+/**
+ * Write the values returned by the vendor module to the DM.
+ *
+ * @param[in] object: object the values are for
+ * @param[in] params: htable with the param values
+ * @param[in] name: name of the param being read
+ * @param[in,out] value: the function copies the value of @a name to it
+ */
+static void store_values(amxd_object_t* const object, const amxc_var_t* const params,
+                         const char* const name, amxc_var_t* const value) {
+
+    amxc_var_for_each(param_value, params) {
+        const char* const param_name = amxc_var_key(param_value);
+        amxd_param_t* const def = amxd_object_get_param_def(object, param_name);
+        if(NULL == def) {
+            SAH_TRACEZ_ERROR(ME, "Unknown param: %s", param_name);
+            continue;
+        }
+        if(amxd_param_set_value(def, param_value) != amxd_status_ok) {
+            SAH_TRACEZ_ERROR(ME, "Failed to set %s", param_name);
+            continue;
+        }
+        if(strcmp(param_name, name) == 0) {
+            amxc_var_copy(value, param_value);
+        }
+    }
+}
+
+/**
+ * Ask the vendor module for the values of one or more params of an object.
+ *
+ * @return true on success, else false
+ */
+static bool pull(amxd_object_t* const object, const char* const path,
+                 const char* const names, const char* const name,
+                 amxc_var_t* const value) {
+
+    bool rv = false;
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+
+    when_failed_trace(pon_ctrl_get_param_values(path, names, &ret), exit, ERROR,
+                      "Failed to query %s.%s", path, names);
+    const amxc_var_t* const params = GET_ARG(&ret, "parameters");
+    when_null_trace(params, exit, ERROR, "Failed to extract 'parameters'");
+    store_values(object, params, name, value);
+    rv = true;
+
+exit:
+    amxc_var_clean(&ret);
+    return rv;
+}
+
+static void get_all_param_names(object_id_t id, amxc_string_t* const names) {
+
+    uint32_t i;
+    uint32_t n_params = 0;
+    const param_info_t* params = NULL;
+
+    when_false(dm_get_object_param_info(id, &params, &n_params), exit);
+    for(i = 0; i < n_params; ++i) {
+        amxc_string_appendf(names, "%s%s", (i != 0) ? "," : "", params[i].name);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Get the value of a param from the vendor module if its object is pulled.
+ *
+ * @param[in] object: object the param belongs to
+ * @param[in] param: param being read
+ * @param[in] path: path of @a object
+ * @param[in,out] value: current value of the param in the DM. If the function
+ *                       pulled the param, it assigns the new value to it.
+ *
+ * The read action of a param of an object which supports pull must call this
+ * function.
+ *
+ * @return true if the object has a pull policy, else false
+ */
+bool dm_pull_param_value(amxd_object_t* const object, amxd_param_t* const param,
+                         const char* const path, amxc_var_t* const value) {
+
+    uint32_t cache_ms = 0;
+    const char* const name = amxd_param_get_name(param);
+    const object_id_t id = dm_classify_path(path, NULL);
+    const update_policy_t policy = dm_get_update_policy(id, &cache_ms);
+    amxc_string_t names;
+    amxc_string_init(&names, 0);
+
+    if(update_policy_push == policy) {
+        return false;
+    }
+    if((update_policy_pull == policy) || s_single_name_only[id]) {
+        pull(object, path, name, name, value);
+        goto exit;
+    }
+
+    pull_state_t* const state = get_state(object);
+    when_null(state, exit);
+    const uint64_t now = time_get_monotonic_ms();
+    if((state->pulled_at != 0) && ((now - state->pulled_at) < cache_ms)) {
+        goto exit;
+    }
+    get_all_param_names(id, &names);
+    if(!pull(object, path, amxc_string_get(&names, 0), name, value)) {
+        /* The vendor module might only support one name per call */
+        if(pull(object, path, name, name, value)) {
+            SAH_TRACEZ_WARNING(ME, "Vendor module only returns %s.%s if queried on "
+                               "its own: pull each param on its own", path, name);
+            s_single_name_only[id] = true;
+        } else {
+            SAH_TRACEZ_WARNING(ME, "Failed to pull %s: retry after %d ms", path, cache_ms);
+        }
+    }
+    state->pulled_at = now;
+
+exit:
+    amxc_string_clean(&names);
+    return true;
+}
+
+/**
+ * Delete the state attached to a pulled object.
+ *
+ * tr181-xpon calls this function if a pulled object is destroyed.
+ */
+void dm_pull_delete_state(pull_state_t* state) {
+    free(state);
+}
@@ -0,0 +1,662 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file dm_snapshot.c
+ *
+ * Warm start: snapshot of the XPON DM which the plugin loads at startup.
+ *
+ * Without snapshot, the XPON DM is empty after a restart of the plugin until
+ * it has queried all objects from the vendor module. See
+ * populate_dm_startup.c. Consumers then see objects missing for a while.
+ *
+ * This module writes the instances under XPON.ONU, with their keys and the
+ * parameters known by dm_info.c, to the file given by the config option
+ * 'dm_snapshot_file'. It does so at shutdown, and every
+ * 'dm_snapshot_interval_ms' if that option is not 0. The file is meant to be
+ * on tmpfs: it survives a restart of the plugin, not a reboot. The module only
+ * rewrites the file if the contents changed. The option is empty by default:
+ * the warm start is opt-in.
+ *
+ * At startup, the module loads the file into the DM with one batch, before
+ * the plugin starts querying the vendor module. It marks each instance it
+ * created as stale. The startup population then reconciles the DM with the
+ * vendor module:
+ * - It also queries the content of stale instances, which it otherwise skips
+ *   because they exist. Only params whose value differs are written to the
+ *   DM. Each instance the vendor module confirms is no longer stale.
+ * - When it has handled all tasks for an ONU, it removes the instances of
+ *   that ONU which are still stale: the vendor module no longer has them.
+ * - When it stops polling for ONUs, it removes all instances which are still
+ *   stale.
+ *
+ * The protected parameter XPON.StaleInstances reports the number of stale
+ * instances.
+ *
+ * The file has one line per object or parameter:
+ * - "I <template path> <index>": instance
+ * - "S <path>": singleton
+ * - "K <name> <type> <value>": key of the instance of the previous line
+ * - "P <name> <type> <value>": param of the object of the previous I or S line
+ * The type is the AMXC_VAR_ID of the value. A backslash and a newline in the
+ * value are escaped as "\\" and "\n".
+ */
+
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function ‘getline’
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* Related header */
+#include "dm_snapshot.h"
+
+/* System headers */
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>    /* fopen(), getline() */
+#include <stdlib.h>   /* free(), strtoul() */
+#include <string.h>   /* strchr(), strcmp() */
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>
+#include <amxp/amxp_timer.h>            /* amxp_timer_new() */
+#include <amxd/amxd_dm.h>               /* amxd_dm_findf() */
+#include <amxd/amxd_object.h>           /* amxd_object_get_param_value() */
+#include <amxd/amxd_object_hierarchy.h> /* amxd_object_findf() */
+#include <amxo/amxo.h>                  /* amxo_parser_t */
+
+/* Own headers */
+#include "data_model.h"   /* dm_apply_batch_impl() */
+#include "dm_info.h"      /* dm_get_object_id() */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_dm() */
+#include "file_utils.h"   /* write_file_atomically() */
+#include "utils_time.h"   /* time_get_monotonic_ms() */
+#include "xpon_trace.h"
+
+#define SNAPSHOT_FILE_CONFIG "dm_snapshot_file"
+#define SNAPSHOT_INTERVAL_CONFIG "dm_snapshot_interval_ms"
+#define SNAPSHOT_HEADER "XPON-DM-SNAPSHOT 1"
+
+/** Path of the snapshot file. NULL if the warm start is disabled. */
+static char* s_file = NULL;
+static amxp_timer_t* s_timer = NULL;
+/** Contents of the snapshot file as last written by this module */
+static amxc_string_t s_last_saved;
+/** htable with the stale instances: the key is the path, the value the index */
+static amxc_var_t s_stale;
+static bool s_active = false;
+
+static void append_escaped(amxc_string_t* const out, const char* const value) {
+    const char* c;
+    for(c = value; *c != '\0'; ++c) {
+        if(*c == '\\') {
+            amxc_string_append(out, "\\\\", 2);
+        } else if(*c == '\n') {
+            amxc_string_append(out, "\\n", 2);
+        } else {
+            amxc_string_append(out, c, 1);
+        }
+    }
+}
+
+static void unescape(char* const value) {
+    char* in = value;
+    char* out = value;
+    while(*in != '\0') {
+        if((*in == '\\') && (*(in + 1) == 'n')) {
+            *out = '\n';
+            ++in;
+        } else if((*in == '\\') && (*(in + 1) == '\\')) {
+            *out = '\\';
+            ++in;
+        } else {
+            *out = *in;
+        }
+        ++in;
+        ++out;
+    }
+    *out = '\0';
+}
+
+static void append_value(amxc_string_t* const out, char tag, const char* const name,
+                         const amxc_var_t* const value) {
+    char* const str = amxc_var_dyncast(cstring_t, value);
+    amxc_string_appendf(out, "%c %s %u ", tag, name, amxc_var_type_of(value));
+    append_escaped(out, str ? str : "");
+    amxc_string_append(out, "\n", 1);
+    free(str);
+}
+
+static void save_object(amxd_object_t* const object, const char* const path,
+                        uint32_t index, amxc_string_t* const out);
+
+/**
+ * Save the children of an object.
+ *
+ * @param[in] object: the object
+ * @param[in] obj_path: path of @a object, including its index if it's an
+ *                      instance
+ * @param[in] children: comma-separated list with the names of the children
+ * @param[in] templates: true if @a children are templates, else false
+ * @param[in,out] out: the function appends the children to this string
+ */
+static void save_children(amxd_object_t* const object, const char* const obj_path,
+                          const char* const children, bool templates,
+                          amxc_string_t* const out) {
+
+    char child_path[256];
+    amxc_llist_t list;
+    amxc_string_t str;
+    amxc_llist_init(&list);
+    amxc_string_init(&str, 0);
+
+    when_null(children, exit);
+    amxc_string_set(&str, children);
+    when_false_trace(AMXC_STRING_SPLIT_OK == amxc_string_split_to_llist(&str, &list, ','),
+                     exit, ERROR, "Failed to split '%s'", children);
+
+    amxc_llist_iterate(it, &list) {
+        const char* const name = amxc_string_get(amxc_string_from_llist_it(it), 0);
+        amxd_object_t* const child = amxd_object_findf(object, "%s", name);
+        if(NULL == child) {
+            continue;
+        }
+        snprintf(child_path, 256, "%s.%s", obj_path, name);
+        if(!templates) {
+            save_object(child, child_path, 0, out);
+            continue;
+        }
+        amxd_object_iterate(instance, inst_it, child) {
+            amxd_object_t* const inst = amxc_container_of(inst_it, amxd_object_t, it);
+            save_object(inst, child_path, amxd_object_get_index(inst), out);
+        }
+    }
+
+exit:
+    amxc_llist_clean(&list, amxc_string_list_it_free);
+    amxc_string_clean(&str);
+}
+
+/**
+ * Save an object and its descendants.
+ *
+ * @param[in] object: the object
+ * @param[in] path: path of the template if @a object is an instance, else the
+ *                  path of @a object
+ * @param[in] index: index of @a object if it's an instance, else 0
+ * @param[in,out] out: the function appends the object to this string
+ */
+static void save_object(amxd_object_t* const object, const char* const path,
+                        uint32_t index, amxc_string_t* const out) {
+
+    uint32_t i;
+    char obj_path[256];
+    const object_info_t* const info = dm_get_object_info(dm_get_object_id(path));
+    when_null(info, exit);
+
+    if(index) {
+        amxc_string_appendf(out, "I %s %u\n", path, index);
+        const amxc_var_t* const key = amxd_object_get_param_value(object, info->key_name);
+        if(key) {
+            append_value(out, 'K', info->key_name, key);
+        }
+        snprintf(obj_path, 256, "%s.%u", path, index);
+    } else {
+        amxc_string_appendf(out, "S %s\n", path);
+        snprintf(obj_path, 256, "%s", path);
+    }
+    for(i = 0; i < info->n_params; ++i) {
+        const amxc_var_t* const value = amxd_object_get_param_value(object, info->params[i].name);
+        if(value && (amxc_var_type_of(value) != AMXC_VAR_ID_NULL)) {
+            append_value(out, 'P', info->params[i].name, value);
+        }
+    }
+    save_children(object, obj_path, info->singletons, false, out);
+    save_children(object, obj_path, info->templates, true, out);
+
+exit:
+    return;
+}
+
+static void snapshot_timer_expired(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    dm_snapshot_save();
+}
+
+static void update_nr_of_stale_instances(void) {
+    dm_set_nr_of_stale_instances(
+        (uint32_t) amxc_htable_size(amxc_var_constcast(amxc_htable_t, &s_stale)));
+}
+
+/**
+ * Initialize the warm start.
+ *
+ * The function reads the config options, and starts the timer to save the
+ * snapshot periodically.
+ *
+ * The plugin must call this function once at startup, after it loaded the
+ * vendor module, and before it starts to populate the DM.
+ */
+void dm_snapshot_init(void) {
+
+    amxc_string_init(&s_last_saved, 0);
+    amxc_var_init(&s_stale);
+    amxc_var_set_type(&s_stale, AMXC_VAR_ID_HTABLE);
+    s_active = true;
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
+
+    const char* const file = GET_CHAR(&parser->config, SNAPSHOT_FILE_CONFIG);
+    if((NULL == file) || (file[0] == '\0')) {
+        SAH_TRACEZ_INFO(ME, "Warm start disabled");
+        goto exit;
+    }
+    s_file = strdup(file);
+    when_null_trace(s_file, exit, ERROR, "Failed to allocate memory");
+
+    const uint32_t interval = GET_UINT32(&parser->config, SNAPSHOT_INTERVAL_CONFIG);
+    SAH_TRACEZ_INFO(ME, "%s=%s %s=%d", SNAPSHOT_FILE_CONFIG, s_file,
+                    SNAPSHOT_INTERVAL_CONFIG, interval);
+    when_true(0 == interval, exit);
+    when_failed_trace(amxp_timer_new(&s_timer, snapshot_timer_expired, NULL),
+                      exit, ERROR, "Failed to create snapshot timer");
+    amxp_timer_set_interval(s_timer, interval);
+    amxp_timer_start(s_timer, interval);
+
+exit:
+    return;
+}
+
+/**
+ * Save the snapshot one last time, and clean up.
+ *
+ * The plugin must call this function once when stopping, while the DM still
+ * exists.
+ */
+void dm_snapshot_cleanup(void) {
+    when_false(s_active, exit);
+    dm_snapshot_save();
+    amxp_timer_delete(&s_timer);
+    free(s_file);
+    s_file = NULL;
+    amxc_string_clean(&s_last_saved);
+    amxc_var_clean(&s_stale);
+    s_active = false;
+
+exit:
+    return;
+}
+
+/**
+ * Parse a line of the snapshot file.
+ *
+ * @param[in,out] line: the line, without newline. The function modifies it.
+ * @param[in,out] ops: list with batch operations. The function appends an
+ *                     operation for an I or S line.
+ * @param[in,out] op: current operation. The function updates it for an I or
+ *                    S line.
+ *
+ * @return true on success, else false
+ */
+static bool parse_line(char* const line, amxc_var_t* const ops, amxc_var_t** const op) {
+
+    bool rv = false;
+    char* end = NULL;
+    amxc_var_t str;
+    amxc_var_init(&str);
+
+    when_true((line[0] == '\0') || (line[1] != ' '), exit);
+    char* const path = line + 2;
+
+    if((line[0] == 'I') || (line[0] == 'S')) {
+        *op = amxc_var_add(amxc_htable_t, ops, NULL);
+        amxc_var_add_key(amxc_htable_t, *op, "parameters", NULL);
+        if(line[0] == 'S') {
+            amxc_var_add_key(cstring_t, *op, "action", "change");
+            amxc_var_add_key(cstring_t, *op, "path", path);
+            rv = true;
+            goto exit;
+        }
+        char* const sep = strchr(path, ' ');
+        when_null(sep, exit);
+        *sep = '\0';
+        amxc_var_add_key(cstring_t, *op, "action", "add_or_change");
+        amxc_var_add_key(cstring_t, *op, "path", path);
+        amxc_var_add_key(uint32_t, *op, "index", (uint32_t) strtoul(sep + 1, NULL, 10));
+        amxc_var_add_key(amxc_htable_t, *op, "keys", NULL);
+        rv = true;
+        goto exit;
+    }
+
+    when_false((line[0] == 'K') || (line[0] == 'P'), exit);
+    when_null(*op, exit);
+    char* const name = path;
+    char* const sep = strchr(name, ' ');
+    when_null(sep, exit);
+    *sep = '\0';
+    const uint32_t type = (uint32_t) strtoul(sep + 1, &end, 10);
+    when_false((end != NULL) && (*end == ' '), exit);
+    char* const value = end + 1;
+    unescape(value);
+
+    amxc_var_t* const parent = GET_ARG(*op, (line[0] == 'K') ? "keys" : "parameters");
+    when_null(parent, exit);
+    amxc_var_set(cstring_t, &str, value);
+    amxc_var_t* const converted = amxc_var_add_new_key(parent, name);
+    when_null(converted, exit);
+    when_failed_trace(amxc_var_convert(converted, &str, type), exit, ERROR,
+                      "Failed to convert '%s' for %s to type %d", value, name, type);
+    rv = true;
+
+exit:
+    amxc_var_clean(&str);
+    return rv;
+}
+
+/**
+ * Mark the instances the snapshot created as stale.
+ *
+ * @param[in] ops: operations passed to dm_apply_batch_impl()
+ * @param[in] results: result per operation returned by dm_apply_batch_impl()
+ */
+static void mark_stale(const amxc_var_t* const ops, const amxc_var_t* const results) {
+
+    char key[256];
+    const amxc_var_t* result = amxc_var_get_first(results);
+    amxc_var_for_each(op, ops) {
+        const uint32_t index = GET_UINT32(op, "index");
+        if((index != 0) && result && (amxc_var_dyncast(int32_t, result) == 0)) {
+            snprintf(key, 256, "%s.%u", GET_CHAR(op, "path"), index);
+            amxc_var_add_key(uint32_t, &s_stale, key, index);
+        }
+        result = result ? amxc_var_get_next(result) : NULL;
+    }
+}
+
+/**
+ * Load the snapshot into the DM.
+ *
+ * The plugin must call this function once at startup, after
+ * dm_snapshot_init(), and before it starts to populate the DM.
+ */
+void dm_snapshot_load(void) {
+
+    FILE* f = NULL;
+    char* line = NULL;
+    size_t len = 0;
+    ssize_t n;
+    uint32_t line_nr = 0;
+    amxc_var_t* op = NULL;
+    amxc_var_t batch;
+    amxc_var_t results;
+    amxc_var_init(&batch);
+    amxc_var_init(&results);
+
+    when_null(s_file, exit);
+    const uint64_t start = time_get_monotonic_ms();
+
+    f = fopen(s_file, "r");
+    when_null_trace(f, exit, INFO, "No snapshot %s", s_file);
+
+    amxc_var_set_type(&batch, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const ops = amxc_var_add_key(amxc_llist_t, &batch, "operations", NULL);
+
+    while((n = getline(&line, &len, f)) != -1) {
+        ++line_nr;
+        if((n > 0) && (line[n - 1] == '\n')) {
+            line[n - 1] = '\0';
+        }
+        if(1 == line_nr) {
+            when_false_trace(strcmp(line, SNAPSHOT_HEADER) == 0, exit, ERROR,
+                             "%s: unknown format", s_file);
+            continue;
+        }
+        if(!parse_line(line, ops, &op)) {
+            SAH_TRACEZ_ERROR(ME, "%s:%d: invalid line", s_file, line_nr);
+        }
+    }
+
+    dm_apply_batch_impl(&batch, &results);
+    mark_stale(ops, &results);
+    update_nr_of_stale_instances();
+    SAH_TRACEZ_INFO(ME, "Loaded %zu objects from %s in %" PRIu64 " ms",
+                    amxc_llist_size(amxc_var_constcast(amxc_llist_t, ops)), s_file,
+                    time_get_monotonic_ms() - start);
+
+exit:
+    if(f) {
+        fclose(f);
+    }
+    free(line);
+    amxc_var_clean(&results);
+    amxc_var_clean(&batch);
+}
+
+/**
+ * Write the snapshot file.
+ *
+ * @return true on success, else false
+ */
+bool dm_snapshot_save(void) {
+
+    bool rv = false;
+    amxc_string_t out;
+    amxc_string_init(&out, 0);
+
+    when_null(s_file, exit);
+    amxd_object_t* const onu_templ = amxd_dm_findf(xpon_mngr_get_dm(), "XPON.ONU");
+    when_null(onu_templ, exit);
+
+    amxc_string_appendf(&out, "%s\n", SNAPSHOT_HEADER);
+    amxd_object_iterate(instance, it, onu_templ) {
+        amxd_object_t* const onu = amxc_container_of(it, amxd_object_t, it);
+        save_object(onu, "XPON.ONU", amxd_object_get_index(onu), &out);
+    }
+
+    const char* const contents = amxc_string_get(&out, 0);
+    if(strcmp(contents, amxc_string_get(&s_last_saved, 0)) == 0) {
+        rv = true;
+        goto exit;
+    }
+    when_false_trace(write_file_atomically(s_file, contents), exit, ERROR,
+                     "Failed to write %s", s_file);
+    amxc_string_copy(&s_last_saved, &out);
+    SAH_TRACEZ_DEBUG(ME, "Wrote %zu bytes to %s", amxc_string_text_length(&out), s_file);
+    rv = true;
+
+exit:
+    amxc_string_clean(&out);
+    return rv;
+}
+
+/**
+ * Return true if an instance was loaded from the snapshot, and the vendor
+ * module did not confirm it yet.
+ */
+bool dm_snapshot_is_stale(const char* const path, uint32_t index) {
+
+    char key[256];
+    when_false(s_active, exit);
+    snprintf(key, 256, "%s.%u", path, index);
+    return GET_ARG(&s_stale, key) != NULL;
+
+exit:
+    return false;
+}
+
+/**
+ * Mark an instance as confirmed by the vendor module: it's no longer stale.
+ */
+void dm_snapshot_confirm(const char* const path, uint32_t index) {
+
+    char key[256];
+    when_false(s_active, exit);
+    snprintf(key, 256, "%s.%u", path, index);
+    amxc_var_t* entry = GET_ARG(&s_stale, key);
+    when_null(entry, exit);
+    amxc_var_delete(&entry);
+    update_nr_of_stale_instances();
+
+exit:
+    return;
+}
+
+/**
+ * Mark all instances in a subtree as confirmed by the vendor module.
+ *
+ * @param[in] path, index: root of the subtree. If @a index is 0, @a path is
+ *                         a singleton or template object.
+ *
+ * tr181-xpon calls this function if the vendor module fails to report the
+ * instances or the content of an object. It then does not know if the stale
+ * instances in that subtree still exist: it keeps them rather than removing
+ * them.
+ */
+void dm_snapshot_confirm_subtree(const char* const path, uint32_t index) {
+
+    char prefix[256];
+    size_t prefix_len = 0;
+    uint32_t n_confirmed = 0;
+
+    when_false(s_active, exit);
+    if(index) {
+        snprintf(prefix, 256, "%s.%u", path, index);
+    } else {
+        snprintf(prefix, 256, "%s", path);
+    }
+    prefix_len = strlen(prefix);
+
+    amxc_var_for_each(entry, &s_stale) {
+        const char* const key = amxc_var_key(entry);
+        if((strncmp(key, prefix, prefix_len) != 0) ||
+           ((key[prefix_len] != '\0') && (key[prefix_len] != '.'))) {
+            continue;
+        }
+        amxc_var_delete(&entry);
+        ++n_confirmed;
+    }
+    if(n_confirmed) {
+        SAH_TRACEZ_WARNING(ME, "Keep %u stale instances under %s", n_confirmed, prefix);
+        update_nr_of_stale_instances();
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Remove the stale instances from the DM.
+ *
+ * @param[in] onu_index: only remove the stale instances of this ONU instance,
+ *                       including the ONU instance itself. 0 to remove all
+ *                       stale instances.
+ */
+void dm_snapshot_remove_stale(uint32_t onu_index) {
+
+    char prefix[32];
+    size_t prefix_len = 0;
+    uint32_t n_removed = 0;
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    when_false(s_active, exit);
+    if(onu_index) {
+        snprintf(prefix, 32, "XPON.ONU.%u", onu_index);
+        prefix_len = strlen(prefix);
+    }
+
+    amxc_var_for_each(entry, &s_stale) {
+        const char* const key = amxc_var_key(entry);
+        if(onu_index && ((strncmp(key, prefix, prefix_len) != 0) ||
+                         ((key[prefix_len] != '\0') && (key[prefix_len] != '.')))) {
+            continue;
+        }
+        const uint32_t index = amxc_var_dyncast(uint32_t, entry);
+        const char* const dot = strrchr(key, '.');
+        if(dot) {
+            amxc_string_t path;
+            amxc_string_init(&path, 0);
+            amxc_string_append(&path, key, (size_t) (dot - key));
+            const char* const path_cstr = amxc_string_get(&path, 0);
+            /* The instance is gone if an ancestor was removed before */
+            if(dm_does_instance_exist(path_cstr, index)) {
+                SAH_TRACEZ_INFO(ME, "Remove stale instance %s", key);
+                amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+                amxc_var_add_key(cstring_t, &args, "path", path_cstr);
+                amxc_var_add_key(uint32_t, &args, "index", index);
+                dm_remove_instance(&args);
+                ++n_removed;
+            }
+            amxc_string_clean(&path);
+        }
+        amxc_var_delete(&entry);
+    }
+    if(n_removed) {
+        SAH_TRACEZ_INFO(ME, "Removed %d stale instance(s)", n_removed);
+    }
+    update_nr_of_stale_instances();
+
+exit:
+    amxc_var_clean(&args);
+}
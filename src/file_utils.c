@@ -75,8 +75,9 @@
 #include <errno.h>
 #include <fcntl.h>  /* open() */
 #include <stdio.h>  /* rename() */
+#include <stdlib.h> /* mkstemp() */
 #include <string.h> /* strerror() */
-#include <unistd.h> /* fdatasync() */
+#include <unistd.h> /* fdatasync(), unlink() */
 
 /* Own headers */
 #include "xpon_trace.h"
@@ -146,8 +147,7 @@ static bool check_file_has_value(const char* const path, const char* const value
  * If @a path already exists and has @a value as contents, the function
  * immediately returns true to avoid an unneeded write.
  *
- * The function first writes the value to the file @a path with ".tmp"
- * appended. Then it renames the file to @a path.
+ * The function writes the file via write_file_atomically().
  *
  * @return true on success, else false
  */
@@ -172,20 +172,50 @@ bool write_file(const char* const path, const char* const value) {
         }
     }
 
+    return write_file_atomically(path, value);
+}
+
+/**
+ * Write the string @a data to the file @a path, replacing its contents.
+ *
+ * @param[in] path: file path
+ * @param[in] data: value to write to @a path. It can be of any length.
+ *
+ * The function first writes the value to a new temporary file in the
+ * directory of @a path. Then it renames the file to @a path. Hence a reader
+ * never sees a partially written file.
+ *
+ * The function creates the temporary file with mkstemp(): with mode 0600, and
+ * only if it does not exist yet. Hence it never writes via a file or a
+ * symlink someone else created, e.g. if @a path is in a world-writable
+ * directory such as /tmp.
+ *
+ * @return true on success, else false
+ */
+bool write_file_atomically(const char* const path, const char* const data) {
+
     char tmpfile[256];
-    if(snprintf(tmpfile, 256, "%s.tmp", path) < 0) {
-        SAH_TRACEZ_ERROR(ME, "%s: failed to create path with .tmp", path);
+    const int len = snprintf(tmpfile, 256, "%s.XXXXXX", path);
+    if((len < 0) || (len >= 256)) {
+        SAH_TRACEZ_ERROR(ME, "%s: failed to create path of temporary file", path);
         return false;
     }
 
-    FILE* f = fopen(tmpfile, "w");
+    const int fd = mkstemp(tmpfile);
+    if(fd == -1) {
+        SAH_TRACEZ_ERROR(ME, "Failed to create %s: %s", tmpfile, strerror(errno));
+        return false;
+    }
+    FILE* f = fdopen(fd, "w");
     if(!f) {
         SAH_TRACEZ_ERROR(ME, "Failed to open %s: %s", tmpfile, strerror(errno));
+        close(fd);
+        unlink(tmpfile);
         return false;
     }
 
     bool rv = true;
-    if(fputs(value, f) == EOF) {
+    if(fputs(data, f) == EOF) {
         SAH_TRACEZ_ERROR(ME, "Failed to write to %s", tmpfile);
         rv = false;
     }
@@ -193,10 +223,13 @@ bool write_file(const char* const path, const char* const value) {
     if(fclose(f) == EOF) {
         SAH_TRACEZ_ERROR(ME, "Failed to close %s: %s", tmpfile, strerror(errno));
     }
+    if(rv) {
+        rv = rename_file(tmpfile, path);
+    }
     if(!rv) {
-        return false;
+        unlink(tmpfile);
     }
-    return rename_file(tmpfile, path);
+    return rv;
 }
 
 /**
@@ -66,6 +66,7 @@
 /* System headers */
 #include <dlfcn.h>  /* dlerror() */
 #include <stdlib.h> /* free() */
+#include <string.h> /* strcmp() */
 #include <unistd.h> /* access() */
 
 /* Other libraries' headers */
@@ -75,9 +76,13 @@
 #include <amxp/amxp_dir.h> /* amxp_dir_scan() */
 
 /* Own headers */
+#include "call_stats.h"    /* call_stats_record() */
+#include "capture.h"       /* capture_call_begin() */
 #include "data_model.h"    /* dm_get_vendor_module() */
 #include "pon_stat.h"      /* dm_instance_added() */
 #include "pon_cfg.h"       /* pon_cfg_get_param_value() */
+#include "utils_time.h"    /* time_get_monotonic_us() */
+#include "xpon_capture.h"
 #include "xpon_trace.h"
 
 #define MOD_PON_STAT "pon_stat"
@@ -93,25 +98,69 @@ static amxm_shared_object_t* s_module_so = NULL; /* vendor module loaded */
 typedef struct _pon_stat_function {
     const char* name;
     amxm_callback_t impl;
+    call_stats_t* stats;
 } pon_stat_function_t;
 
+/**
+ * Define a wrapper around the pon_stat function 'fn' which updates the
+ * statistics of the function, and captures the call if capturing is enabled.
+ * The statistics are exposed in XPON.Diagnostics. See capture.c for the
+ * capture.
+ */
+#define INSTRUMENTED_PON_STAT_FUNCTION(fn) \
+    static call_stats_t s_stats_ ## fn; \
+    static int instrumented_ ## fn(const char* function_name, \
+                                   amxc_var_t* args, \
+                                   amxc_var_t* ret) { \
+        capture_call_t call; \
+        const bool captured = \
+            capture_call_begin(&call, XPON_CAPTURE_PON_STAT, #fn, args); \
+        const uint64_t start_us = time_get_monotonic_us(); \
+        const int rc = fn(function_name, args, ret); \
+        call_stats_record(&s_stats_ ## fn, start_us, rc); \
+        if(captured) { \
+            capture_call_end(&call, rc, ret); \
+        } \
+        return rc; \
+    }
+
+INSTRUMENTED_PON_STAT_FUNCTION(dm_instance_added)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_instance_removed)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_object_changed)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_add_or_change_instance)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_apply_batch)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_update_ani_pm)
+INSTRUMENTED_PON_STAT_FUNCTION(omci_reset_mib)
+INSTRUMENTED_PON_STAT_FUNCTION(watch_file_descriptor_start)
+INSTRUMENTED_PON_STAT_FUNCTION(watch_file_descriptor_stop)
+INSTRUMENTED_PON_STAT_FUNCTION(dm_set_xpon_parameter)
+INSTRUMENTED_PON_STAT_FUNCTION(param_values_ready)
+INSTRUMENTED_PON_STAT_FUNCTION(onu_list_changed)
+
+#define PON_STAT_FUNCTION(fn) \
+    { .name = #fn, .impl = instrumented_ ## fn, .stats = &s_stats_ ## fn }
+
 static const pon_stat_function_t PON_STAT_FUNCTIONS[] = {
 
-    { .name = "dm_instance_added", .impl = dm_instance_added   },
-    { .name = "dm_instance_removed", .impl = dm_instance_removed },
-    { .name = "dm_object_changed", .impl = dm_object_changed   },
-    { .name = "dm_add_or_change_instance", .impl = dm_add_or_change_instance },
-    { .name = "omci_reset_mib", .impl = omci_reset_mib      },
-    { .name = "watch_file_descriptor_start", .impl = watch_file_descriptor_start },
-    { .name = "watch_file_descriptor_stop", .impl = watch_file_descriptor_stop },
-    { .name = "dm_set_xpon_parameter", .impl = dm_set_xpon_parameter },
-    { .name = NULL, .impl = NULL } /* sentinel */
+    PON_STAT_FUNCTION(dm_instance_added),
+    PON_STAT_FUNCTION(dm_instance_removed),
+    PON_STAT_FUNCTION(dm_object_changed),
+    PON_STAT_FUNCTION(dm_add_or_change_instance),
+    PON_STAT_FUNCTION(dm_apply_batch),
+    PON_STAT_FUNCTION(dm_update_ani_pm),
+    PON_STAT_FUNCTION(omci_reset_mib),
+    PON_STAT_FUNCTION(watch_file_descriptor_start),
+    PON_STAT_FUNCTION(watch_file_descriptor_stop),
+    PON_STAT_FUNCTION(dm_set_xpon_parameter),
+    PON_STAT_FUNCTION(param_values_ready),
+    PON_STAT_FUNCTION(onu_list_changed),
+    { .name = NULL, .impl = NULL, .stats = NULL } /* sentinel */
 };
 
 static const pon_stat_function_t PON_CFG_FUNCTIONS[] = {
 
-    { .name = "pon_cfg_get_param_value", .impl = pon_cfg_get_param_value },
-    { .name = NULL, .impl = NULL } /* sentinel */
+    { .name = "pon_cfg_get_param_value", .impl = pon_cfg_get_param_value, .stats = NULL },
+    { .name = NULL, .impl = NULL, .stats = NULL } /* sentinel */
 };
 
 static bool register_pon_stat_module(void) {
@@ -130,6 +179,8 @@ static bool register_pon_stat_module(void) {
 
     int i;
     for(i = 0; PON_STAT_FUNCTIONS[i].name != NULL; ++i) {
+        call_stats_register(call_stats_pon_stat, PON_STAT_FUNCTIONS[i].name,
+                            PON_STAT_FUNCTIONS[i].stats);
         if(amxm_module_add_function(s_pon_stat_module, PON_STAT_FUNCTIONS[i].name,
                                     PON_STAT_FUNCTIONS[i].impl)) {
             SAH_TRACEZ_ERROR(ME, "Failed to register self.%s.%s()", MOD_PON_STAT,
@@ -328,6 +379,24 @@ const char* mod_get_vendor_module_loaded(void) {
     return s_module_so ? amxc_string_get(&s_module_name, 0) : NULL;
 }
 
+/**
+ * Return the statistics of the pon_stat function @a name.
+ *
+ * pon_stat.c records the calls via the fast ABI in them, such that
+ * XPON.Diagnostics reports the calls of both ABIs.
+ *
+ * @return the statistics, or NULL if @a name is not a pon_stat function
+ */
+call_stats_t* mod_get_pon_stat_stats(const char* const name) {
+    int i;
+    for(i = 0; PON_STAT_FUNCTIONS[i].name != NULL; ++i) {
+        if(strcmp(PON_STAT_FUNCTIONS[i].name, name) == 0) {
+            return PON_STAT_FUNCTIONS[i].stats;
+        }
+    }
+    return NULL;
+}
+
 /**
  * Clean up the module_mgmt part of this plugin.
  *
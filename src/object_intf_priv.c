@@ -60,14 +60,40 @@
 **
 ****************************************************************************/
 
+/**
+ * @file object_intf_priv.c
+ *
+ * Private data attached to the interface objects EthernetUNI and ANI.
+ *
+ * The private data keeps the time of the last Status change, to implement
+ * LastChange, and a ring buffer with the last OIPRIV_STATUS_HISTORY_SIZE
+ * Status transitions. It also counts the flaps: the number of times the
+ * vendor module changed Status from Up to another value.
+ *
+ * If the config option 'status_damping_ms' is not 0, the module damps flaps.
+ * If the vendor module changes Status less than 'status_damping_ms' after the
+ * previous Status change in the DM, the module holds back the new value. It
+ * writes the held value to the DM when 'status_damping_ms' has passed since
+ * the previous change, unless the vendor module restored the value in the DM
+ * in the meantime. So a rapid sequence of Up/Down toggles results in at most
+ * one Status change per 'status_damping_ms' in the DM, and consumers such as
+ * NetModel are not flooded with changes.
+ *
+ * All timestamps are taken with time_get_cached_monotonic_ms(): one clock
+ * read per iteration of the event loop is accurate enough.
+ */
+
 /* Related header */
 #include "object_intf_priv.h"
 
 /* System headers */
+#include <inttypes.h> /* PRIu64 */
 #include <stdint.h>
-#include <stdlib.h> /* calloc(), free() */
+#include <stdlib.h>   /* calloc(), free() */
+#include <string.h>   /* strcmp(), strncpy() */
 
 /* Other libraries' headers */
+#include <amxc/amxc_macros.h> /* UNUSED */
 
 /**
  * Include amxp.h to avoid following compile error:
@@ -77,23 +103,80 @@
  * /usr/include/amxd/amxd_types.h:266:5: error: unknown type name ‘amxp_signal_mngr_t’
  */
 #include <amxp/amxp.h>
+#include <amxd/amxd_object.h>           /* amxd_object_get_param_value() */
 #include <amxd/amxd_object_hierarchy.h> /* amxd_object_get_instance() */
+#include <amxd/amxd_transaction.h>      /* amxd_trans_t */
+#include <amxo/amxo.h>                  /* amxo_parser_t */
 
 /* Own headers */
+#include "ani_pm.h"                     /* ani_pm_delete_params() */
 #include "dm_xpon_mngr.h"               /* xpon_mngr_get_dm() */
-#include "utils_time.h"                 /* time_get_system_uptime() */
+#include "utils_time.h"                 /* time_get_cached_monotonic_ms() */
 #include "xpon_trace.h"
 
+#define STATUS_DAMPING_CONFIG "status_damping_ms"
+
+static uint32_t s_damping_ms = 0;
+
+static void copy_status(char* const dest, const char* const src) {
+    strncpy(dest, src, OIPRIV_STATUS_MAX_SIZE - 1);
+    dest[OIPRIV_STATUS_MAX_SIZE - 1] = '\0';
+}
 
 static object_intf_priv_t* create_priv(void) {
     object_intf_priv_t* priv = calloc(1, sizeof(object_intf_priv_t));
     when_null_trace(priv, exit, ERROR, "Failed to create object_intf_priv_t");
-    priv->last_change = time_get_system_uptime();
+    priv->last_change = time_get_cached_monotonic_ms();
 
 exit:
     return priv;
 }
 
+/**
+ * Write the Status value held back by the flap damping to the DM.
+ */
+static void damping_timer_expired(UNUSED amxp_timer_t* timer, void* priv) {
+
+    amxd_object_t* const object = (amxd_object_t*) priv;
+    object_intf_priv_t* const oipriv = (object_intf_priv_t*) object->priv;
+    amxd_trans_t transaction;
+    amxd_trans_init(&transaction);
+
+    when_null(oipriv, exit);
+    when_true(oipriv->held_status[0] == '\0', exit);
+
+    const char* const current = GET_CHAR(amxd_object_get_param_value(object, "Status"), NULL);
+    if((NULL == current) || (strcmp(current, oipriv->held_status) != 0)) {
+        amxd_trans_set_attr(&transaction, amxd_tattr_change_ro, true);
+        amxd_trans_select_object(&transaction, object);
+        amxd_trans_set_value(cstring_t, &transaction, "Status", oipriv->held_status);
+        if(amxd_trans_apply(&transaction, xpon_mngr_get_dm()) != amxd_status_ok) {
+            SAH_TRACEZ_ERROR(ME, "Failed to set Status to %s", oipriv->held_status);
+        }
+    }
+    oipriv->held_status[0] = '\0';
+
+exit:
+    amxd_trans_clean(&transaction);
+}
+
+/**
+ * Read the config options of this module.
+ */
+void oipriv_init(void) {
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
+
+    const amxc_var_t* const damping = GET_ARG(&parser->config, STATUS_DAMPING_CONFIG);
+    if(damping) {
+        s_damping_ms = amxc_var_dyncast(uint32_t, damping);
+    }
+    SAH_TRACEZ_INFO(ME, "%s=%d", STATUS_DAMPING_CONFIG, s_damping_ms);
+
+exit:
+    return;
+}
 /**
  * Attach private data to interface object referred by @a data.
  *
@@ -123,6 +206,8 @@ exit:
 
 void oipriv_delete_private_data(object_intf_priv_t* priv) {
     if(priv) {
+        amxp_timer_delete(&priv->damping_timer);
+        ani_pm_delete_params(priv->pm_params);
         free(priv);
     }
 }
@@ -131,24 +216,117 @@ void oipriv_delete_private_data(object_intf_priv_t* priv) {
  * Update the last_change field in the private data of an interface object.
  *
  * @param[in] data: event data. It has the path of the interface object for
- *                  which this function must update the last_change field.
+ *                  which this function must update the last_change field, and
+ *                  the new value of Status.
  *
  * tr181-xpon calls this function if the Status parameter of an interface object
- * is changed.
+ * is changed. The function also adds the transition to the Status history.
  */
 void oipriv_update_last_change(const amxc_var_t* const data) {
 
     const char* const path = GETP_CHAR(data, "path");
-    SAH_TRACEZ_DEBUG(ME, "path='%s'", path);
+    const char* const status = GETP_CHAR(data, "parameters.Status.to");
+    SAH_TRACEZ_DEBUG(ME, "path='%s' status='%s'", path, status ? status : "");
 
     amxd_dm_t* const dm = xpon_mngr_get_dm();
     const amxd_object_t* const obj = amxd_dm_signal_get_object(dm, data);
+    when_null_trace(obj, exit, ERROR, "object %s not found", path);
     when_null_trace(obj->priv, exit, ERROR, "object %s has no private data", path);
 
     object_intf_priv_t* const priv = (object_intf_priv_t* const) obj->priv;
-    priv->last_change = time_get_system_uptime();
+    priv->last_change = time_get_cached_monotonic_ms();
+
+    status_transition_t* const transition = &priv->history[priv->history_head];
+    transition->timestamp = priv->last_change;
+    copy_status(transition->status, status ? status : "");
+    priv->history_head = (priv->history_head + 1) % OIPRIV_STATUS_HISTORY_SIZE;
+    if(priv->history_count < OIPRIV_STATUS_HISTORY_SIZE) {
+        ++priv->history_count;
+    }
 
 exit:
     return;
 }
 
+/**
+ * Check if the flap damping must hold back a new value for Status.
+ *
+ * @param[in] object: EthernetUNI or ANI instance
+ * @param[in] status: value for Status the vendor module passed for @a object.
+ *                    NULL if the vendor module did not pass a value.
+ *
+ * tr181-xpon calls this function each time the vendor module wants to change
+ * an interface object. The function also counts the flaps.
+ *
+ * If the function returns true, the caller must not write @a status to the DM.
+ * The module writes it when the damping period expires.
+ *
+ * @return true if the caller must hold back @a status, else false
+ */
+bool oipriv_hold_status(amxd_object_t* const object, const amxc_var_t* const status) {
+
+    bool hold = false;
+    const char* const value = amxc_var_constcast(cstring_t, status);
+    when_null(value, exit);
+    object_intf_priv_t* const priv = (object_intf_priv_t*) object->priv;
+    when_null(priv, exit);
+
+    if(strcmp(value, priv->reported_status) != 0) {
+        if(strcmp(priv->reported_status, "Up") == 0) {
+            ++priv->nr_of_flaps;
+        }
+        copy_status(priv->reported_status, value);
+    }
+    when_true(0 == s_damping_ms, exit);
+
+    const char* const current = GET_CHAR(amxd_object_get_param_value(object, "Status"), NULL);
+    if(current && (strcmp(value, current) == 0)) {
+        /* The vendor module restored the value in the DM: drop the held value */
+        priv->held_status[0] = '\0';
+        amxp_timer_stop(priv->damping_timer);
+        goto exit;
+    }
+    if(priv->held_status[0] != '\0') {
+        copy_status(priv->held_status, value);
+        hold = true;
+        goto exit;
+    }
+    const uint64_t elapsed = time_get_cached_monotonic_ms() - priv->last_change;
+    if((0 == priv->history_count) || (elapsed >= s_damping_ms)) {
+        goto exit;
+    }
+    if(NULL == priv->damping_timer) {
+        when_failed_trace(amxp_timer_new(&priv->damping_timer, damping_timer_expired, object),
+                          exit, ERROR, "Failed to create damping timer");
+    }
+    copy_status(priv->held_status, value);
+    amxp_timer_start(priv->damping_timer, (unsigned int) (s_damping_ms - elapsed));
+    hold = true;
+
+exit:
+    return hold;
+}
+
+/**
+ * Write the Status history of an interface object to a string.
+ *
+ * @param[in] priv: private data of the interface object
+ * @param[in,out] str: the function sets it to a comma-separated list of the
+ *                     transitions, newest first. Each element has the format
+ *                     "<Status>:<seconds since the transition>".
+ */
+void oipriv_status_history_to_string(const object_intf_priv_t* const priv,
+                                     amxc_string_t* const str) {
+
+    uint32_t i;
+    const uint64_t now = time_get_cached_monotonic_ms();
+
+    amxc_string_reset(str);
+    for(i = 1; i <= priv->history_count; ++i) {
+        const uint32_t index = (priv->history_head + OIPRIV_STATUS_HISTORY_SIZE - i) %
+            OIPRIV_STATUS_HISTORY_SIZE;
+        const status_transition_t* const transition = &priv->history[index];
+        amxc_string_appendf(str, "%s%s:%" PRIu64, (i == 1) ? "" : ",",
+                            transition->status, (now - transition->timestamp) / 1000);
+    }
+}
@@ -69,62 +69,215 @@
 #include <amxm/amxm.h>
 
 /* Own headers */
-#include "module_mgmt.h" /* mod_get_vendor_module_loaded() */
+#include "call_stats.h"   /* call_stats_record() */
+#include "capture.h"      /* capture_call_begin() */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_max_nr_of_onus() */
+#include "module_mgmt.h"  /* mod_get_vendor_module_loaded() */
+#include "pon_stat.h"     /* pon_stat_get_fast_abi() */
+#include "utils_time.h"   /* time_get_monotonic_us() */
+#include "xpon_capture.h"
+#include "xpon_fast_abi.h"
 #include "xpon_trace.h"
 
 static const char* const MOD_PON_CTRL = "pon_ctrl";
 
-static const char* const SET_MAX_NR_OF_ONUS = "set_max_nr_of_onus";
-static const char* const SET_ENABLE = "set_enable";
-static const char* const GET_LIST_OF_INSTANCES = "get_list_of_instances";
-static const char* const GET_OBJECT_CONTENT = "get_object_content";
-static const char* const GET_PARAM_VALUES = "get_param_values";
-static const char* const HANDLE_FILE_DESCRIPTOR = "handle_file_descriptor";
-static const char* const SET_PASSWORD = "set_password";
+typedef enum _pon_ctrl_func_id {
+    func_set_max_nr_of_onus,
+    func_set_enable,
+    func_get_list_of_instances,
+    func_get_object_content,
+    func_get_object_tree,
+    func_get_param_values,
+    func_get_param_values_async,
+    func_handle_file_descriptor,
+    func_set_password,
+    func_nr
+} pon_ctrl_func_id_t;
 
-static int call_pon_ctrl_function_common(const char* const func_name,
-                                         amxc_var_t* args,
-                                         amxc_var_t* ret) {
+/**
+ * A function in the pon_ctrl namespace of the vendor module.
+ *
+ * - name       function name
+ * - mandatory  true if the vendor module must implement the function
+ * - available  true if the vendor module implements the function. Set by
+ *              resolve_functions().
+ * - fast       true if the vendor module provides the function via the fast
+ *              ABI. Set by resolve_functions().
+ * - stats      number of calls, errors and latency histogram. Exposed in
+ *              XPON.Diagnostics.
+ */
+typedef struct _pon_ctrl_func {
+    const char* const name;
+    const bool mandatory;
+    bool available;
+    bool fast;
+    call_stats_t stats;
+} pon_ctrl_func_t;
 
-    int rc = -1;
-    amxc_var_t* ret_dummy = NULL;
+/**
+ * Dispatch table with the functions in the pon_ctrl namespace.
+ *
+ * The element at index 'i' must have the function with id 'i'.
+ */
+static pon_ctrl_func_t s_funcs[func_nr] = {
+    [func_set_max_nr_of_onus] = { .name = "set_max_nr_of_onus", .mandatory = true },
+    [func_set_enable] = { .name = "set_enable", .mandatory = true },
+    [func_get_list_of_instances] = { .name = "get_list_of_instances", .mandatory = true },
+    [func_get_object_content] = { .name = "get_object_content", .mandatory = true },
+    [func_get_object_tree] = { .name = "get_object_tree", .mandatory = false },
+    [func_get_param_values] = { .name = "get_param_values", .mandatory = true },
+    [func_get_param_values_async] = { .name = "get_param_values_async", .mandatory = false },
+    [func_handle_file_descriptor] = { .name = "handle_file_descriptor", .mandatory = false },
+    [func_set_password] = { .name = "set_password", .mandatory = false }
+};
+
+/** pon_ctrl namespace of the vendor module. NULL if it's not resolved. */
+static amxm_module_t* s_module = NULL;
+/** Name of the vendor module */
+static const char* s_so_name = NULL;
+/** pon_ctrl table of the fast ABI. NULL if the vendor module has none. */
+static const xpon_pon_ctrl_v2_t* s_fast = NULL;
+
+#define HAS_FAST(fn) XPON_FAST_ABI_HAS(xpon_pon_ctrl_v2_t, s_fast, fn)
 
-    when_null_trace(args, exit, ERROR, "args is NULL");
+/**
+ * Call a function of the fast ABI and update the statistics of the function.
+ *
+ * Assigns the return value of the function to 'rc'.
+ */
+#define CALL_FAST(id, rc, fn, ...) do { \
+        const uint64_t start_us_ = time_get_monotonic_us(); \
+        rc = s_fast->fn(__VA_ARGS__); \
+        call_stats_record(&s_funcs[id].stats, start_us_, rc); \
+} while(0)
+
+/**
+ * Exchange the tables of the fast ABI with the vendor module if it supports
+ * that ABI. See xpon_fast_abi.h.
+ */
+static void resolve_fast_abi(amxm_shared_object_t* const so) {
 
-    const char* const so_name = mod_get_vendor_module_loaded(); /* shared_object_name */
-    when_null_trace(so_name, exit, ERROR, "No vendor module loaded");
+    if(capture_is_enabled()) {
+        SAH_TRACEZ_WARNING(ME, "Capturing calls: not using the fast ABI");
+        goto exit;
+    }
+    const xpon_fast_abi_get_t get =
+        (xpon_fast_abi_get_t) amxm_so_get_symbol(so, XPON_FAST_ABI_SYMBOL);
+    if(NULL == get) {
+        SAH_TRACEZ_INFO(ME, "%s does not support the fast ABI", s_so_name);
+        goto exit;
+    }
+    s_fast = get(pon_stat_get_fast_abi());
+    when_null_trace(s_fast, exit, WARNING, "%s rejected the fast ABI", s_so_name);
+    if(s_fast->version < XPON_FAST_ABI_VERSION) {
+        SAH_TRACEZ_ERROR(ME, "%s: invalid fast ABI version: %d", s_so_name,
+                         s_fast->version);
+        s_fast = NULL;
+        goto exit;
+    }
+    SAH_TRACEZ_INFO(ME, "%s supports the fast ABI v%d", s_so_name, s_fast->version);
+
+    s_funcs[func_set_enable].fast = HAS_FAST(set_enable);
+    s_funcs[func_get_param_values].fast = HAS_FAST(get_param_values);
+    s_funcs[func_get_param_values_async].fast = HAS_FAST(get_param_values_async);
+    s_funcs[func_handle_file_descriptor].fast = HAS_FAST(handle_file_descriptor);
+    s_funcs[func_set_password].fast = HAS_FAST(set_password);
+
+exit:
+    return;
+}
+
+/**
+ * Resolve the pon_ctrl namespace of the vendor module, and find out which
+ * functions the vendor module implements.
+ *
+ * This avoids looking up the vendor module and the namespace by name for each
+ * call. The function logs an error for each mandatory function the vendor
+ * module does not implement, and logs the optional ones it does not implement.
+ */
+static void resolve_functions(void) {
+
+    amxc_string_t missing;
+    amxc_string_init(&missing, 0);
+
+    s_so_name = mod_get_vendor_module_loaded();
+    when_null_trace(s_so_name, exit, ERROR, "No vendor module loaded");
+
+    amxm_shared_object_t* const so = amxm_get_so(s_so_name);
+    when_null_trace(so, exit, ERROR, "Failed to get %s", s_so_name);
+    resolve_fast_abi(so);
+    s_module = amxm_so_get_module(so, MOD_PON_CTRL);
+    if(NULL == s_module) {
+        SAH_TRACEZ_WARNING(ME, "%s has no %s namespace", s_so_name, MOD_PON_CTRL);
+    }
 
-    if(NULL == ret) {
-        if(amxc_var_new(&ret_dummy)) {
-            SAH_TRACEZ_ERROR(ME, "Failed to allocate memory");
-            goto exit;
+    for(int i = 0; i < func_nr; ++i) {
+        pon_ctrl_func_t* const func = &s_funcs[i];
+        func->available = func->fast ||
+            (s_module && amxm_module_has_function(s_module, func->name));
+        if(func->available) {
+            continue;
         }
+        if(func->mandatory) {
+            SAH_TRACEZ_ERROR(ME, "%s does not implement mandatory function %s.%s()",
+                             s_so_name, MOD_PON_CTRL, func->name);
+        } else {
+            amxc_string_appendf(&missing, "%s%s()",
+                                amxc_string_is_empty(&missing) ? "" : ", ", func->name);
+        }
+    }
+    if(!amxc_string_is_empty(&missing)) {
+        SAH_TRACEZ_INFO(ME, "%s does not implement optional function(s): %s",
+                        s_so_name, amxc_string_get(&missing, 0));
     }
 
-    rc = amxm_execute_function(so_name, MOD_PON_CTRL, func_name, args,
-                               ret ? ret : ret_dummy);
+exit:
+    amxc_string_clean(&missing);
+}
+
+static int call_pon_ctrl_function_common(pon_ctrl_func_id_t id,
+                                         amxc_var_t* args,
+                                         amxc_var_t* ret) {
+
+    int rc = -1;
+    pon_ctrl_func_t* const func = &s_funcs[id];
+    /* Return variant for callers which are not interested in it */
+    amxc_var_t ret_dummy;
+    amxc_var_init(&ret_dummy);
+
+    when_null_trace(args, exit, ERROR, "args is NULL");
+    when_null_trace(s_module, exit, ERROR, "No vendor module loaded");
+    when_false_trace(func->available, exit, ERROR, "%s does not implement %s.%s()",
+                     s_so_name, MOD_PON_CTRL, func->name);
+
+    capture_call_t call;
+    const bool captured = capture_call_begin(&call, XPON_CAPTURE_PON_CTRL, func->name, args);
+    const uint64_t start_us = time_get_monotonic_us();
+    rc = amxm_module_execute_function(s_module, func->name, args,
+                                      ret ? ret : &ret_dummy);
+    call_stats_record(&s_funcs[id].stats, start_us, rc);
+    if(captured) {
+        capture_call_end(&call, rc, ret ? ret : &ret_dummy);
+    }
     if(rc) {
-        SAH_TRACEZ_ERROR(ME, "%s.%s.%s() failed: rc=%d", so_name, MOD_PON_CTRL,
-                         func_name, rc);
+        SAH_TRACEZ_ERROR(ME, "%s.%s.%s() failed: rc=%d", s_so_name, MOD_PON_CTRL,
+                         func->name, rc);
     }
 
 exit:
-    if(ret_dummy != NULL) {
-        amxc_var_delete(&ret_dummy);
-    }
+    amxc_var_clean(&ret_dummy);
     return rc;
 }
 
-
 /**
- * Forward value of MAX_NR_OF_ONUS to the vendor module.
+ * Forward the max number of ONUs to the vendor module.
  */
 static void set_max_nr_of_onus(void) {
     amxc_var_t args;
     amxc_var_init(&args);
-    amxc_var_set(uint32_t, &args, MAX_NR_OF_ONUS);
+    amxc_var_set(uint32_t, &args, xpon_mngr_get_max_nr_of_onus());
 
-    if(call_pon_ctrl_function_common(SET_MAX_NR_OF_ONUS, &args, NULL)) {
+    if(call_pon_ctrl_function_common(func_set_max_nr_of_onus, &args, NULL)) {
         SAH_TRACEZ_ERROR(ME, "Failed to set max nr of ONUs");
     }
 
@@ -134,15 +287,37 @@ static void set_max_nr_of_onus(void) {
 /**
  * Initialize the pon_ctrl part of this plugin.
  *
- * The function forwards value of MAX_NR_OF_ONUS to the vendor module.
+ * The function resolves the functions in the pon_ctrl namespace of the vendor
+ * module, and forwards the max number of ONUs to the vendor module. See
+ * xpon_mngr_get_max_nr_of_onus().
  *
  * The plugin must call this function once at startup, after loading the vendor
  * module.
  */
 void pon_ctrl_init(void) {
+    for(int i = 0; i < func_nr; ++i) {
+        call_stats_register(call_stats_pon_ctrl, s_funcs[i].name, &s_funcs[i].stats);
+    }
+    resolve_functions();
     set_max_nr_of_onus();
 }
 
+/**
+ * Clean up the pon_ctrl part of this plugin.
+ *
+ * The plugin must call this function once when stopping, before it unloads
+ * the vendor module.
+ */
+void pon_ctrl_cleanup(void) {
+    s_module = NULL;
+    s_so_name = NULL;
+    s_fast = NULL;
+    for(int i = 0; i < func_nr; ++i) {
+        s_funcs[i].available = false;
+        s_funcs[i].fast = false;
+    }
+}
+
 /**
  * Let vendor module know that a read-write Enable field was changed.
  *
@@ -157,16 +332,27 @@ void pon_ctrl_set_enable(const char* const path, bool enable) {
 
     SAH_TRACEZ_DEBUG(ME, "path='%s' enable=%d", path, enable);
 
+    if(s_funcs[func_set_enable].fast) {
+        int rc;
+        CALL_FAST(func_set_enable, rc, set_enable, path, enable);
+        if(rc) {
+            SAH_TRACEZ_ERROR(ME, "path='%s' enable=%d: %s() failed",
+                             path, enable, s_funcs[func_set_enable].name);
+        }
+        goto exit;
+    }
+
     amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
 
     amxc_var_add_key(cstring_t, &args, "path", path);
     amxc_var_add_key(bool, &args, "enable", enable);
 
-    if(call_pon_ctrl_function_common(SET_ENABLE, &args, NULL)) {
+    if(call_pon_ctrl_function_common(func_set_enable, &args, NULL)) {
         SAH_TRACEZ_ERROR(ME, "path='%s' enable=%d: %s() failed",
-                         path, enable, SET_ENABLE);
+                         path, enable, s_funcs[func_set_enable].name);
     }
 
+exit:
     amxc_var_clean(&args);
 }
 
@@ -191,7 +377,7 @@ int pon_ctrl_get_list_of_instances(const char* const path, amxc_var_t* ret) {
     amxc_var_set(cstring_t, &args, path);
 
     const int rc =
-        call_pon_ctrl_function_common(GET_LIST_OF_INSTANCES, &args, ret);
+        call_pon_ctrl_function_common(func_get_list_of_instances, &args, ret);
 
     amxc_var_clean(&args);
     return rc;
@@ -224,7 +410,55 @@ int pon_ctrl_get_object_content(const char* const path, uint32_t index, amxc_var
         amxc_var_add_key(uint32_t, &args, "index", index);
     }
 
-    const int rc = call_pon_ctrl_function_common(GET_OBJECT_CONTENT, &args, ret);
+    const int rc = call_pon_ctrl_function_common(func_get_object_content, &args, ret);
+
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Return true if the vendor module implements get_object_tree().
+ */
+bool pon_ctrl_has_get_object_tree(void) {
+    return s_funcs[func_get_object_tree].available;
+}
+
+/**
+ * Ask vendor module for the content of an object and of all its descendants.
+ *
+ * @param[in] path     object path. This can be a singleton or template object.
+ * @param[in] index    instance index when querying an instance and its
+ *                     descendants. Must be 0 when querying a singleton.
+ * @param[in,out] ret  function returns result via this parameter. See below for
+ *                     more info.
+ *
+ * The param @a ret should be an htable with the same keys as the one returned
+ * by pon_ctrl_get_object_content(), and additionally the key:
+ * - 'children': htable with an element per child of the object which exists.
+ *               The key is the name of the child relative to the object, e.g.
+ *               "TC.ONUActivation" or "Transceiver". For a singleton, the
+ *               value has the same format as @a ret. For a template, the value
+ *               is an htable with the key 'instances': a list with an element
+ *               per instance. Such an element has the same format as @a ret,
+ *               and additionally the key 'index'.
+ *
+ * The vendor module does not need to implement this function. See
+ * pon_ctrl_has_get_object_tree().
+ *
+ * @return 0 on success, -1 upon error
+ */
+int pon_ctrl_get_object_tree(const char* const path, uint32_t index, amxc_var_t* ret) {
+
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", path);
+    if(index) {
+        amxc_var_add_key(uint32_t, &args, "index", index);
+    }
+
+    const int rc = call_pon_ctrl_function_common(func_get_object_tree, &args, ret);
 
     amxc_var_clean(&args);
     return rc;
@@ -249,15 +483,72 @@ int pon_ctrl_get_param_values(const char* const path,
                               const char* const names,
                               amxc_var_t* ret) {
 
+    int rc = -1;
     amxc_var_t args;
     amxc_var_init(&args);
 
+    SAH_TRACEZ_DEBUG(ME, "path='%s' names='%s'", path, names);
+
+    if(s_funcs[func_get_param_values].fast) {
+        when_null_trace(ret, exit, ERROR, "ret is NULL");
+        amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+        amxc_var_t* const parameters =
+            amxc_var_add_key(amxc_htable_t, ret, "parameters", NULL);
+        CALL_FAST(func_get_param_values, rc, get_param_values, path, names, parameters);
+        goto exit;
+    }
+
     amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
     amxc_var_add_key(cstring_t, &args, "path", path);
     amxc_var_add_key(cstring_t, &args, "names", names);
 
+    rc = call_pon_ctrl_function_common(func_get_param_values, &args, ret);
+
+exit:
+    amxc_var_clean(&args);
+    return rc;
+}
+
+/**
+ * Return true if the vendor module implements get_param_values_async().
+ */
+bool pon_ctrl_has_get_param_values_async(void) {
+    return s_funcs[func_get_param_values_async].available;
+}
+
+/**
+ * Ask vendor module to start querying the values of one or more parameters.
+ *
+ * @param[in] path     object path of a singleton or an instance
+ * @param[in] names    parameter names formatted as a comma-separated list
+ *
+ * Unlike pon_ctrl_get_param_values(), the vendor module must return
+ * immediately. When it has the values, it must call the pon_stat function
+ * param_values_ready() with the keys 'path' and 'parameters'.
+ *
+ * The vendor module does not need to implement this function. See
+ * pon_ctrl_has_get_param_values_async().
+ *
+ * @return 0 if the vendor module started the query, -1 upon error
+ */
+int pon_ctrl_get_param_values_async(const char* const path,
+                                    const char* const names) {
+
     SAH_TRACEZ_DEBUG(ME, "path='%s' names='%s'", path, names);
-    const int rc = call_pon_ctrl_function_common(GET_PARAM_VALUES, &args, ret);
+    if(s_funcs[func_get_param_values_async].fast) {
+        int rc;
+        CALL_FAST(func_get_param_values_async, rc, get_param_values_async, path, names);
+        return rc;
+    }
+
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", path);
+    amxc_var_add_key(cstring_t, &args, "names", names);
+
+    const int rc = call_pon_ctrl_function_common(func_get_param_values_async, &args, NULL);
 
     amxc_var_clean(&args);
     return rc;
@@ -276,10 +567,16 @@ int pon_ctrl_get_param_values(const char* const path,
  */
 void pon_ctrl_handle_file_descriptor(int fd) {
 
+    if(s_funcs[func_handle_file_descriptor].fast) {
+        int rc;
+        CALL_FAST(func_handle_file_descriptor, rc, handle_file_descriptor, fd);
+        return;
+    }
+
     amxc_var_t var;
     amxc_var_init(&var);
     amxc_var_set(fd_t, &var, fd);
-    call_pon_ctrl_function_common(HANDLE_FILE_DESCRIPTOR, &var, NULL);
+    call_pon_ctrl_function_common(func_handle_file_descriptor, &var, NULL);
     amxc_var_clean(&var);
 }
 
@@ -295,6 +592,14 @@ void pon_ctrl_handle_file_descriptor(int fd) {
 void pon_ctrl_set_password(const char* const ani_path,
                            const char* const password,
                            bool hex) {
+
+    SAH_TRACEZ_DEBUG(ME, "ani_path='%s' password='%s' hex=%d", ani_path, password, hex);
+    if(s_funcs[func_set_password].fast) {
+        int rc;
+        CALL_FAST(func_set_password, rc, set_password, ani_path, password, hex);
+        return;
+    }
+
     amxc_var_t args;
     amxc_var_init(&args);
 
@@ -303,8 +608,7 @@ void pon_ctrl_set_password(const char* const ani_path,
     amxc_var_add_key(cstring_t, &args, "password", password);
     amxc_var_add_key(bool, &args, "is_hexadecimal_password", hex);
 
-    SAH_TRACEZ_DEBUG(ME, "ani_path='%s' password='%s' hex=%d", ani_path, password, hex);
-    call_pon_ctrl_function_common(SET_PASSWORD, &args, NULL);
+    call_pon_ctrl_function_common(func_set_password, &args, NULL);
     amxc_var_clean(&args);
 }
 
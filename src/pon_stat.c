@@ -77,9 +77,15 @@
 #include <amxo/amxo.h>    /* amxo_connection_add() */
 
 /* Own headers */
-#include "data_model.h"   /* dm_add_instance() */
-#include "dm_xpon_mngr.h" /* xpon_mngr_get_parser() */
-#include "pon_ctrl.h"     /* handle_file_descriptor() */
+#include "ani_pm.h"              /* ani_pm_update() */
+#include "data_model.h"          /* dm_add_instance() */
+#include "dm_coalesce.h"         /* dm_coalesce_change_object() */
+#include "dm_xpon_mngr.h"        /* xpon_mngr_get_parser() */
+#include "module_mgmt.h"         /* mod_get_pon_stat_stats() */
+#include "pon_ctrl.h"            /* handle_file_descriptor() */
+#include "populate_dm_startup.h" /* pplt_dm_onu_list_changed() */
+#include "trx_cache.h"           /* trx_cache_values_ready() */
+#include "utils_time.h"          /* time_get_monotonic_us() */
 #include "xpon_trace.h"
 
 
@@ -120,6 +126,10 @@ int dm_instance_removed(UNUSED const char* function_name,
  *
  * @param[in] args : must be htable with the keys 'path' and 'parameters'
  *
+ * If the write-behind buffer is enabled for the object type, the update is
+ * merged into the buffer instead of being applied immediately. See
+ * dm_coalesce.c.
+ *
  * @return 0 on success, else -1.
  */
 int dm_object_changed(UNUSED const char* function_name,
@@ -127,6 +137,9 @@ int dm_object_changed(UNUSED const char* function_name,
                       UNUSED amxc_var_t* ret) {
 
     SAH_TRACEZ_INFO(ME, "called");
+    if(dm_coalesce_change_object(args)) {
+        return 0;
+    }
     return dm_change_object(args);
 }
 
@@ -170,6 +183,53 @@ int dm_add_or_change_instance(UNUSED const char* function_name,
     return dm_add_or_change_instance_impl(args);
 }
 
+/**
+ * Apply an ordered list of create, remove and change operations.
+ *
+ * @param[in] args : must be htable with the key 'operations'. Its value must
+ *                   be a list. Each element in the list must be an htable
+ *                   with the key 'action' and the arguments for that action.
+ *                   The value of 'action' must be one of:
+ *                   - "add": same arguments as dm_instance_added()
+ *                   - "remove": same arguments as dm_instance_removed()
+ *                   - "change": same arguments as dm_object_changed()
+ *                   - "add_or_change": same arguments as
+ *                     dm_add_or_change_instance()
+ * @param[in,out] ret : the function returns a list with one integer per
+ *                   operation via this parameter: 0 if the operation
+ *                   succeeded, else -1.
+ *
+ * The vendor module can use this function instead of calling the functions
+ * above one by one, e.g. when it discovers an ONU with its ANI, UNIs and GEM
+ * ports. This component then groups the operations in as few DM transactions
+ * as possible.
+ *
+ * @return 0 if all operations succeeded, else -1.
+ */
+int dm_apply_batch(UNUSED const char* function_name,
+                   amxc_var_t* args,
+                   amxc_var_t* ret) {
+    SAH_TRACEZ_INFO(ME, "called");
+    return dm_apply_batch_impl(args, ret);
+}
+
+/**
+ * Update the PM counters of an ANI.
+ *
+ * @param[in] args : must be of type AMXC_VAR_ID_UINT64. Its value must be the
+ *                   address of a pon_stat_ani_pm_t. See pon_stat_ani_pm.h.
+ *
+ * This is a faster alternative for dm_object_changed() to update the objects
+ * TC.PM.PHY, TC.PM.GEM, TC.PM.PLOAM and TC.PM.OMCI of an ANI.
+ *
+ * @return 0 on success, else -1.
+ */
+int dm_update_ani_pm(UNUSED const char* function_name,
+                     amxc_var_t* args,
+                     UNUSED amxc_var_t* ret) {
+    return ani_pm_update(args);
+}
+
 /**
  * Notify plugin an OMCI reset MIB message was received for an ONU.
  *
@@ -201,14 +261,29 @@ exit:
 static int watch_file_descriptor_common(amxc_var_t* args,
                                         bool start) {
     int rc = -1;
-    amxo_parser_t* const parser = xpon_mngr_get_parser();
-    when_null(parser, exit);
     when_null(args, exit);
 
     const uint32_t type = amxc_var_type_of(args);
     when_false_trace(type == AMXC_VAR_ID_FD, exit, ERROR,
                      "Type of 'args' = %d != FD", type);
-    const int fd = amxc_var_constcast(fd_t, args);
+    rc = pon_stat_watch_fd(amxc_var_constcast(fd_t, args), start);
+
+exit:
+    return rc;
+}
+
+/**
+ * Start or stop monitoring a file descriptor.
+ *
+ * @param[in] fd: the file descriptor
+ * @param[in] start: true to start monitoring @a fd, false to stop
+ *
+ * @return 0 on success, else -1.
+ */
+int pon_stat_watch_fd(int fd, bool start) {
+    int rc = -1;
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
     when_false_trace(fd > 0, exit, ERROR, "Invalid fd [%d]", fd);
 
     if(start) {
@@ -267,6 +342,40 @@ int watch_file_descriptor_stop(UNUSED const char* function_name,
     return watch_file_descriptor_common(args, /*start=*/ false);
 }
 
+/**
+ * Pass the result of an earlier get_param_values_async() call.
+ *
+ * @param[in] args: must be htable with the keys 'path' and 'parameters'. The
+ *                  'path' must be the path passed to get_param_values_async().
+ *
+ * @return 0 on success, else -1.
+ */
+int param_values_ready(UNUSED const char* function_name,
+                       amxc_var_t* args,
+                       UNUSED amxc_var_t* ret) {
+
+    SAH_TRACEZ_INFO(ME, "called");
+    return trx_cache_values_ready(args);
+}
+
+/**
+ * Notify the plugin that the list of ONUs changed.
+ *
+ * @param[in] args: htable, possibly empty. It may have the key 'nr_of_onus'
+ *                  with the final number of ONUs the vendor module will report.
+ *
+ * The plugin queries the ONU instances at once.
+ *
+ * @return 0 on success, else -1.
+ */
+int onu_list_changed(UNUSED const char* function_name,
+                     amxc_var_t* args,
+                     UNUSED amxc_var_t* ret) {
+
+    SAH_TRACEZ_INFO(ME, "called");
+    return pplt_dm_onu_list_changed(args);
+}
+
 /**
  * Update a parameter of the XPON object.
  *
@@ -282,3 +391,93 @@ int dm_set_xpon_parameter(UNUSED const char* function_name,
     return dm_set_xpon_parameter_impl(args);
 }
 
+
+static int fast_dm_object_changed(const char* path, uint32_t index,
+                                  const amxc_var_t* parameters) {
+    if(dm_coalesce_change_object_params(path, index, parameters)) {
+        return 0;
+    }
+    return dm_change_object_params(path, index, parameters);
+}
+
+static int fast_watch_file_descriptor_start(int fd) {
+    return pon_stat_watch_fd(fd, /*start=*/ true);
+}
+
+static int fast_watch_file_descriptor_stop(int fd) {
+    return pon_stat_watch_fd(fd, /*start=*/ false);
+}
+
+/**
+ * Define a wrapper around the fast ABI function 'impl' which updates the
+ * statistics of the pon_stat function 'fn'. Calls via both ABIs are recorded
+ * in the same statistics. See INSTRUMENTED_PON_STAT_FUNCTION in module_mgmt.c.
+ *
+ * The fast ABI is not used while capturing: the wrapper does not capture.
+ */
+#define INSTRUMENTED_FAST_FUNCTION(fn, impl, params, args) \
+    static int instrumented_ ## fn params { \
+        static call_stats_t* stats = NULL; \
+        if(NULL == stats) { \
+            stats = mod_get_pon_stat_stats(#fn); \
+        } \
+        const uint64_t start_us = time_get_monotonic_us(); \
+        const int rc = impl args; \
+        if(stats) { \
+            call_stats_record(stats, start_us, rc); \
+        } \
+        return rc; \
+    }
+
+INSTRUMENTED_FAST_FUNCTION(dm_instance_removed, dm_remove_instance_at,
+                           (const char* path, uint32_t index), (path, index))
+INSTRUMENTED_FAST_FUNCTION(dm_object_changed, fast_dm_object_changed,
+                           (const char* path, uint32_t index, const amxc_var_t* parameters),
+                           (path, index, parameters))
+INSTRUMENTED_FAST_FUNCTION(dm_update_ani_pm, ani_pm_update_counters,
+                           (const pon_stat_ani_pm_t* pm), (pm))
+INSTRUMENTED_FAST_FUNCTION(omci_reset_mib, dm_omci_reset_mib_onu,
+                           (uint32_t index), (index))
+INSTRUMENTED_FAST_FUNCTION(watch_file_descriptor_start, fast_watch_file_descriptor_start,
+                           (int fd), (fd))
+INSTRUMENTED_FAST_FUNCTION(watch_file_descriptor_stop, fast_watch_file_descriptor_stop,
+                           (int fd), (fd))
+INSTRUMENTED_FAST_FUNCTION(onu_list_changed, pplt_dm_onu_list_changed_n,
+                           (uint32_t nr_of_onus), (nr_of_onus))
+INSTRUMENTED_FAST_FUNCTION(dm_instance_added, dm_add_instance,
+                           (const amxc_var_t* args), (args))
+INSTRUMENTED_FAST_FUNCTION(dm_add_or_change_instance, dm_add_or_change_instance_impl,
+                           (const amxc_var_t* args), (args))
+INSTRUMENTED_FAST_FUNCTION(dm_apply_batch, dm_apply_batch_impl,
+                           (const amxc_var_t* args, amxc_var_t* ret), (args, ret))
+INSTRUMENTED_FAST_FUNCTION(param_values_ready, trx_cache_values_ready,
+                           (const amxc_var_t* args), (args))
+
+/**
+ * pon_stat table of the fast ABI. See xpon_fast_abi.h.
+ *
+ * Each function does the same as the function with the same name above, but
+ * without the call via libamxm.
+ */
+static const xpon_pon_stat_v2_t PON_STAT_V2 = {
+    .version = XPON_FAST_ABI_VERSION,
+    .size = sizeof(xpon_pon_stat_v2_t),
+    .dm_instance_removed = instrumented_dm_instance_removed,
+    .dm_object_changed = instrumented_dm_object_changed,
+    .dm_update_ani_pm = instrumented_dm_update_ani_pm,
+    .omci_reset_mib = instrumented_omci_reset_mib,
+    .watch_file_descriptor_start = instrumented_watch_file_descriptor_start,
+    .watch_file_descriptor_stop = instrumented_watch_file_descriptor_stop,
+    .onu_list_changed = instrumented_onu_list_changed,
+    .dm_instance_added = instrumented_dm_instance_added,
+    .dm_add_or_change_instance = instrumented_dm_add_or_change_instance,
+    .dm_apply_batch = instrumented_dm_apply_batch,
+    .param_values_ready = instrumented_param_values_ready
+};
+
+/**
+ * Return the pon_stat table of the fast ABI.
+ */
+const xpon_pon_stat_v2_t* pon_stat_get_fast_abi(void) {
+    return &PON_STAT_V2;
+}
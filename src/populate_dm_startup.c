@@ -64,22 +64,53 @@
 #include "populate_dm_startup.h"
 
 /* System headers */
-#include <stdio.h>  /* snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strlen() */
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>    /* snprintf() */
+#include <stdlib.h>   /* free(), strtoul() */
+#include <string.h>   /* strlen() */
 
 /* Other libraries' headers */
 #include <amxc/amxc_macros.h>
 #include <amxc/amxc.h>
 #include <amxp/amxp_timer.h>
+#include <amxo/amxo.h> /* amxo_parser_t */
 
 /* Own headers */
 #include "data_model.h"
 #include "dm_info.h"
+#include "dm_snapshot.h"        /* dm_snapshot_confirm() */
+#include "dm_xpon_mngr.h"       /* xpon_mngr_get_max_nr_of_onus() */
 #include "pon_ctrl.h"
+#include "utils_bitmap.h"       /* bitmap_t */
+#include "utils_time.h"         /* time_get_monotonic_ms() */
 #include "xpon_mgr_constants.h" /* SHORT_TIMEOUT_MS */
 #include "xpon_trace.h"
 
+/**
+ * Task priority.
+ *
+ * The plugin handles all tasks with a higher priority before any task with a
+ * lower priority, such that the objects which matter for connectivity appear
+ * first in the DM:
+ * - task_prio_high: ONU, ANI and ONUActivation
+ * - task_prio_normal: all other objects, e.g., EthernetUNI
+ * - task_prio_low: Transceiver, GEM ports, software images and the PM objects
+ *
+ * The order between an object and its children is not affected: the plugin
+ * only creates the tasks for the children when it handles the task for the
+ * object.
+ */
+typedef enum _task_priority {
+    task_prio_high,
+    task_prio_normal,
+    task_prio_low,
+    task_prio_nr
+} task_priority_t;
+
+/* Max number of tasks kept in 's_task_pool' */
+#define TASK_POOL_MAX_SIZE 64
+#define TASK_PATH_LEN 256
+
 /* Timer to query for the existence of ONUs */
 static amxp_timer_t* s_timer_query_onus = NULL;
 /**
@@ -87,22 +118,77 @@ static amxp_timer_t* s_timer_query_onus = NULL;
  * since startup.
  */
 static uint32_t s_cntr_query_onus = 0;
+/* Sum of the intervals of s_timer_query_onus so far */
+static uint32_t s_query_onus_elapsed_ms = 0;
+/* Current interval of s_timer_query_onus */
+static uint32_t s_query_onus_interval_ms = 0;
+/**
+ * Number of ONUs the vendor module declared it will report via
+ * onu_list_changed(). 0 if it did not declare it.
+ */
+static uint32_t s_final_nr_of_onus = 0;
+/* True if the plugin stopped polling for ONU instances */
+static bool s_polling_done = false;
 
-/* List of tasks of type task_type_t. */
-static amxc_llist_t s_tasks = { 0 };
+/**
+ * Queue with tasks of type task_t: one list per priority. See task_priority_t.
+ */
+static amxc_llist_t s_tasks[task_prio_nr];
+/**
+ * Index of the tasks in 's_tasks' to avoid queuing the same task twice. The
+ * key is built by task_key().
+ */
+static amxc_htable_t s_task_index;
+/* Tasks which are not in use, to avoid an allocation per task */
+static amxc_llist_t s_task_pool;
+static uint32_t s_task_pool_size = 0;
 /* Timer to handle tasks in 's_tasks' */
 static amxp_timer_t* s_timer_handle_tasks = NULL;
-/* List of ONU's to indicate they are initialised */
-static bool s_onu_initialised[MAX_NR_OF_ONUS] = { 0 };
+/* Max number of ONUs. See xpon_mngr_get_max_nr_of_onus(). */
+static uint32_t s_max_nr_of_onus = 0;
+/* Bit 'i' is set if XPON.ONU.{i+1} is initialised */
+static bitmap_t s_onu_initialised = { 0 };
+/**
+ * Bit 'i' is set if the plugin handled a task for XPON.ONU.{i+1} since
+ * s_tasks was empty the last time. See remove_stale_instances().
+ */
+static bitmap_t s_onu_tasks_handled = { 0 };
+/* True if the plugin removed the stale instances of all ONUs */
+static bool s_all_stale_removed = false;
+
+/**
+ * Config option with the max time in ms handle_task() may spend on handling
+ * tasks before it yields to the event loop.
+ */
+#define TASK_SLICE_CONFIG "pplt_task_slice_ms"
+#define TASK_SLICE_DEFAULT_MS 5
+
+/**
+ * Timeout in ms to restart the timer to handle the remaining tasks after a
+ * slice. It only serves to yield to the event loop. See SHORT_TIMEOUT_MS why
+ * it's not 0.
+ */
+#define TASK_YIELD_MS 1
+
+static uint32_t s_task_slice_ms = TASK_SLICE_DEFAULT_MS;
+/* Time in ms of the monotonic clock when the 1st task started. 0 if none. */
+static uint64_t s_first_task_ms = 0;
+/* Number of tasks handled since startup */
+static uint32_t s_nr_of_tasks_handled = 0;
+/* True if the startup population is complete. See report_population_time(). */
+static bool s_population_done = false;
 
 
 /**
- * Query ONU instances every 10 s during the first 5 minutes after startup.
+ * Poll for ONU instances during the first 5 minutes after startup, with an
+ * interval which starts at 1 s and doubles after each poll, up to 60 s.
  *
- * 30 intervals of 10 s corresponds to 5 minutes.
+ * The vendor module can call onu_list_changed() to trigger a query at once.
+ * Polling is only a fallback for vendor modules which don't.
  */
-#define QUERY_ONUS_INTERVAL_MS 10000
-#define QUERY_ONUS_NR_TIMES 30
+#define QUERY_ONUS_INITIAL_INTERVAL_MS 1000
+#define QUERY_ONUS_MAX_INTERVAL_MS 60000
+#define QUERY_ONUS_PERIOD_MS (5 * 60 * 1000)
 
 /**
  * Task type.
@@ -129,7 +215,8 @@ typedef enum _task_type {
  * - path   object path, e.g. "XPON.ONU"
  * - index  index instance for a template object. 0 if not applicable.
  * - type   task type. See task_type_t.
- * - it     to put a task in the list 's_tasks'
+ * - it     to put a task in a list of 's_tasks', or in 's_task_pool'
+ * - hit    to put a task in 's_task_index'
  *
  * If 'path' refers to a template object, then:
  * - 'index' is 0 (not applicable) if 'type' is 'task_query_indexes': the task
@@ -138,10 +225,11 @@ typedef enum _task_type {
  * - 'index' is an actual instance index if type is 'task_query_content'.
  */
 typedef struct _task {
-    amxc_string_t path;
+    char path[TASK_PATH_LEN];
     uint32_t index;
     task_type_t type;
     amxc_llist_it_t it;
+    amxc_htable_it_t hit;
 } task_t;
 
 static const char* task_type_to_string(task_type_t type) {
@@ -155,37 +243,112 @@ static const char* task_type_to_string(task_type_t type) {
 
 static void task_init(task_t* const task, const char* const path,
                       uint32_t index, task_type_t type) {
-    amxc_string_init(&task->path, 0);
-    amxc_string_set(&task->path, path);
+    snprintf(task->path, TASK_PATH_LEN, "%s", path);
     task->index = index;
     task->type = type;
 }
 
-static void task_clean(task_t* const task) {
-    amxc_string_clean(&task->path);
+static task_priority_t task_priority(const char* const path) {
+
+    switch(dm_get_object_id(path)) {
+    case obj_id_onu:
+    case obj_id_ani:
+    case obj_id_ani_tc_onu_activation:
+        return task_prio_high;
+    case obj_id_software_image:
+    case obj_id_gem_port:
+    case obj_id_transceiver:
+    case obj_id_ani_tc_pm_phy:
+    case obj_id_ani_tc_pm_gem:
+    case obj_id_ani_tc_pm_ploam:
+    case obj_id_ani_tc_pm_omci:
+    case obj_id_gem_port_pm:
+        return task_prio_low;
+    default:
+        break;
+    }
+    return task_prio_normal;
+}
+
+static void task_key(char* const key, const char* const path, uint32_t index,
+                     task_type_t type) {
+    snprintf(key, TASK_PATH_LEN + 16, "%d:%s:%u", type, path, index);
+}
+
+/**
+ * Take a task from 's_task_pool', or allocate one if the pool is empty.
+ *
+ * @return the task on success, else NULL
+ */
+static task_t* task_alloc(void) {
+
+    task_t* task = NULL;
+    amxc_llist_it_t* const it = amxc_llist_take_first(&s_task_pool);
+    if(it) {
+        --s_task_pool_size;
+        task = amxc_container_of(it, task_t, it);
+    } else {
+        task = (task_t*) calloc(1, sizeof(task_t));
+        when_null_trace(task, exit, ERROR, "Failed to allocate memory for task_t");
+        amxc_llist_it_init(&task->it);
+        amxc_htable_it_init(&task->hit);
+    }
+
+exit:
+    return task;
+}
+
+/**
+ * Remove a task from the queue and the index, and put it back in the pool.
+ */
+static void task_release(task_t* const task) {
+
+    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d type=%s", task->path, task->index,
+                     task_type_to_string(task->type));
+    amxc_htable_it_clean(&task->hit, NULL);
+    amxc_llist_it_take(&task->it);
+    if(s_task_pool_size < TASK_POOL_MAX_SIZE) {
+        amxc_llist_append(&s_task_pool, &task->it);
+        ++s_task_pool_size;
+    } else {
+        free(task);
+    }
 }
 
 /**
- * Create task and append it to 's_tasks'.
+ * Create task and add it to 's_tasks'.
+ *
+ * If the same task is already queued, the function does not add it again.
  *
  * If it fails to create the task or to append the task to 's_tasks', the
  * function is a no-op.
  *
- * @return task created on success, else NULL
+ * @return task created or already queued on success, else NULL
  */
 static task_t* task_create(const char* const path, uint32_t index, task_type_t type) {
 
-    task_t* task = (task_t*) calloc(1, sizeof(task_t));
-    when_null_trace(task, exit, ERROR, "Failed to allocate memory for task_t");
+    char key[TASK_PATH_LEN + 16];
+    task_t* task = NULL;
+
+    task_key(key, path, index, type);
+    amxc_htable_it_t* const hit = amxc_htable_get(&s_task_index, key);
+    if(hit) {
+        SAH_TRACEZ_DEBUG(ME, "Task %s already queued", key);
+        task = amxc_container_of(hit, task_t, hit);
+        goto exit;
+    }
+
+    task = task_alloc();
+    when_null(task, exit);
 
     task_init(task, path, index, type);
 
-    if(amxc_llist_append(&s_tasks, &task->it)) {
-        SAH_TRACEZ_ERROR(ME, "Failed to append task to 's_tasks'");
+    if(amxc_llist_append(&s_tasks[task_priority(path)], &task->it) ||
+       amxc_htable_insert(&s_task_index, key, &task->hit)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to add task to 's_tasks'");
         SAH_TRACEZ_ERROR(ME, "  path='%s' index=%d type=%s", path, index,
                          task_type_to_string(type));
-        task_clean(task);
-        free(task);
+        task_release(task);
         task = NULL;
     }
 
@@ -193,12 +356,13 @@ exit:
     return task;
 }
 
-static void task_delete(amxc_llist_it_t* hit) {
-    task_t* task = amxc_container_of(hit, task_t, it);
-    const char* path = amxc_string_get(&task->path, 0);
-    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d type=%s", path, task->index,
-                     task_type_to_string(task->type));
-    task_clean(task);
+static bool tasks_is_empty(void) {
+    return amxc_htable_is_empty(&s_task_index);
+}
+
+static void task_delete(amxc_llist_it_t* it) {
+    task_t* task = amxc_container_of(it, task_t, it);
+    amxc_htable_it_clean(&task->hit, NULL);
     free(task);
 }
 
@@ -333,6 +497,215 @@ exit_no_cleanup:
     return;
 }
 
+/**
+ * Return true if all ONU instances the plugin expects are initialised.
+ *
+ * The plugin expects the number of ONUs the vendor module declared via
+ * onu_list_changed(). If it did not declare any, it expects the max number of
+ * ONUs.
+ */
+static bool all_onus_initialised(void) {
+
+    const uint32_t expected = s_final_nr_of_onus ? s_final_nr_of_onus : s_max_nr_of_onus;
+    return bitmap_count(&s_onu_initialised) >= expected;
+}
+
+/**
+ * Return the index of the ONU instance a task is for, or 0 if the task is not
+ * for a specific ONU instance, e.g., the task querying the indexes of XPON.ONU.
+ */
+static uint32_t task_onu_index(const task_t* const task) {
+
+    static const char prefix[] = "XPON.ONU";
+    const size_t len = sizeof(prefix) - 1;
+    uint32_t index = 0;
+
+    when_false(strncmp(task->path, prefix, len) == 0, exit);
+    if(task->path[len] == '\0') {
+        index = task->index;
+    } else if(task->path[len] == '.') {
+        index = (uint32_t) strtoul(task->path + len + 1, NULL, 10);
+    }
+
+exit:
+    return index;
+}
+
+/**
+ * Remove the instances loaded from the DM snapshot which the vendor module did
+ * not confirm.
+ *
+ * The function must only be called when there are no tasks. It only removes
+ * the stale instances of the ONUs which are initialised, and for which the
+ * plugin handled tasks since the previous call: the other ONUs were not
+ * queried in the meantime. Once polling stopped, it removes all stale
+ * instances once: the vendor module does not have the ONUs which are not
+ * initialised by then.
+ *
+ * If the vendor module failed to report the instances or the content of an
+ * object, the plugin confirmed the stale instances under that object. See
+ * dm_snapshot_confirm_subtree(). Hence the function only removes the stale
+ * instances the vendor module did not return in a list it did return.
+ */
+static void remove_stale_instances(void) {
+    if(s_polling_done && !s_all_stale_removed) {
+        dm_snapshot_remove_stale(/*onu_index=*/ 0);
+        s_all_stale_removed = true;
+    }
+    for(uint32_t i = bitmap_next_set(&s_onu_tasks_handled, 0); i < s_max_nr_of_onus;
+        i = bitmap_next_set(&s_onu_tasks_handled, i + 1)) {
+        bitmap_clear(&s_onu_tasks_handled, i);
+        if(bitmap_is_set(&s_onu_initialised, i)) {
+            dm_snapshot_remove_stale(i + 1);
+        }
+    }
+}
+
+static void polling_done(void) {
+    s_polling_done = true;
+    if(tasks_is_empty()) {
+        remove_stale_instances();
+        s_population_done = true;
+    }
+}
+
+/**
+ * Mark an ONU instance as initialised.
+ *
+ * The function stops polling for ONU instances if all expected ONU instances
+ * are initialised.
+ */
+static void set_onu_initialised(uint32_t index) {
+    if((index != 0) && (index <= s_max_nr_of_onus)) {
+        SAH_TRACEZ_INFO(ME, "XPON.ONU.%d is initialised", index);
+        bitmap_set(&s_onu_initialised, index - 1);
+    } else {
+        SAH_TRACEZ_ERROR(ME, "XPON.ONU: invalid index: %d: not in [1, %d]",
+                         index, s_max_nr_of_onus);
+    }
+    if(all_onus_initialised() && s_timer_query_onus) {
+        SAH_TRACEZ_INFO(ME, "All ONUs found and initialised: stop polling");
+        amxp_timer_stop(s_timer_query_onus);
+        polling_done();
+    }
+}
+
+/**
+ * Convert a (sub)tree returned by get_object_tree() to batch operations.
+ *
+ * @param[in] path      object path of a singleton or template object
+ * @param[in] index     instance index for a template object. 0 (not applicable)
+ *                      for a singleton.
+ * @param[in] node      content of the object: htable with the keys
+ *                      'parameters', 'keys' and 'children'. See
+ *                      pon_ctrl_get_object_tree().
+ * @param[in,out] ops   list to which the function appends the operations in
+ *                      the format expected by dm_apply_batch_impl()
+ *
+ * The function appends an 'add_or_change' operation for an instance, or a
+ * 'change' operation for a singleton. It then handles the children of the
+ * object, depth first. So an instance is always created before its children.
+ */
+static void tree_to_operations(const char* const path, uint32_t index,
+                               const amxc_var_t* const node, amxc_var_t* const ops) {
+
+    char child_path[256];
+    amxc_var_t* const keys = GET_ARG(node, "keys");
+    amxc_var_t* const params = GET_ARG(node, "parameters");
+    const amxc_var_t* const children = GET_ARG(node, "children");
+
+    if(index || params) {
+        amxc_var_t* const op = amxc_var_add(amxc_htable_t, ops, NULL);
+        amxc_var_add_key(cstring_t, op, "action", index ? "add_or_change" : "change");
+        amxc_var_add_key(cstring_t, op, "path", path);
+        if(index) {
+            amxc_var_add_key(uint32_t, op, "index", index);
+            dm_snapshot_confirm(path, index);
+        }
+        if(keys) {
+            amxc_var_set_key(op, "keys", keys, AMXC_VAR_FLAG_COPY);
+        }
+        if(params) {
+            amxc_var_set_key(op, "parameters", params, AMXC_VAR_FLAG_COPY);
+        } else {
+            amxc_var_add_key(amxc_htable_t, op, "parameters", NULL);
+        }
+    }
+    when_null(children, exit);
+
+    amxc_var_for_each(child, children) {
+        const char* const name = amxc_var_key(child);
+        if(index) {
+            snprintf(child_path, 256, "%s.%d.%s", path, index, name);
+        } else {
+            snprintf(child_path, 256, "%s.%s", path, name);
+        }
+        const amxc_var_t* const instances = GET_ARG(child, "instances");
+        if(NULL == instances) {
+            tree_to_operations(child_path, 0, child, ops);
+            continue;
+        }
+        amxc_var_for_each(instance, instances) {
+            const uint32_t child_index = GET_UINT32(instance, "index");
+            if(0 == child_index) {
+                SAH_TRACEZ_ERROR(ME, "%s: instance without index", child_path);
+                continue;
+            }
+            tree_to_operations(child_path, child_index, instance, ops);
+        }
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Ask vendor module for the content of an object and all its descendants, and
+ * apply it to the DM in one batch.
+ *
+ * @param[in] task  has info about the object to query. See query_content().
+ *
+ * The function replaces the per-object walk of query_content(): it does not
+ * add any task for the children of the object. It only works if the vendor
+ * module implements get_object_tree().
+ *
+ * @return true if the vendor module returned the tree, false if the caller
+ *         must fall back to the per-object walk
+ */
+static bool query_tree(const task_t* task) {
+
+    bool rv = false;
+    const char* const path = task->path;
+    amxc_var_t ret;
+    amxc_var_t batch;
+    amxc_var_init(&ret);
+    amxc_var_init(&batch);
+
+    const int rc = pon_ctrl_get_object_tree(path, task->index, &ret);
+    if(!check_return_values(rc, &ret, "get_object_tree", path, task->index)) {
+        goto exit;
+    }
+    rv = true;
+
+    amxc_var_set_type(&batch, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const ops = amxc_var_add_key(amxc_llist_t, &batch, "operations", NULL);
+    tree_to_operations(path, task->index, &ret, ops);
+    SAH_TRACEZ_INFO(ME, "%s.%d: apply tree with %zu objects", path, task->index,
+                    amxc_llist_size(amxc_var_constcast(amxc_llist_t, ops)));
+    if(dm_apply_batch_impl(&batch, NULL)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to apply tree of %s.%d", path, task->index);
+    }
+
+    if((obj_id_onu == dm_get_object_id(path)) && dm_does_instance_exist(path, task->index)) {
+        set_onu_initialised(task->index);
+    }
+
+exit:
+    amxc_var_clean(&batch);
+    amxc_var_clean(&ret);
+    return rv;
+}
+
 /**
  * Ask vendor module for object content, update DM and add tasks to query children.
  *
@@ -352,15 +725,18 @@ exit_no_cleanup:
  * the object. It adds a task of type 'task_query_content' for each child which
  * is a singleton, and it adds a task of type 'task_query_indexes' for each
  * child which is a template.
+ *
+ * If the vendor module implements get_object_tree(), the function instead
+ * gets the object and all its descendants with one call. See query_tree().
  */
 static void query_content(const task_t* task) {
 
-    const char* path = amxc_string_get(&task->path, 0);
-    if(!path) {
-        SAH_TRACEZ_ERROR(ME, "Failed to get path");
+    const char* const path = task->path;
+    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d", path, task->index);
+
+    if(pon_ctrl_has_get_object_tree() && query_tree(task)) {
         return;
     }
-    SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d", path, task->index);
 
     amxc_var_t ret;
     amxc_var_init(&ret);
@@ -368,6 +744,7 @@ static void query_content(const task_t* task) {
     const int rc = pon_ctrl_get_object_content(path, task->index, &ret);
 
     if(!check_return_values(rc, &ret, "get_object_content", path, task->index)) {
+        dm_snapshot_confirm_subtree(path, task->index);
         goto exit;
     }
     if(amxc_var_add_key(cstring_t, &ret, "path", path) == NULL) {
@@ -383,6 +760,7 @@ static void query_content(const task_t* task) {
             SAH_TRACEZ_ERROR(ME, "Failed to create %s.%d", path, task->index);
             goto exit;
         }
+        dm_snapshot_confirm(path, task->index);
     } else {
         if(dm_change_object(&ret)) {
             SAH_TRACEZ_ERROR(ME, "Failed to update %s", path);
@@ -400,13 +778,7 @@ static void query_content(const task_t* task) {
     query_children(path, task->index, id, true);
 
     if(obj_id_onu == id) {
-        if((task->index != 0) && (task->index <= MAX_NR_OF_ONUS)) {
-            SAH_TRACEZ_INFO(ME, "XPON.ONU.%d is initialised", task->index);
-            s_onu_initialised[task->index - 1] = 1;
-        } else {
-            SAH_TRACEZ_ERROR(ME, "XPON.ONU: invalid index: %d: not in [1, %d]",
-                             task->index, MAX_NR_OF_ONUS);
-        }
+        set_onu_initialised(task->index);
     }
 
 exit:
@@ -425,7 +797,9 @@ exit:
  * The function does not change anything in the XPON DM.
  *
  * If the get_list_of_instances() call fails, the function logs an error and
- * immediately returns an error. It does not retry.
+ * immediately returns an error. It does not retry. It keeps the stale
+ * instances of @a task, except for XPON.ONU, which is polled again: the
+ * vendor module did not tell which ones exist.
  *
  * Example:
  * if task->path is XPON.ONU, it asks the vendor module if there are any
@@ -435,11 +809,7 @@ exit:
  */
 static void query_indexes(const task_t* task) {
 
-    const char* const path = amxc_string_get(&task->path, 0);
-    if(!path) {
-        SAH_TRACEZ_ERROR(ME, "Failed to get path");
-        return;
-    }
+    const char* const path = task->path;
     SAH_TRACEZ_DEBUG(ME, "path='%s' index=%d", path, task->index);
 
     amxc_var_t ret;
@@ -454,13 +824,13 @@ static void query_indexes(const task_t* task) {
     const int rc = pon_ctrl_get_list_of_instances(path, &ret);
 
     if(!check_return_values(rc, &ret, "get_list_of_instances", path, task->index)) {
-        goto exit;
+        goto exit_keep_stale;
     }
 
     const amxc_htable_t* const htable = amxc_var_constcast(amxc_htable_t, &ret);
     if(!amxc_htable_contains(htable, "indexes")) {
         SAH_TRACEZ_ERROR(ME, "htable 'ret' does not contain 'indexes'");
-        goto exit;
+        goto exit_keep_stale;
     }
 
     const char* const indexes = GET_CHAR(&ret, "indexes");
@@ -474,7 +844,7 @@ static void query_indexes(const task_t* task) {
 
     if(AMXC_STRING_SPLIT_OK != amxc_string_split_to_llist(&indexes_str, &indexes_list, ',')) {
         SAH_TRACEZ_ERROR(ME, "Failed to split '%s'", indexes);
-        goto exit;
+        goto exit_keep_stale;
     }
 
     amxc_llist_iterate(it, &indexes_list) {
@@ -493,17 +863,18 @@ static void query_indexes(const task_t* task) {
          */
         SAH_TRACEZ_DEBUG(ME, "check instance already exists path=%s, index=%d", path, index);
         if(strcmp(path, "XPON.ONU") == 0) {
-            if((0 == index) || (index > MAX_NR_OF_ONUS)) {
-                SAH_TRACEZ_ERROR(ME, "Invalid index: %d: not in [1, %d]", index, MAX_NR_OF_ONUS);
+            if((0 == index) || (index > s_max_nr_of_onus)) {
+                SAH_TRACEZ_ERROR(ME, "Invalid index: %d: not in [1, %d]", index, s_max_nr_of_onus);
                 continue;
             }
 
-            if(dm_does_instance_exist(path, index) && s_onu_initialised[index - 1]) {
+            if(bitmap_is_set(&s_onu_initialised, index - 1) && dm_does_instance_exist(path, index)) {
                 SAH_TRACEZ_DEBUG(ME, "%s.%d already exists", path, index);
                 continue;
             }
         } else {
-            if(dm_does_instance_exist(path, index)) {
+            /* A stale instance loaded from the DM snapshot must be reconciled */
+            if(dm_does_instance_exist(path, index) && !dm_snapshot_is_stale(path, index)) {
                 SAH_TRACEZ_DEBUG(ME, "%s.%d already exists", path, index);
                 continue;
             }
@@ -514,7 +885,13 @@ static void query_indexes(const task_t* task) {
 
         task_create(path, index, task_query_content);
     }
+    goto exit;
 
+exit_keep_stale:
+    /* The plugin polls XPON.ONU again: keep those stale instances until then */
+    if(strcmp(path, "XPON.ONU") != 0) {
+        dm_snapshot_confirm_subtree(path, /*index=*/ 0);
+    }
 exit:
     amxc_llist_clean(&indexes_list, amxc_string_list_it_free);
     amxc_string_clean(&indexes_str);
@@ -523,26 +900,31 @@ exit:
 
 static void schedule_remaining_tasks(void) {
 
-    if(!amxc_llist_is_empty(&s_tasks)) {
+    if(!tasks_is_empty()) {
         amxp_timer_start(s_timer_handle_tasks, SHORT_TIMEOUT_MS);
     }
 }
 
 /**
- * Handle the 1st task from s_tasks, remove it from the list, and delete it.
+ * Handle the 1st task with the highest priority from s_tasks, and put it back
+ * in the pool.
  *
- * Subsequently reschedule the timer if there are remaining tasks.
+ * The task stays in the queue while it's handled: any attempt to queue the
+ * same task meanwhile is a no-op.
  */
-static void handle_task(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+static void handle_first_task(void) {
 
-    if(amxc_llist_is_empty(&s_tasks)) {
-        SAH_TRACEZ_WARNING(ME, "No tasks");
-        return;
+    amxc_llist_it_t* it = NULL;
+    for(int prio = 0; (prio < task_prio_nr) && (NULL == it); ++prio) {
+        it = amxc_llist_get_first(&s_tasks[prio]);
     }
+    when_null_trace(it, exit, ERROR, "No tasks");
 
-    amxc_llist_it_t* const it = amxc_llist_get_first(&s_tasks);
-
-    const task_t* const task = amxc_container_of(it, task_t, it);
+    task_t* const task = amxc_container_of(it, task_t, it);
+    const uint32_t onu_index = task_onu_index(task);
+    if(onu_index) {
+        bitmap_set(&s_onu_tasks_handled, onu_index - 1);
+    }
 
     switch(task->type) {
     case task_query_indexes:
@@ -555,71 +937,214 @@ static void handle_task(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
         SAH_TRACEZ_WARNING(ME, "Unknown task type: %d", task->type);
         break;
     }
-    /* Remove the 1st task from the list and delete it */
-    amxc_llist_it_clean(it, task_delete);
+    task_release(task);
+    ++s_nr_of_tasks_handled;
 
-    schedule_remaining_tasks();
+exit:
+    return;
 }
 
 /**
- * Ask vendor module for instances of XPON.ONU.
+ * Report how long it took to populate the DM, from the 1st to the last task.
  *
- * @param[in,out] timer  timer to query the instances of XPON.ONU every 10 s
+ * The function is called each time s_tasks becomes empty. The value is frozen
+ * once all expected ONUs are initialised, or once polling stopped: the tasks
+ * for an ONU found later on are not part of the startup population, and the
+ * time in between would only add idle time.
+ */
+static void report_population_time(void) {
+
+    when_true(s_population_done, exit);
+    const uint64_t duration = time_get_monotonic_ms() - s_first_task_ms;
+    SAH_TRACEZ_INFO(ME, "Handled %d tasks to populate DM in %" PRIu64 " ms",
+                    s_nr_of_tasks_handled, duration);
+    dm_set_startup_population_time((uint32_t) duration);
+    s_population_done = all_onus_initialised() || s_polling_done;
+
+exit:
+    return;
+}
+
+/**
+ * Handle tasks from s_tasks for at most s_task_slice_ms.
  *
- * The function stops the timer if the number of instances of XPON.ONU is
- * MAX_NR_OF_ONUS, or if 5 minutes passed since startup.
+ * The function handles at least one task. If there are remaining tasks, it
+ * restarts the timer with a minimal timeout: this yields to the event loop
+ * between 2 slices, without leaving it idle.
+ */
+static void handle_task(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+
+    if(tasks_is_empty()) {
+        SAH_TRACEZ_WARNING(ME, "No tasks");
+        return;
+    }
+
+    const uint64_t start = time_get_monotonic_ms();
+    if(0 == s_first_task_ms) {
+        s_first_task_ms = start;
+    }
+
+    do {
+        handle_first_task();
+    } while(!tasks_is_empty() &&
+            ((time_get_monotonic_ms() - start) < s_task_slice_ms));
+
+    if(tasks_is_empty()) {
+        report_population_time();
+        remove_stale_instances();
+    } else {
+        amxp_timer_start(s_timer_handle_tasks, TASK_YIELD_MS);
+    }
+}
+
+/**
+ * Ask vendor module for instances of XPON.ONU.
  *
- * Otherwise the function calls query_indexes() for XPON.ONU.
+ * The function calls query_indexes() for XPON.ONU and schedules the tasks
+ * which follow from it.
  */
-static void query_onu_instances(amxp_timer_t* timer, UNUSED void* priv) {
+static void query_onus(void) {
 
     task_t task;
     task_init(&task, "XPON.ONU", /*index=*/ 0, task_query_indexes);
 
+    query_indexes(&task);
+    schedule_remaining_tasks();
+}
+
+/**
+ * Poll the vendor module for instances of XPON.ONU.
+ *
+ * @param[in,out] timer  timer to poll the instances of XPON.ONU
+ *
+ * The function stops polling if all expected ONU instances are initialised
+ * (see all_onus_initialised()), or if 5 minutes passed since startup.
+ *
+ * Otherwise the function queries the ONU instances, and restarts the timer
+ * with the double of the previous interval, up to QUERY_ONUS_MAX_INTERVAL_MS.
+ */
+static void query_onu_instances(amxp_timer_t* timer, UNUSED void* priv) {
+
     SAH_TRACEZ_DEBUG(ME, "s_cntr_query_onus=%d", s_cntr_query_onus);
 
-    /* Check if all the ONU instances are initialised */
-    bool all_onus_initialised = true;
-    for(int i = 0; i < MAX_NR_OF_ONUS; i++) {
-        if(!s_onu_initialised[i]) {
-            all_onus_initialised = false;
-            break;
-        }
+    if(all_onus_initialised()) {
+        SAH_TRACEZ_INFO(ME, "All ONUs found and initialised: stop polling");
+        polling_done();
+        goto exit;
     }
-    if(all_onus_initialised) {
-        SAH_TRACEZ_INFO(ME, "All %d ONUs found and initialised", MAX_NR_OF_ONUS);
-        amxp_timer_stop(timer);
+    if(s_query_onus_elapsed_ms >= QUERY_ONUS_PERIOD_MS) {
+        SAH_TRACEZ_DEBUG(ME, "Stop querying ONU instances");
+        polling_done();
         goto exit;
     }
 
     ++s_cntr_query_onus;
-    if(s_cntr_query_onus > QUERY_ONUS_NR_TIMES) {
-        SAH_TRACEZ_DEBUG(ME, "Stop querying ONU instances");
-        amxp_timer_stop(timer);
-        goto exit;
+    query_onus();
+
+    if(0 == s_query_onus_interval_ms) {
+        s_query_onus_interval_ms = QUERY_ONUS_INITIAL_INTERVAL_MS;
+    } else if(s_query_onus_interval_ms < QUERY_ONUS_MAX_INTERVAL_MS) {
+        s_query_onus_interval_ms *= 2;
+        if(s_query_onus_interval_ms > QUERY_ONUS_MAX_INTERVAL_MS) {
+            s_query_onus_interval_ms = QUERY_ONUS_MAX_INTERVAL_MS;
+        }
     }
+    s_query_onus_elapsed_ms += s_query_onus_interval_ms;
+    amxp_timer_start(timer, s_query_onus_interval_ms);
 
-    query_indexes(&task);
-    schedule_remaining_tasks();
+exit:
+    return;
+}
+
+/**
+ * Handle a notification from the vendor module that the list of ONUs changed.
+ *
+ * @param[in] args: htable. It may have the key 'nr_of_onus': the final number
+ *                  of ONUs the vendor module will report. Then the plugin
+ *                  stops polling once it has initialised that many ONUs.
+ *
+ * The function queries the ONU instances at once, without waiting for the
+ * next poll.
+ *
+ * @return 0 on success, else -1
+ */
+int pplt_dm_onu_list_changed(const amxc_var_t* const args) {
+
+    const amxc_var_t* const nr_of_onus = GET_ARG(args, "nr_of_onus");
+    if(nr_of_onus) {
+        const uint32_t n = amxc_var_dyncast(uint32_t, nr_of_onus);
+        if(0 == n) {
+            SAH_TRACEZ_ERROR(ME, "Invalid nr_of_onus: 0");
+            return -1;
+        }
+        return pplt_dm_onu_list_changed_n(n);
+    }
+    return pplt_dm_onu_list_changed_n(0);
+}
+
+/**
+ * Handle a notification from the vendor module that the list of ONUs changed.
+ *
+ * @param[in] nr_of_onus: final number of ONUs the vendor module will report,
+ *                        or 0 if it does not know
+ *
+ * Same as pplt_dm_onu_list_changed(), but without the need to pass the number
+ * in an htable.
+ *
+ * @return 0 on success, else -1
+ */
+int pplt_dm_onu_list_changed_n(uint32_t nr_of_onus) {
+
+    int rc = -1;
+    if(nr_of_onus) {
+        when_true_trace(nr_of_onus > s_max_nr_of_onus, exit, ERROR,
+                        "Invalid nr_of_onus: %d: not in [1, %d]", nr_of_onus,
+                        s_max_nr_of_onus);
+        s_final_nr_of_onus = nr_of_onus;
+    }
+    SAH_TRACEZ_INFO(ME, "ONU list changed: nr_of_onus=%d", s_final_nr_of_onus);
+
+    ++s_cntr_query_onus;
+    query_onus();
+    rc = 0;
 
 exit:
-    task_clean(&task);
+    return rc;
 }
 
 /**
  * Initialize the part responsible for populating the XPON DM at startup.
  *
  * To start the whole process of the populating the XPON DM, the function
- * schedules a task to query the instances of XPON.ONU every 10 s. (The plugin
- * will stop the timer when it has found MAX_NR_OF_ONUS ONUs, or when 5 minutes
- * have passed since startup.)
+ * starts a timer to poll the instances of XPON.ONU with exponential backoff.
+ * (The plugin will stop the timer when it has found all ONUs, or when 5
+ * minutes have passed since startup.) The vendor module can trigger a query at
+ * any time with onu_list_changed().
+ *
+ * The tasks which follow from that query are handled in slices of at most the
+ * time given by the config option 'pplt_task_slice_ms'.
  *
  * The plugin must call this function once at startup.
  */
 bool pplt_dm_init(void) {
     bool rv = false;
 
-    amxc_llist_init(&s_tasks);
+    for(int prio = 0; prio < task_prio_nr; ++prio) {
+        amxc_llist_init(&s_tasks[prio]);
+    }
+    amxc_htable_init(&s_task_index, 0);
+    amxc_llist_init(&s_task_pool);
+
+    s_max_nr_of_onus = xpon_mngr_get_max_nr_of_onus();
+    when_false(bitmap_init(&s_onu_initialised, s_max_nr_of_onus), exit);
+    when_false(bitmap_init(&s_onu_tasks_handled, s_max_nr_of_onus), exit);
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    const amxc_var_t* const slice = parser ? GET_ARG(&parser->config, TASK_SLICE_CONFIG) : NULL;
+    if(slice) {
+        s_task_slice_ms = amxc_var_dyncast(uint32_t, slice);
+    }
+    SAH_TRACEZ_INFO(ME, "%s=%d", TASK_SLICE_CONFIG, s_task_slice_ms);
 
     if(amxp_timer_new(&s_timer_handle_tasks, handle_task, NULL)) {
         SAH_TRACEZ_ERROR(ME, "Failed to create timer to handle tasks");
@@ -630,8 +1155,6 @@ bool pplt_dm_init(void) {
         SAH_TRACEZ_ERROR(ME, "Failed to create timer to query ONUs");
         goto exit;
     }
-    amxp_timer_set_interval(s_timer_query_onus, QUERY_ONUS_INTERVAL_MS);
-
     /* Start querying the DM on the southbound IF */
     amxp_timer_start(s_timer_query_onus, SHORT_TIMEOUT_MS);
 
@@ -646,7 +1169,14 @@ exit:
  * The plugin must call this function once when stopping.
  */
 void pplt_dm_cleanup(void) {
-    amxc_llist_clean(&s_tasks, task_delete);
+    for(int prio = 0; prio < task_prio_nr; ++prio) {
+        amxc_llist_clean(&s_tasks[prio], task_delete);
+    }
+    amxc_htable_clean(&s_task_index, NULL);
+    amxc_llist_clean(&s_task_pool, task_delete);
+    s_task_pool_size = 0;
+    bitmap_clean(&s_onu_initialised);
+    bitmap_clean(&s_onu_tasks_handled);
     amxp_timer_delete(&s_timer_handle_tasks);
     amxp_timer_delete(&s_timer_query_onus);
 }
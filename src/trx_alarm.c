@@ -0,0 +1,314 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file trx_alarm.c
+ *
+ * Threshold alarms for the volatile parameters of a Transceiver instance.
+ *
+ * The object XPON.TransceiverThresholds has one child object per volatile
+ * parameter: RxPower, TxPower, Voltage, Bias and Temperature. Like the
+ * alarm and warning thresholds of SFF-8472, each child has the parameters
+ * HighAlarm, HighWarning, LowWarning and LowAlarm. It also has the parameter
+ * Hysteresis.
+ *
+ * trx_cache.c calls trx_alarm_evaluate() for each volatile parameter each
+ * time it stores a new snapshot of a Transceiver instance. The function
+ * classifies the value in one of the alarm levels. If the level differs from
+ * the previous one, it emits the event TRX_THRESHOLD_CROSSED_EVENT for the
+ * Transceiver instance. So a subscriber gets one event per crossing, instead
+ * of having to poll the values.
+ *
+ * To avoid a burst of events if a value hovers around a threshold, a value
+ * only leaves a level if it's at least Hysteresis away from the threshold of
+ * that level. E.g. if HighWarning is -10 and Hysteresis is 10, RxPower enters
+ * the level HighWarning at -10, and only leaves it again below -20.
+ *
+ * The module caches the thresholds. It reads them again from the DM after
+ * they changed.
+ *
+ * A Temperature of -274 (below absolute zero) means the vendor module did not
+ * obtain a good reading. The module ignores that value: the Temperature keeps
+ * its level, and no event is emitted.
+ */
+
+/* Related header */
+#include "trx_alarm.h"
+
+/* System headers */
+#include <stdbool.h>
+#include <string.h> /* strcmp() */
+
+/* Other libraries' headers */
+#include <amxc/amxc.h>                  /* amxc_var_t */
+#include <amxd/amxd_dm.h>               /* amxd_dm_findf() */
+#include <amxd/amxd_object.h>           /* amxd_object_emit_signal() */
+#include <amxd/amxd_object_hierarchy.h> /* amxd_object_get_child() */
+
+/* Own headers */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_dm() */
+#include "xpon_trace.h"
+
+#define TRX_THRESHOLD_CROSSED_EVENT "xpon:threshold-crossed"
+
+/**
+ * Thresholds of one volatile parameter.
+ *
+ * @valid: true if the thresholds are read from the DM and are consistent
+ */
+typedef struct _trx_thresholds {
+    const char* name;
+    bool valid;
+    int64_t high_alarm;
+    int64_t high_warning;
+    int64_t low_warning;
+    int64_t low_alarm;
+    int64_t hysteresis;
+} trx_thresholds_t;
+
+static trx_thresholds_t s_thresholds[] = {
+    { .name = "RxPower" },
+    { .name = "TxPower" },
+    { .name = "Voltage" },
+    { .name = "Bias" },
+    { .name = "Temperature" }
+};
+
+#define NR_OF_THRESHOLDS (sizeof(s_thresholds) / sizeof(s_thresholds[0]))
+
+static const char* const LEVEL_NAMES[] = {
+    [trx_alarm_level_normal] = "Normal",
+    [trx_alarm_level_low_warning] = "LowWarning",
+    [trx_alarm_level_low_alarm] = "LowAlarm",
+    [trx_alarm_level_high_warning] = "HighWarning",
+    [trx_alarm_level_high_alarm] = "HighAlarm"
+};
+
+/** Value of XPON.TransceiverThresholds.Enable */
+static bool s_enable = false;
+
+/** True if s_enable and s_thresholds reflect the DM */
+static bool s_loaded = false;
+
+static int64_t get_threshold(amxd_object_t* const object, const char* const name) {
+    amxc_var_t value;
+    amxc_var_init(&value);
+    amxd_object_get_param(object, name, &value);
+    const int64_t rv = amxc_var_dyncast(int64_t, &value);
+    amxc_var_clean(&value);
+    return rv;
+}
+
+static void load_thresholds(void) {
+
+    uint32_t i;
+    amxd_object_t* const thresholds =
+        amxd_dm_findf(xpon_mngr_get_dm(), "XPON.TransceiverThresholds");
+
+    s_enable = false;
+    for(i = 0; i < NR_OF_THRESHOLDS; ++i) {
+        s_thresholds[i].valid = false;
+    }
+    when_null_trace(thresholds, exit, ERROR, "XPON.TransceiverThresholds not found");
+
+    s_enable = amxd_object_get_value(bool, thresholds, "Enable", NULL);
+    for(i = 0; i < NR_OF_THRESHOLDS; ++i) {
+        trx_thresholds_t* const t = &s_thresholds[i];
+        amxd_object_t* const object = amxd_object_get_child(thresholds, t->name);
+        if(NULL == object) {
+            SAH_TRACEZ_ERROR(ME, "XPON.TransceiverThresholds.%s not found", t->name);
+            continue;
+        }
+        t->high_alarm = get_threshold(object, "HighAlarm");
+        t->high_warning = get_threshold(object, "HighWarning");
+        t->low_warning = get_threshold(object, "LowWarning");
+        t->low_alarm = get_threshold(object, "LowAlarm");
+        t->hysteresis = get_threshold(object, "Hysteresis");
+        if((t->low_alarm > t->low_warning) || (t->low_warning > t->high_warning) ||
+           (t->high_warning > t->high_alarm)) {
+            SAH_TRACEZ_ERROR(ME, "Thresholds of %s not in ascending order: ignore them",
+                             t->name);
+            continue;
+        }
+        t->valid = true;
+    }
+
+exit:
+    s_loaded = true;
+}
+
+/**
+ * Return the alarm level of a value.
+ *
+ * @param[in] t: thresholds of the parameter
+ * @param[in] v: value of the parameter
+ * @param[in] cur: current alarm level of the parameter
+ *
+ * A value stays in its current level, or in a less severe level of the same
+ * side, until it's more than the hysteresis away from the threshold of that
+ * level.
+ */
+static trx_alarm_level_t classify(const trx_thresholds_t* const t, int64_t v,
+                                  trx_alarm_level_t cur) {
+
+    const bool high = (cur == trx_alarm_level_high_alarm) ||
+        (cur == trx_alarm_level_high_warning);
+    const bool low = (cur == trx_alarm_level_low_alarm) ||
+        (cur == trx_alarm_level_low_warning);
+
+    if((v >= t->high_alarm) ||
+       ((cur == trx_alarm_level_high_alarm) && (v > t->high_alarm - t->hysteresis))) {
+        return trx_alarm_level_high_alarm;
+    }
+    if((v >= t->high_warning) || (high && (v > t->high_warning - t->hysteresis))) {
+        return trx_alarm_level_high_warning;
+    }
+    if((v <= t->low_alarm) ||
+       ((cur == trx_alarm_level_low_alarm) && (v < t->low_alarm + t->hysteresis))) {
+        return trx_alarm_level_low_alarm;
+    }
+    if((v <= t->low_warning) || (low && (v < t->low_warning + t->hysteresis))) {
+        return trx_alarm_level_low_warning;
+    }
+    return trx_alarm_level_normal;
+}
+
+/**
+ * Make the module read the thresholds again from the DM.
+ *
+ * tr181-xpon calls this function if a parameter of XPON.TransceiverThresholds
+ * or of one of its child objects changed.
+ */
+void trx_alarm_thresholds_changed(void) {
+    s_loaded = false;
+}
+
+/**
+ * Return the value of XPON.TransceiverThresholds.Enable.
+ */
+bool trx_alarm_is_enabled(void) {
+    if(!s_loaded) {
+        load_thresholds();
+    }
+    return s_enable;
+}
+
+/**
+ * Evaluate the thresholds for a new value of a volatile Transceiver parameter.
+ *
+ * @param[in] trx: Transceiver instance
+ * @param[in] name: name of the parameter, e.g. "RxPower"
+ * @param[in] value: new value of the parameter
+ * @param[in,out] level: alarm level of the parameter. The caller keeps it per
+ *                       instance and per parameter. It should be
+ *                       trx_alarm_level_normal initially.
+ *
+ * If the value crossed a threshold, the function updates @a level, and emits
+ * the event TRX_THRESHOLD_CROSSED_EVENT for @a trx with the parameter name,
+ * the value, and the previous and the new alarm level.
+ *
+ * If the alarms are disabled, the function resets @a level to
+ * trx_alarm_level_normal without emitting an event.
+ *
+ * If @a value is TRX_TEMPERATURE_NO_READING for the Temperature, the function
+ * keeps @a level and does not emit an event.
+ */
+void trx_alarm_evaluate(amxd_object_t* const trx, const char* const name,
+                        int64_t value, trx_alarm_level_t* const level) {
+
+    uint32_t i;
+    const trx_thresholds_t* t = NULL;
+    amxc_var_t data;
+    amxc_var_init(&data);
+
+    if(!s_loaded) {
+        load_thresholds();
+    }
+    if(!s_enable) {
+        *level = trx_alarm_level_normal;
+        goto exit;
+    }
+    for(i = 0; i < NR_OF_THRESHOLDS; ++i) {
+        if(strcmp(s_thresholds[i].name, name) == 0) {
+            t = &s_thresholds[i];
+            break;
+        }
+    }
+    when_null_trace(t, exit, ERROR, "No thresholds for %s", name);
+    when_false(t->valid, exit);
+    when_true((TRX_TEMPERATURE_NO_READING == value) &&
+              (strcmp(name, "Temperature") == 0), exit);
+
+    const trx_alarm_level_t new_level = classify(t, value, *level);
+    when_true(new_level == *level, exit);
+
+    amxc_var_set_type(&data, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &data, "Parameter", name);
+    amxc_var_add_key(int64_t, &data, "Value", value);
+    amxc_var_add_key(cstring_t, &data, "PreviousLevel", LEVEL_NAMES[*level]);
+    amxc_var_add_key(cstring_t, &data, "Level", LEVEL_NAMES[new_level]);
+    amxd_object_emit_signal(trx, TRX_THRESHOLD_CROSSED_EVENT, &data);
+    *level = new_level;
+
+exit:
+    amxc_var_clean(&data);
+}
@@ -0,0 +1,767 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * @file trx_cache.c
+ *
+ * Snapshot cache and background sampler for the volatile parameters of a
+ * Transceiver instance.
+ *
+ * Reading XPON.ONU.{i}.ANI.{i}.Transceiver.{i}. used to result in one call to
+ * get_param_values() of the vendor module per volatile parameter. Each call
+ * typically reads the transceiver over I2C.
+ *
+ * With the cache, the 1st read of a volatile parameter fetches all volatile
+ * parameters of the instance with one call: it passes their names as
+ * comma-separated list. The cache serves the next reads from that snapshot
+ * until it's older than the TTL configured with the config option
+ * 'trx_cache_ttl_ms'. As bonus, the values of one snapshot are from the same
+ * moment in time. If the TTL is 0, the cache is disabled.
+ *
+ * If the config option 'trx_sample_interval_ms' is not 0, a timer takes a
+ * snapshot of each Transceiver instance at that interval. The module then
+ * serves all reads from the latest snapshot, independent from the TTL: a read
+ * never waits for the vendor module. It also stores the samples in a ring
+ * buffer per instance. Its size is given by the config option
+ * 'trx_sample_window'. The parameters RxPowerMin, RxPowerMax, RxPowerAvg, etc.
+ * of a Transceiver instance return the minimum, maximum and average over the
+ * samples in that buffer. A snapshot with a Temperature of -274 (no good
+ * reading) is not added as sample: it would pull TemperatureMin and
+ * TemperatureAvg towards absolute zero.
+ *
+ * If the vendor module implements get_param_values_async(), a read never
+ * blocks on the vendor module once the instance has a snapshot: if the
+ * snapshot is too old, the module asks the vendor module to refresh it, and
+ * meanwhile serves the read from the old snapshot. The vendor module passes
+ * the new values via the pon_stat function param_values_ready(). There is at
+ * most one query in flight per instance: reads while a query is in flight do
+ * not start another one.
+ *
+ * Each time the module stores a new snapshot, it evaluates the alarm and
+ * warning thresholds for its values. See trx_alarm.c. It also evaluates them
+ * for a value the plugin queried without the cache. If the thresholds are
+ * enabled and 'trx_sample_interval_ms' is 0, the sampler runs at
+ * TRX_ALARM_SAMPLE_INTERVAL_MS, such that the thresholds are also evaluated
+ * if nobody reads the parameters. The sampler then does not change how reads
+ * are served: they still use the TTL.
+ *
+ * The API of get_param_values() allows the vendor module to only support one
+ * parameter name per call. If fetching a snapshot fails, or if a snapshot
+ * misses a parameter, the module queries that parameter on its own. If that
+ * succeeds, the vendor module clearly rejects multiple names per call: the
+ * module disables the cache and the sampler, and the plugin queries each
+ * parameter separately, as before. If that fails too, the module considers
+ * the error transient: it keeps the cache, and tries again at the next read
+ * after the TTL or at the next sample. dm_pull.c applies the same policy.
+ */
+
+/* Related header */
+#include "trx_cache.h"
+
+/* System headers */
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strncmp(), strlen(), strcmp() */
+
+/* Other libraries' headers */
+#include <amxp/amxp_timer.h>            /* amxp_timer_new() */
+#include <amxd/amxd_dm.h>               /* amxd_dm_findf() */
+#include <amxd/amxd_object.h>           /* amxd_object_get_path() */
+#include <amxd/amxd_object_hierarchy.h> /* amxd_object_get_child() */
+#include <amxo/amxo.h>                  /* amxo_parser_t */
+
+/* Own headers */
+#include "dm_info.h"      /* dm_classify_path() */
+#include "dm_xpon_mngr.h" /* xpon_mngr_get_parser() */
+#include "pon_ctrl.h"     /* pon_ctrl_get_param_values() */
+#include "trx_alarm.h"    /* trx_alarm_evaluate() */
+#include "utils_time.h"   /* time_get_monotonic_ms() */
+#include "xpon_trace.h"
+
+#define TRX_CACHE_TTL_CONFIG "trx_cache_ttl_ms"
+#define TRX_CACHE_TTL_DEFAULT 1000
+#define TRX_SAMPLE_INTERVAL_CONFIG "trx_sample_interval_ms"
+#define TRX_SAMPLE_WINDOW_CONFIG "trx_sample_window"
+#define TRX_SAMPLE_WINDOW_DEFAULT 60
+#define TRX_SAMPLE_WINDOW_MAX 3600
+
+/**
+ * Interval in ms of the sampler if the thresholds are enabled and the config
+ * option 'trx_sample_interval_ms' is 0.
+ */
+#define TRX_ALARM_SAMPLE_INTERVAL_MS 10000
+
+/**
+ * Time in ms after which the module considers a get_param_values_async()
+ * query lost if the vendor module did not answer.
+ */
+#define ASYNC_QUERY_TIMEOUT_MS 5000
+
+/**
+ * Volatile parameters of a Transceiver instance. They must have
+ * 'read_trx_param' as read action in the odl file. TRX_PARAMS must list them
+ * in the same order.
+ */
+#define TRX_VOLATILE_PARAMS "RxPower,TxPower,Voltage,Bias,Temperature"
+
+typedef struct _trx_param_info {
+    const char* name;
+    bool is_signed;
+} trx_param_info_t;
+
+static const trx_param_info_t TRX_PARAMS[] = {
+    { .name = "RxPower", .is_signed = true },
+    { .name = "TxPower", .is_signed = true },
+    { .name = "Voltage", .is_signed = false },
+    { .name = "Bias", .is_signed = false },
+    { .name = "Temperature", .is_signed = true }
+};
+
+#define NR_OF_TRX_PARAMS (sizeof(TRX_PARAMS) / sizeof(TRX_PARAMS[0]))
+
+/** Index of Temperature in TRX_PARAMS */
+#define TRX_TEMPERATURE_INDEX 4
+
+typedef struct _trx_sample {
+    int64_t values[NR_OF_TRX_PARAMS];
+} trx_sample_t;
+
+/**
+ * @timestamp: time in ms of the monotonic clock when the snapshot was taken.
+ * @values: htable with the parameter values. Empty if the snapshot is not
+ *          valid.
+ * @samples: ring buffer with s_window samples. NULL if the sampler is
+ *           disabled.
+ * @head: index in @samples where the next sample will be written
+ * @count: number of valid samples in @samples
+ * @query_started: time in ms of the monotonic clock when the module called
+ *                 get_param_values_async() for the instance. 0 if no query
+ *                 is in flight.
+ * @sample_pending: true if the sampler waits for the answer of the query in
+ *                  flight
+ * @levels: alarm level per volatile parameter
+ */
+struct _trx_snapshot {
+    uint64_t timestamp;
+    amxc_var_t values;
+    trx_sample_t* samples;
+    uint32_t head;
+    uint32_t count;
+    uint64_t query_started;
+    bool sample_pending;
+    trx_alarm_level_t levels[NR_OF_TRX_PARAMS];
+};
+
+static uint32_t s_ttl_ms = TRX_CACHE_TTL_DEFAULT;
+static uint32_t s_sample_interval_ms = 0;
+static uint32_t s_window = TRX_SAMPLE_WINDOW_DEFAULT;
+static amxp_timer_t* s_sample_timer = NULL;
+/* Interval the sampler runs at. See update_sampler(). */
+static uint32_t s_sampler_interval_ms = 0;
+
+/** True if the vendor module can not return all volatile params at once */
+static bool s_disabled = false;
+
+static uint64_t s_nr_of_hits = 0;
+static uint64_t s_nr_of_misses = 0;
+
+static void disable(void) {
+    s_disabled = true;
+    if(s_sample_timer) {
+        amxp_timer_stop(s_sample_timer);
+    }
+}
+
+static int get_param_index(const char* const name) {
+    int i;
+    for(i = 0; i < (int) NR_OF_TRX_PARAMS; ++i) {
+        if(strcmp(TRX_PARAMS[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Find out why a query for all volatile params of a Transceiver failed.
+ *
+ * @param[in] path: path of the Transceiver instance
+ * @param[in] name: name of a volatile parameter the query did not return
+ * @param[in,out] value: if not NULL, and the vendor module returns @a name
+ *                       when queried on its own, the function assigns its
+ *                       value to this parameter
+ *
+ * If the vendor module returns @a name when queried on its own, it does not
+ * support multiple names per call: the function disables the cache and the
+ * sampler. Else it leaves them enabled.
+ *
+ * @return true if the vendor module returned @a name when queried on its own
+ */
+static bool query_single_name(const char* const path, const char* const name,
+                              amxc_var_t* const value) {
+
+    bool rv = false;
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+
+    if(pon_ctrl_get_param_values(path, name, &ret) == 0) {
+        const amxc_var_t* const single = GET_ARG(GET_ARG(&ret, "parameters"), name);
+        rv = (single != NULL);
+        if(rv && value) {
+            amxc_var_copy(value, single);
+        }
+    }
+    if(rv) {
+        SAH_TRACEZ_WARNING(ME, "Vendor module only returns %s.%s if queried on its "
+                           "own: disable cache and sampler", path, name);
+        disable();
+    } else {
+        SAH_TRACEZ_WARNING(ME, "Vendor module failed to return %s.%s: keep cache, "
+                           "retry later", path, name);
+    }
+
+    amxc_var_clean(&ret);
+    return rv;
+}
+
+static trx_snapshot_t* get_snapshot(amxd_object_t* const object) {
+
+    trx_snapshot_t* snapshot = (trx_snapshot_t*) object->priv;
+    if(snapshot) {
+        goto exit;
+    }
+    snapshot = calloc(1, sizeof(trx_snapshot_t));
+    when_null_trace(snapshot, exit, ERROR, "Failed to allocate trx_snapshot_t");
+    amxc_var_init(&snapshot->values);
+    amxc_var_set_type(&snapshot->values, AMXC_VAR_ID_HTABLE);
+    object->priv = snapshot;
+
+exit:
+    return snapshot;
+}
+
+/**
+ * Evaluate the alarm thresholds for the values of the current snapshot.
+ */
+static void evaluate_alarms(amxd_object_t* const trx, trx_snapshot_t* const snapshot) {
+
+    uint32_t i;
+    for(i = 0; i < NR_OF_TRX_PARAMS; ++i) {
+        const amxc_var_t* const value = GET_ARG(&snapshot->values, TRX_PARAMS[i].name);
+        if(value) {
+            trx_alarm_evaluate(trx, TRX_PARAMS[i].name, amxc_var_dyncast(int64_t, value),
+                               &snapshot->levels[i]);
+        }
+    }
+}
+
+/**
+ * Ask the vendor module for all volatile parameters of a Transceiver.
+ *
+ * @return true on success, else false
+ */
+static bool take_snapshot(amxd_object_t* const trx, const char* const path,
+                          trx_snapshot_t* const snapshot, uint64_t now) {
+
+    bool rv = false;
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+
+    amxc_var_set_type(&snapshot->values, AMXC_VAR_ID_HTABLE);
+
+    if(pon_ctrl_get_param_values(path, TRX_VOLATILE_PARAMS, &ret) != 0) {
+        SAH_TRACEZ_WARNING(ME, "Vendor module failed to return '%s' for %s",
+                           TRX_VOLATILE_PARAMS, path);
+        goto exit;
+    }
+    amxc_var_t* const params = GET_ARG(&ret, "parameters");
+    when_null_trace(params, exit, ERROR, "Failed to extract 'parameters'");
+    when_false_trace(amxc_var_type_of(params) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "Type of 'parameters' for %s = %d != htable", path,
+                     amxc_var_type_of(params));
+    when_failed_trace(amxc_var_move(&snapshot->values, params), exit, ERROR,
+                      "Failed to store snapshot of %s", path);
+    snapshot->timestamp = now;
+    evaluate_alarms(trx, snapshot);
+    rv = true;
+
+exit:
+    amxc_var_clean(&ret);
+    return rv;
+}
+
+/**
+ * Add the values of the current snapshot to the ring buffer.
+ */
+static void add_sample(const char* const path, trx_snapshot_t* const snapshot) {
+
+    uint32_t i;
+    trx_sample_t sample;
+
+    if(NULL == snapshot->samples) {
+        snapshot->samples = calloc(s_window, sizeof(trx_sample_t));
+        when_null_trace(snapshot->samples, exit, ERROR, "Failed to allocate ring buffer");
+    }
+    for(i = 0; i < NR_OF_TRX_PARAMS; ++i) {
+        const amxc_var_t* const value = GET_ARG(&snapshot->values, TRX_PARAMS[i].name);
+        if(NULL == value) {
+            SAH_TRACEZ_WARNING(ME, "Vendor module did not return %s.%s in "
+                               "snapshot: skip sample", path, TRX_PARAMS[i].name);
+            query_single_name(path, TRX_PARAMS[i].name, NULL);
+            goto exit;
+        }
+        sample.values[i] = amxc_var_dyncast(int64_t, value);
+    }
+    when_true_trace(sample.values[TRX_TEMPERATURE_INDEX] == TRX_TEMPERATURE_NO_READING,
+                    exit, WARNING, "No good Temperature reading for %s: skip sample", path);
+    snapshot->samples[snapshot->head] = sample;
+    snapshot->head = (snapshot->head + 1) % s_window;
+    if(snapshot->count < s_window) {
+        ++snapshot->count;
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Ask the vendor module to refresh the snapshot, without waiting for it.
+ *
+ * @return true if the function started a query, false if a query is already
+ *         in flight or if starting the query failed
+ */
+static bool refresh_async(const char* const path, trx_snapshot_t* const snapshot,
+                          uint64_t now) {
+
+    bool rv = false;
+    if((snapshot->query_started != 0) &&
+       ((now - snapshot->query_started) < ASYNC_QUERY_TIMEOUT_MS)) {
+        goto exit;
+    }
+    if(snapshot->query_started != 0) {
+        SAH_TRACEZ_WARNING(ME, "No answer for %s: query again", path);
+    }
+    snapshot->query_started = 0;
+    when_failed_trace(pon_ctrl_get_param_values_async(path, TRX_VOLATILE_PARAMS),
+                      exit, ERROR, "Failed to query %s", path);
+    snapshot->query_started = now;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+static void sample_trx(amxd_object_t* const trx, uint64_t now, bool async) {
+
+    trx_snapshot_t* const snapshot = get_snapshot(trx);
+    when_null(snapshot, exit);
+    char* path = amxd_object_get_path(trx, AMXD_OBJECT_INDEXED);
+    when_null_trace(path, exit, ERROR, "path is NULL");
+    if(async) {
+        refresh_async(path, snapshot, now);
+        snapshot->sample_pending = (snapshot->query_started != 0);
+    } else if(take_snapshot(trx, path, snapshot, now)) {
+        add_sample(path, snapshot);
+    } else {
+        query_single_name(path, TRX_PARAMS[0].name, NULL);
+    }
+    free(path);
+
+exit:
+    return;
+}
+
+/**
+ * Take a snapshot of each Transceiver instance of each ANI of each ONU.
+ */
+static void sample_timer_expired(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+
+    const uint64_t now = time_get_monotonic_ms();
+    const bool async = pon_ctrl_has_get_param_values_async();
+    amxd_object_t* const onu_templ = amxd_dm_findf(xpon_mngr_get_dm(), "XPON.ONU");
+    when_null(onu_templ, exit);
+
+    amxd_object_iterate(instance, onu_it, onu_templ) {
+        const amxd_object_t* const onu = amxc_container_of(onu_it, amxd_object_t, it);
+        const amxd_object_t* const ani_templ = amxd_object_get_child(onu, "ANI");
+        if(NULL == ani_templ) {
+            continue;
+        }
+        amxd_object_iterate(instance, ani_it, ani_templ) {
+            const amxd_object_t* const ani = amxc_container_of(ani_it, amxd_object_t, it);
+            const amxd_object_t* const trx_templ = amxd_object_get_child(ani, "Transceiver");
+            if(NULL == trx_templ) {
+                continue;
+            }
+            amxd_object_iterate(instance, trx_it, trx_templ) {
+                sample_trx(amxc_container_of(trx_it, amxd_object_t, it), now, async);
+                when_true(s_disabled, exit);
+            }
+        }
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Start, restart or stop the sampler.
+ *
+ * The sampler runs at 'trx_sample_interval_ms' if that's not 0. Else it runs
+ * at TRX_ALARM_SAMPLE_INTERVAL_MS if the thresholds are enabled. It never runs
+ * if the vendor module can not return all volatile params at once.
+ */
+static void update_sampler(void) {
+
+    uint32_t interval = s_sample_interval_ms;
+    if((0 == interval) && trx_alarm_is_enabled()) {
+        interval = TRX_ALARM_SAMPLE_INTERVAL_MS;
+    }
+    if(s_disabled || (0 == interval)) {
+        if(s_sample_timer) {
+            amxp_timer_stop(s_sample_timer);
+        }
+        goto exit;
+    }
+    if(NULL == s_sample_timer) {
+        when_failed_trace(amxp_timer_new(&s_sample_timer, sample_timer_expired, NULL),
+                          exit, ERROR, "Failed to create sample timer");
+    } else if((interval == s_sampler_interval_ms) &&
+              (amxp_timer_get_state(s_sample_timer) != amxp_timer_off)) {
+        goto exit;
+    }
+    SAH_TRACEZ_INFO(ME, "Sample Transceiver instances every %d ms", interval);
+    s_sampler_interval_ms = interval;
+    amxp_timer_set_interval(s_sample_timer, interval);
+    amxp_timer_start(s_sample_timer, interval);
+
+exit:
+    return;
+}
+
+/**
+ * Initialize the cache and start the sampler if it's enabled.
+ *
+ * The function reads the TTL, the sample interval and the window size from
+ * the config section of the odl files.
+ */
+void trx_cache_init(void) {
+
+    amxo_parser_t* const parser = xpon_mngr_get_parser();
+    when_null(parser, exit);
+
+    const amxc_var_t* const ttl = GET_ARG(&parser->config, TRX_CACHE_TTL_CONFIG);
+    if(ttl) {
+        s_ttl_ms = amxc_var_dyncast(uint32_t, ttl);
+    }
+    const amxc_var_t* const interval = GET_ARG(&parser->config, TRX_SAMPLE_INTERVAL_CONFIG);
+    if(interval) {
+        s_sample_interval_ms = amxc_var_dyncast(uint32_t, interval);
+    }
+    const amxc_var_t* const window = GET_ARG(&parser->config, TRX_SAMPLE_WINDOW_CONFIG);
+    if(window) {
+        s_window = amxc_var_dyncast(uint32_t, window);
+    }
+    if((0 == s_window) || (s_window > TRX_SAMPLE_WINDOW_MAX)) {
+        SAH_TRACEZ_ERROR(ME, "Invalid %s [%d]: use %d", TRX_SAMPLE_WINDOW_CONFIG,
+                         s_window, TRX_SAMPLE_WINDOW_DEFAULT);
+        s_window = TRX_SAMPLE_WINDOW_DEFAULT;
+    }
+    SAH_TRACEZ_INFO(ME, "%s=%d %s=%d %s=%d", TRX_CACHE_TTL_CONFIG, s_ttl_ms,
+                    TRX_SAMPLE_INTERVAL_CONFIG, s_sample_interval_ms,
+                    TRX_SAMPLE_WINDOW_CONFIG, s_window);
+
+    update_sampler();
+
+exit:
+    return;
+}
+
+/**
+ * Start or stop the sampler after XPON.TransceiverThresholds changed.
+ *
+ * tr181-xpon calls this function after trx_alarm_thresholds_changed().
+ */
+void trx_cache_thresholds_changed(void) {
+    update_sampler();
+}
+
+void trx_cache_cleanup(void) {
+    amxp_timer_delete(&s_sample_timer);
+}
+
+/**
+ * Get the value of a volatile parameter of a Transceiver from the cache.
+ *
+ * @param[in] object: Transceiver instance
+ * @param[in] path: path of @a object
+ * @param[in] name: name of the parameter
+ * @param[in,out] value: the function assigns the value to this parameter
+ *
+ * If the sampler is enabled, the function returns the value of the latest
+ * sample. Else, if the snapshot of @a object is older than the TTL, the
+ * function first takes a new snapshot. If the vendor module supports
+ * get_param_values_async(), the function returns the value of the old
+ * snapshot instead, and refreshes the snapshot in the background.
+ *
+ * If the vendor module fails to return all volatile parameters at once, the
+ * function queries @a name on its own. See query_single_name().
+ *
+ * @return true on success, false if the cache is disabled or if the function
+ *         fails to get the value. Then the caller should query the value of
+ *         the parameter in the vendor module itself.
+ */
+bool trx_cache_get_value(amxd_object_t* const object, const char* const path,
+                         const char* const name, amxc_var_t* const value) {
+
+    bool rv = false;
+    when_true(s_disabled, exit);
+    when_true((0 == s_ttl_ms) && (0 == s_sample_interval_ms), exit);
+
+    trx_snapshot_t* const snapshot = get_snapshot(object);
+    when_null(snapshot, exit);
+
+    const uint64_t now = time_get_monotonic_ms();
+    const amxc_var_t* cached = GET_ARG(&snapshot->values, name);
+    const bool fresh = ((s_sample_interval_ms != 0) && (snapshot->count != 0)) ||
+        ((now - snapshot->timestamp) < s_ttl_ms);
+    if(cached && !fresh && pon_ctrl_has_get_param_values_async()) {
+        /* Serve the old value while the vendor module refreshes it. The read
+         * is served from the cache: it's a hit, even if it starts a query. */
+        refresh_async(path, snapshot, now);
+        ++s_nr_of_hits;
+    } else if(cached && fresh) {
+        ++s_nr_of_hits;
+    } else {
+        ++s_nr_of_misses;
+        cached = take_snapshot(object, path, snapshot, now) ?
+            GET_ARG(&snapshot->values, name) : NULL;
+        if(NULL == cached) {
+            rv = query_single_name(path, name, value);
+            if(rv) {
+                trx_cache_evaluate_value(object, name, value);
+            }
+            goto exit;
+        }
+    }
+    when_failed_trace(amxc_var_copy(value, cached), exit, ERROR,
+                      "Failed to copy value for %s.%s", path, name);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Evaluate the thresholds for a value queried without the cache.
+ *
+ * @param[in] object: Transceiver instance
+ * @param[in] name: name of a volatile parameter
+ * @param[in] value: value of the parameter the vendor module returned
+ *
+ * tr181-xpon calls this function if it queried a volatile parameter in the
+ * vendor module itself, e.g., because the cache is disabled.
+ */
+void trx_cache_evaluate_value(amxd_object_t* const object, const char* const name,
+                              const amxc_var_t* const value) {
+
+    const int i = get_param_index(name);
+    when_true(i < 0, exit);
+    trx_snapshot_t* const snapshot = get_snapshot(object);
+    when_null(snapshot, exit);
+    trx_alarm_evaluate(object, name, amxc_var_dyncast(int64_t, value),
+                       &snapshot->levels[i]);
+
+exit:
+    return;
+}
+
+/**
+ * Store the answer of the vendor module to get_param_values_async().
+ *
+ * @param[in] args: htable with the keys 'path' and 'parameters'
+ *
+ * @return 0 on success, else -1
+ */
+int trx_cache_values_ready(const amxc_var_t* const args) {
+
+    int rc = -1;
+    const char* const path = GET_CHAR(args, "path");
+    const amxc_var_t* const params = GET_ARG(args, "parameters");
+    when_null_trace(path, exit, ERROR, "No 'path'");
+    when_null_trace(params, exit, ERROR, "No 'parameters' for %s", path);
+    when_false_trace(amxc_var_type_of(params) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "Type of 'parameters' for %s = %d != htable", path,
+                     amxc_var_type_of(params));
+    when_false_trace(dm_classify_path(path, NULL) == obj_id_transceiver, exit, ERROR,
+                     "%s is not a Transceiver instance", path);
+
+    /* The instance might be deleted since the query started */
+    amxd_object_t* const trx = amxd_dm_findf(xpon_mngr_get_dm(), "%s", path);
+    when_null_trace(trx, exit, WARNING, "%s does not exist", path);
+    trx_snapshot_t* const snapshot = get_snapshot(trx);
+    when_null(snapshot, exit);
+
+    when_failed_trace(amxc_var_copy(&snapshot->values, params), exit, ERROR,
+                      "Failed to store snapshot of %s", path);
+    snapshot->timestamp = time_get_monotonic_ms();
+    snapshot->query_started = 0;
+    evaluate_alarms(trx, snapshot);
+    if(snapshot->sample_pending) {
+        snapshot->sample_pending = false;
+        add_sample(path, snapshot);
+    }
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Get the min, max or average of a volatile parameter over the sample window.
+ *
+ * @param[in] object: Transceiver instance
+ * @param[in] name: name of the statistic: name of a volatile parameter
+ *                  followed by "Min", "Max" or "Avg", e.g. "RxPowerAvg".
+ * @param[in,out] value: the function assigns the value to this parameter. It
+ *                       leaves it untouched if there are no samples.
+ *
+ * @return true on success, else false
+ */
+bool trx_cache_get_window_value(amxd_object_t* const object, const char* const name,
+                                amxc_var_t* const value) {
+
+    bool rv = false;
+    uint32_t i;
+    uint32_t param = 0;
+    size_t len = 0;
+    int64_t result = 0;
+
+    for(param = 0; param < NR_OF_TRX_PARAMS; ++param) {
+        len = strlen(TRX_PARAMS[param].name);
+        if(strncmp(name, TRX_PARAMS[param].name, len) == 0) {
+            break;
+        }
+    }
+    when_true_trace(NR_OF_TRX_PARAMS == param, exit, ERROR, "Unknown param: %s", name);
+
+    const trx_snapshot_t* const snapshot = (const trx_snapshot_t*) object->priv;
+    if((NULL == snapshot) || (0 == snapshot->count)) {
+        rv = true;
+        goto exit;
+    }
+
+    const char* const stat = name + len;
+    const trx_sample_t* const samples = snapshot->samples;
+    result = samples[0].values[param];
+    if(strcmp(stat, "Min") == 0) {
+        for(i = 1; i < snapshot->count; ++i) {
+            if(samples[i].values[param] < result) {
+                result = samples[i].values[param];
+            }
+        }
+    } else if(strcmp(stat, "Max") == 0) {
+        for(i = 1; i < snapshot->count; ++i) {
+            if(samples[i].values[param] > result) {
+                result = samples[i].values[param];
+            }
+        }
+    } else if(strcmp(stat, "Avg") == 0) {
+        for(i = 1; i < snapshot->count; ++i) {
+            result += samples[i].values[param];
+        }
+        result /= (int64_t) snapshot->count;
+    } else {
+        SAH_TRACEZ_ERROR(ME, "Unknown param: %s", name);
+        goto exit;
+    }
+
+    if(TRX_PARAMS[param].is_signed) {
+        amxc_var_set(int32_t, value, (int32_t) result);
+    } else {
+        amxc_var_set(uint32_t, value, (uint32_t) result);
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Delete the snapshot attached to a Transceiver instance.
+ *
+ * tr181-xpon calls this function if a Transceiver instance is destroyed.
+ */
+void trx_cache_delete_snapshot(trx_snapshot_t* snapshot) {
+    if(snapshot) {
+        amxc_var_clean(&snapshot->values);
+        free(snapshot->samples);
+        free(snapshot);
+    }
+}
+
+uint64_t trx_cache_get_nr_of_hits(void) {
+    return s_nr_of_hits;
+}
+
+uint64_t trx_cache_get_nr_of_misses(void) {
+    return s_nr_of_misses;
+}
@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/* Related header */
+#include "utils_bitmap.h"
+
+/* System headers */
+#include <stdlib.h> /* calloc() */
+
+/* Own headers */
+#include "xpon_trace.h"
+
+#define BITS_PER_WORD 64
+
+static uint32_t nr_of_words(uint32_t nr_of_bits) {
+    return (nr_of_bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+/**
+ * Initialize a bitmap with all bits cleared.
+ *
+ * @param[in,out] bitmap: the bitmap
+ * @param[in] nr_of_bits: number of bits in the bitmap
+ *
+ * @return true on success, else false
+ */
+bool bitmap_init(bitmap_t* const bitmap, uint32_t nr_of_bits) {
+
+    bool rv = false;
+    bitmap->nr_of_bits = 0;
+    bitmap->nr_of_set_bits = 0;
+    bitmap->words = (uint64_t*) calloc(nr_of_words(nr_of_bits), sizeof(uint64_t));
+    when_null_trace(bitmap->words, exit, ERROR, "Failed to allocate bitmap of %d bits",
+                    nr_of_bits);
+    bitmap->nr_of_bits = nr_of_bits;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+void bitmap_clean(bitmap_t* const bitmap) {
+    free(bitmap->words);
+    bitmap->words = NULL;
+    bitmap->nr_of_bits = 0;
+    bitmap->nr_of_set_bits = 0;
+}
+
+/**
+ * Set a bit.
+ *
+ * @return true if the bit was not set yet, false if it was already set or if
+ *         @a bit is out of range
+ */
+bool bitmap_set(bitmap_t* const bitmap, uint32_t bit) {
+
+    bool rv = false;
+    when_true(bit >= bitmap->nr_of_bits, exit);
+
+    const uint64_t mask = UINT64_C(1) << (bit % BITS_PER_WORD);
+    uint64_t* const word = &bitmap->words[bit / BITS_PER_WORD];
+    when_true((*word & mask) != 0, exit);
+    *word |= mask;
+    ++bitmap->nr_of_set_bits;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Clear a bit.
+ *
+ * @return true if the bit was set, false if it was not set or if @a bit is
+ *         out of range
+ */
+bool bitmap_clear(bitmap_t* const bitmap, uint32_t bit) {
+
+    bool rv = false;
+    when_true(bit >= bitmap->nr_of_bits, exit);
+
+    const uint64_t mask = UINT64_C(1) << (bit % BITS_PER_WORD);
+    uint64_t* const word = &bitmap->words[bit / BITS_PER_WORD];
+    when_true((*word & mask) == 0, exit);
+    *word &= ~mask;
+    --bitmap->nr_of_set_bits;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+bool bitmap_is_set(const bitmap_t* const bitmap, uint32_t bit) {
+    if(bit >= bitmap->nr_of_bits) {
+        return false;
+    }
+    return (bitmap->words[bit / BITS_PER_WORD] & (UINT64_C(1) << (bit % BITS_PER_WORD))) != 0;
+}
+
+/**
+ * Return the number of set bits. This does not scan the bitmap.
+ */
+uint32_t bitmap_count(const bitmap_t* const bitmap) {
+    return bitmap->nr_of_set_bits;
+}
+
+/**
+ * Return the 1st set bit starting from @a from, or the number of bits in the
+ * bitmap if there is none.
+ *
+ * The function skips a word of 64 bits at once if none of its bits is set.
+ */
+uint32_t bitmap_next_set(const bitmap_t* const bitmap, uint32_t from) {
+
+    uint32_t bit = from;
+    while(bit < bitmap->nr_of_bits) {
+        const uint64_t word = bitmap->words[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD);
+        if(word != 0) {
+            bit += (uint32_t) __builtin_ctzll(word);
+            break;
+        }
+        bit = (bit / BITS_PER_WORD + 1) * BITS_PER_WORD;
+    }
+    return (bit < bitmap->nr_of_bits) ? bit : bitmap->nr_of_bits;
+}
@@ -60,15 +60,33 @@
 **
 ****************************************************************************/
 
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * 'CLOCK_MONOTONIC' undeclared
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 /* Related header */
 #include "utils_time.h"
 
 /* System headers */
+#include <stdbool.h>
 #include <sys/sysinfo.h> /* sysinfo() */
+#include <time.h>        /* clock_gettime() */
 
 /* Other libraries' headers */
+#include <amxc/amxc_macros.h> /* UNUSED */
+#include <amxp/amxp.h>        /* amxp_sigmngr_deferred_call() */
+
+/* Own headers */
 #include "xpon_trace.h"  /* when_failed_trace() */
 
+/** Value returned by time_get_cached_monotonic_ms() */
+static uint64_t s_cached_ms = 0;
+static bool s_cached_ms_valid = false;
+
 /**
  * Return the uptime, i.e. the number of seconds since startup.
  */
@@ -82,3 +100,56 @@ exit:
 
 }
 
+/**
+ * Return the time in ms of the monotonic clock.
+ *
+ * Only intended to measure durations: the start value is not defined.
+ */
+uint64_t time_get_monotonic_ms(void) {
+    struct timespec ts;
+    if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to get monotonic time");
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec * 1000) + ((uint64_t) ts.tv_nsec / 1000000);
+}
+
+/**
+ * Return the monotonic time in microseconds.
+ *
+ * Meant to measure short durations, e.g. the latency of a call to the vendor
+ * module. See call_stats.c.
+ */
+uint64_t time_get_monotonic_us(void) {
+    struct timespec ts;
+    if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to get monotonic time");
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec * 1000000) + ((uint64_t) ts.tv_nsec / 1000);
+}
+
+static void invalidate_cached_ms(UNUSED const amxc_var_t* const data,
+                                 UNUSED void* const priv) {
+    s_cached_ms_valid = false;
+}
+
+/**
+ * Return the time in ms of the monotonic clock, read once per iteration of
+ * the event loop.
+ *
+ * The 1st call in an iteration of the event loop reads the clock. It also
+ * schedules a deferred call to invalidate the value. That call runs at the
+ * next iteration. Other calls in the same iteration return the same value
+ * without a syscall. Hence use it for timestamps which are taken often, and
+ * for which the time spent in one iteration does not matter.
+ */
+uint64_t time_get_cached_monotonic_ms(void) {
+    if(!s_cached_ms_valid) {
+        s_cached_ms = time_get_monotonic_ms();
+        if(amxp_sigmngr_deferred_call(NULL, invalidate_cached_ms, NULL, NULL) == 0) {
+            s_cached_ms_valid = true;
+        }
+    }
+    return s_cached_ms;
+}
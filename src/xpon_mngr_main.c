@@ -60,19 +60,34 @@
 **
 ****************************************************************************/
 
-#include "dm_info.h"             /* dm_info_init() */
+#include "ani_pm.h"              /* ani_pm_cleanup() */
+#include "call_stats.h"          /* call_stats_cleanup() */
+#include "capture.h"             /* capture_init(), capture_cleanup() */
+#include "dm_coalesce.h"         /* dm_coalesce_init() */
+#include "dm_info.h"             /* dm_info_init(), dm_info_set_update_policies() */
+#include "dm_snapshot.h"         /* dm_snapshot_init() */
 #include "dm_xpon_mngr.h"
 #include "module_mgmt.h"         /* mod_module_mgmt_init() */
+#include "object_intf_priv.h"    /* oipriv_init() */
 #include "persistency.h"         /* persistency_init() */
-#include "pon_ctrl.h"            /* pon_ctrl_init() */
+#include "pon_ctrl.h"            /* pon_ctrl_init(), pon_ctrl_cleanup() */
 #include "populate_dm_startup.h" /* pplt_dm_init() */
 #include "restore_to_hal.h"      /* rth_init() */
+#include "trx_cache.h"           /* trx_cache_init() */
 #include "upgrade_persistency.h" /* upgr_persistency_init() */
 #include "xpon_trace.h"
 
+/**
+ * Config option with the max number of ONUs on the board. If it's missing or
+ * 0, the plugin uses MAX_NR_OF_ONUS, which is set at compile time by
+ * CONFIG_SAH_AMX_TR181_XPON_MAX_ONUS.
+ */
+#define MAX_NR_OF_ONUS_CONFIG "max_nr_of_onus"
+
 typedef struct _xpon_mngr {
     amxd_dm_t* dm;
     amxo_parser_t* parser;
+    uint32_t max_nr_of_onus;
 } xpon_mngr_t;
 
 
@@ -90,12 +105,33 @@ amxo_parser_t* PRIVATE xpon_mngr_get_parser(void) {
     return s_app.parser;
 }
 
+uint32_t PRIVATE xpon_mngr_get_max_nr_of_onus(void) {
+    return s_app.max_nr_of_onus;
+}
+
+static void init_max_nr_of_onus(void) {
+    s_app.max_nr_of_onus = GET_UINT32(&s_app.parser->config, MAX_NR_OF_ONUS_CONFIG);
+    if(0 == s_app.max_nr_of_onus) {
+        s_app.max_nr_of_onus = MAX_NR_OF_ONUS;
+    }
+    SAH_TRACEZ_INFO(ME, "%s=%d", MAX_NR_OF_ONUS_CONFIG, s_app.max_nr_of_onus);
+}
+
 static void do_cleanup(void) {
+    /* Write the buffered updates to the DM before the snapshot is saved */
+    dm_coalesce_flush_all();
+    dm_snapshot_cleanup();
     pplt_dm_cleanup();
     rth_cleanup();
+    pon_ctrl_cleanup();
     mod_module_mgmt_cleanup();
+    capture_cleanup();
     persistency_cleanup();
     upgr_persistency_cleanup();
+    dm_coalesce_cleanup();
+    trx_cache_cleanup();
+    ani_pm_cleanup();
+    call_stats_cleanup();
 }
 
 int _xpon_mngr_main(int reason,
@@ -112,13 +148,20 @@ int _xpon_mngr_main(int reason,
     case 0:     // START
         s_app.dm = dm;
         s_app.parser = parser;
+        init_max_nr_of_onus();
 
         if(!dm_info_init()) {
             return -1;
         }
+        dm_info_sync_param_types(dm);
+        dm_info_set_update_policies(GET_ARG(&parser->config, "update_policy"));
+        dm_coalesce_init();
+        trx_cache_init();
+        oipriv_init();
         persistency_init();
         upgr_persistency_init();
         rth_init();
+        capture_init();
         if(!mod_module_mgmt_init(&module_error)) {
             if(module_error) {
                 /**
@@ -131,6 +174,8 @@ int _xpon_mngr_main(int reason,
             break;
         }
         pon_ctrl_init();
+        dm_snapshot_init();
+        dm_snapshot_load();
         if(!pplt_dm_init()) {
             break;
         }